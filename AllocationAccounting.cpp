@@ -0,0 +1,270 @@
+#include "AllocationAccounting.h"
+#include "DiagnosticCounters.h"
+#include "Opcodes.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace UF
+{
+
+namespace
+{
+    uint32 const TableSize = 4096;          // power of two, distinct (opcode, struct, site) keys per thread
+
+    struct SiteCounters
+    {
+        uint32 Opcode;
+        UpdateFieldStruct Struct;
+        char const* Site;
+        std::atomic<bool> Used;
+        std::atomic<uint64> Count;
+        std::atomic<uint64> Bytes;
+    };
+
+    /// Allocated with calloc, accounting runs inside operator new and must not allocate through it.
+    /// Never freed, see DiagnosticCounters.h.
+    struct ThreadCounters
+    {
+        SiteCounters Sites[TableSize];
+        SiteCounters Overflow;              // keys that didn't fit in the table
+        std::atomic<uint64> Count;
+        std::atomic<uint64> Bytes;
+        ThreadCounters* Next;
+    };
+
+    std::atomic<ThreadCounters*> Threads(nullptr);
+
+    ThreadCounters* GetThreadCounters()
+    {
+        static thread_local ThreadCounters* counters = nullptr;
+        if (!counters)
+        {
+            counters = static_cast<ThreadCounters*>(std::calloc(1, sizeof(ThreadCounters)));
+            if (!counters)
+                return nullptr;
+            counters->Overflow.Opcode = ALLOCATION_NO_OPCODE;
+            counters->Overflow.Struct = UpdateFieldStruct::Max;
+            counters->Overflow.Used = true;
+            counters->Next = Threads.load(std::memory_order_relaxed);
+            while (!Threads.compare_exchange_weak(counters->Next, counters, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+        return counters;
+    }
+
+    SiteCounters& FindSite(ThreadCounters& thread, AllocationAccounting::Context const& context)
+    {
+        uint64 key = uint64(reinterpret_cast<uintptr_t>(context.Site)) ^ (uint64(context.Opcode) << 8) ^ uint64(context.Struct);
+        key *= 0x9E3779B97F4A7C15ull;
+        uint32 index = uint32(key >> 52) & (TableSize - 1);
+        for (uint32 probe = 0; probe < 16; ++probe, index = (index + 1) & (TableSize - 1))
+        {
+            SiteCounters& site = thread.Sites[index];
+            if (!site.Used.load(std::memory_order_relaxed))
+            {
+                site.Opcode = context.Opcode;
+                site.Struct = context.Struct;
+                site.Site = context.Site;
+                site.Used.store(true, std::memory_order_release);
+                return site;
+            }
+            if (site.Opcode == context.Opcode && site.Struct == context.Struct && site.Site == context.Site)
+                return site;
+        }
+        return thread.Overflow;
+    }
+}
+
+AllocationAccounting::Context& AllocationAccounting::Current()
+{
+    static thread_local Context context;
+    return context;
+}
+
+void AllocationAccounting::Record(std::size_t bytes)
+{
+    ThreadCounters* thread = GetThreadCounters();
+    if (!thread)
+        return;
+
+    SiteCounters& site = FindSite(*thread, Current());
+    AddOwnedCounter(site.Count, 1);
+    AddOwnedCounter(site.Bytes, bytes);
+    AddOwnedCounter(thread->Count, 1);
+    AddOwnedCounter(thread->Bytes, bytes);
+}
+
+AllocationAccounting::Totals AllocationAccounting::GetTotals()
+{
+    Totals totals;
+    for (ThreadCounters* thread = Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+    {
+        totals.Count += thread->Count.load(std::memory_order_relaxed);
+        totals.Bytes += thread->Bytes.load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+AllocationAccounting::Totals AllocationAccounting::GetThreadTotals()
+{
+    Totals totals;
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+    if (ThreadCounters* thread = GetThreadCounters())
+    {
+        totals.Count = thread->Count.load(std::memory_order_relaxed);
+        totals.Bytes = thread->Bytes.load(std::memory_order_relaxed);
+    }
+#endif
+    return totals;
+}
+
+std::vector<AllocationAccounting::Site> AllocationAccounting::GetTopSites(uint32 count)
+{
+    std::vector<Site> sites;
+    auto merge = [&sites](SiteCounters const& counters)
+    {
+        uint64 allocations = counters.Count.load(std::memory_order_relaxed);
+        if (!allocations)
+            return;
+
+        for (Site& site : sites)
+        {
+            if (site.Opcode == counters.Opcode && site.Struct == counters.Struct && site.Name == counters.Site)
+            {
+                site.Count += allocations;
+                site.Bytes += counters.Bytes.load(std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        Site site;
+        site.Opcode = counters.Opcode;
+        site.Struct = counters.Struct;
+        site.Name = counters.Site;
+        site.Count = allocations;
+        site.Bytes = counters.Bytes.load(std::memory_order_relaxed);
+        sites.push_back(site);
+    };
+
+    for (ThreadCounters* thread = Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+    {
+        for (SiteCounters const& counters : thread->Sites)
+            if (counters.Used.load(std::memory_order_acquire))
+                merge(counters);
+        merge(thread->Overflow);
+    }
+
+    std::sort(sites.begin(), sites.end(), [](Site const& left, Site const& right) { return left.Bytes > right.Bytes; });
+    if (sites.size() > count)
+        sites.resize(count);
+    return sites;
+}
+
+std::string AllocationAccounting::Dump(uint32 count)
+{
+    std::string dump;
+    for (Site const& site : GetTopSites(count))
+    {
+        std::string opcode = site.Opcode == ALLOCATION_NO_OPCODE ? "no opcode" : GetOpcodeNameForLogging(OpcodeServer(site.Opcode));
+        char line[256];
+        snprintf(line, sizeof(line), "%s %s %s: %s allocations, %s bytes\n", opcode.c_str(),
+            site.Struct < UpdateFieldStruct::Max ? GetUpdateFieldStructName(site.Struct) : "no struct",
+            site.Name ? site.Name : "other", FormatCount(site.Count).c_str(), FormatCount(site.Bytes).c_str());
+        dump += line;
+    }
+    return dump;
+}
+
+void AllocationAccounting::Reset()
+{
+    for (ThreadCounters* thread = Threads.load(std::memory_order_acquire); thread; thread = thread->Next)
+    {
+        for (SiteCounters& counters : thread->Sites)
+        {
+            counters.Count = 0;
+            counters.Bytes = 0;
+        }
+        thread->Overflow.Count = 0;
+        thread->Overflow.Bytes = 0;
+        thread->Count = 0;
+        thread->Bytes = 0;
+    }
+}
+
+}
+
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+// Replaces the global allocation functions of the whole binary. Aligned (std::align_val_t) overloads are left
+// to the runtime, none of the decoders allocate over-aligned types.
+
+void* operator new(std::size_t size)
+{
+    UF::AllocationAccounting::Record(size);
+    for (;;)
+    {
+        if (void* block = std::malloc(size ? size : 1))
+            return block;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return ::operator new(size);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::nothrow_t const&) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::nothrow_t const&) noexcept
+{
+    std::free(block);
+}
+#endif
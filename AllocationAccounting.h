@@ -0,0 +1,148 @@
+#ifndef _ALLOCATIONACCOUNTING_H
+#define _ALLOCATIONACCOUNTING_H
+
+#include "Define.h"
+#include "UpdateFieldSink.h"
+#include <string>
+#include <vector>
+
+namespace UF
+{
+
+uint32 const ALLOCATION_NO_OPCODE = 0xFFFFFFFF;
+
+/// Heap allocations attributed to the opcode, top level struct and decode site the thread was working on.
+/// Builds with UF_WITH_ALLOC_ACCOUNTING replace the global operator new to count every allocation against
+/// the current context; otherwise the scopes below are empty and all counters stay 0.
+/// Only allocations are counted, frees can't be attributed without a header on every block.
+class AllocationAccounting
+{
+public:
+    struct Context
+    {
+        uint32 Opcode = ALLOCATION_NO_OPCODE;
+        UpdateFieldStruct Struct = UpdateFieldStruct::Max;
+        char const* Site = nullptr;         // string literal naming the container being grown
+    };
+
+    struct Totals
+    {
+        uint64 Count = 0;
+        uint64 Bytes = 0;
+    };
+
+    struct Site
+    {
+        uint32 Opcode = ALLOCATION_NO_OPCODE;
+        UpdateFieldStruct Struct = UpdateFieldStruct::Max;
+        char const* Name = nullptr;
+        uint64 Count = 0;
+        uint64 Bytes = 0;
+    };
+
+    static bool IsEnabled()
+    {
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static Context& Current();
+
+    /// Called by the replacement operator new.
+    static void Record(std::size_t bytes);
+
+    /// Allocations of all threads.
+    static Totals GetTotals();
+
+    /// Allocations of the calling thread, for per packet deltas around a handler.
+    static Totals GetThreadTotals();
+
+    /// The 'count' sites with the most allocated bytes, merged over all threads.
+    static std::vector<Site> GetTopSites(uint32 count);
+
+    /// One line per site, e.g. "SMSG_UPDATE_OBJECT ItemData BonusListIDs: 1.2K allocations, 38.4K bytes".
+    static std::string Dump(uint32 count = 20);
+
+    /// Clears the counters of all threads. Allocations made concurrently may be partially kept.
+    static void Reset();
+};
+
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+/// Attributes allocations to 'opcode' until the scope ends, used around packet handlers.
+class AllocationOpcodeScope
+{
+public:
+    explicit AllocationOpcodeScope(uint32 opcode) : _previous(AllocationAccounting::Current().Opcode)
+    {
+        AllocationAccounting::Current().Opcode = opcode;
+    }
+
+    ~AllocationOpcodeScope() { AllocationAccounting::Current().Opcode = _previous; }
+
+    AllocationOpcodeScope(AllocationOpcodeScope const&) = delete;
+    AllocationOpcodeScope& operator=(AllocationOpcodeScope const&) = delete;
+
+private:
+    uint32 _previous;
+};
+
+/// Attributes allocations to a top level struct until the scope ends, held by StructDecodeMark.
+class AllocationStructScope
+{
+public:
+    explicit AllocationStructScope(UpdateFieldStruct type) : _previous(AllocationAccounting::Current())
+    {
+        AllocationAccounting::Current().Struct = type;
+        AllocationAccounting::Current().Site = nullptr;
+    }
+
+    ~AllocationStructScope()
+    {
+        AllocationAccounting::Current().Struct = _previous.Struct;
+        AllocationAccounting::Current().Site = _previous.Site;
+    }
+
+    AllocationStructScope(AllocationStructScope const&) = delete;
+    AllocationStructScope& operator=(AllocationStructScope const&) = delete;
+
+private:
+    AllocationAccounting::Context _previous;
+};
+
+/// Attributes allocations to a named site inside a decoder until the scope ends.
+class AllocationSiteScope
+{
+public:
+    explicit AllocationSiteScope(char const* site) : _previous(AllocationAccounting::Current().Site)
+    {
+        AllocationAccounting::Current().Site = site;
+    }
+
+    ~AllocationSiteScope() { AllocationAccounting::Current().Site = _previous; }
+
+    AllocationSiteScope(AllocationSiteScope const&) = delete;
+    AllocationSiteScope& operator=(AllocationSiteScope const&) = delete;
+
+private:
+    char const* _previous;
+};
+
+#define UF_ALLOCATION_SITE_NAME2(line) ufAllocationSite##line
+#define UF_ALLOCATION_SITE_NAME(line) UF_ALLOCATION_SITE_NAME2(line)
+#define UF_ALLOCATION_SITE(site) UF::AllocationSiteScope UF_ALLOCATION_SITE_NAME(__LINE__)(site)
+#else
+class AllocationOpcodeScope
+{
+public:
+    explicit AllocationOpcodeScope(uint32 /*opcode*/) { }
+};
+
+#define UF_ALLOCATION_SITE(site) ((void)0)
+#endif
+
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef _BITREADER_H
+#define _BITREADER_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "DecodeTrace.h"
+#include "ReferenceDecode.h"
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace UF
+{
+
+/// Reads bit packed data of a ByteBuffer with 64-bit loads instead of one bit at a time.
+/// Bit order matches ByteBuffer::ReadBits (most significant bit first).
+/// The reader must start on a byte boundary, i.e. with no unread bits cached by the ByteBuffer
+/// (after ResetBits or plain byte reads). Call Sync or ResetBits before reading from the ByteBuffer again.
+/// In a reference decode (UF_WITH_DECODE_DIFF builds) every read is forwarded to ByteBuffer::ReadBits.
+class BitReader
+{
+public:
+    explicit BitReader(ByteBuffer& data) : _data(data), _bytes(data.contents()), _size(data.size()), _start(data.rpos()), _bitPos(0) { }
+
+    BitReader(BitReader const&) = delete;
+    BitReader& operator=(BitReader const&) = delete;
+
+    /// Reads up to 32 bits.
+    uint32 ReadBits(uint32 bits)
+    {
+        if (!bits)
+            return 0;
+#ifdef UF_WITH_DECODE_DIFF
+        if (_reference)
+            return _data.ReadBits(bits);
+#endif
+
+        std::size_t byte = _start + (_bitPos >> 3);
+        uint64 window = Load(byte, bits);
+        uint32 value = uint32((window << (_bitPos & 7)) >> (64 - bits));
+        _bitPos += bits;
+        return value;
+    }
+
+    bool ReadBit() { return ReadBits(1) != 0; }
+
+    /// Reads a 'count' bit presence header followed by one 32-bit mask block for every set presence bit.
+    /// Blocks without presence bit are zeroed. count must not exceed 32.
+    void ReadMaskBlocks(uint32 count, uint32* blocks)
+    {
+        uint32 presence = ReadBits(count);
+        ReadMaskBlocks(count, &presence, blocks);
+    }
+
+    /// Same as above for headers whose presence bits were already read (one bit per block, 32 per word).
+    void ReadMaskBlocks(uint32 count, uint32 const* presenceBits, uint32* blocks)
+    {
+        for (uint32 i = 0; i < count; ++i)
+            blocks[i] = 0;
+
+        for (uint32 word = 0; word * 32 < count; ++word)
+        {
+            uint32 presence = presenceBits[word];
+            while (presence)
+            {
+                uint32 bit = CountTrailingZeros(presence);
+                presence &= presence - 1;
+                uint32 index = word * 32 + bit;
+                if (index >= count)
+                    break;
+                blocks[index] = ReadBits(32);
+            }
+        }
+    }
+
+    std::size_t GetBitPos() const { return _bitPos; }
+
+    /// Leaves the ByteBuffer in the state it would have after reading the same bits with ReadBits,
+    /// including a partially consumed byte.
+    void Sync()
+    {
+#ifdef UF_WITH_DECODE_DIFF
+        if (_reference)
+            return;
+#endif
+        _data.rpos(_start + (_bitPos >> 3));
+        _data.ResetBits();
+        if (_bitPos & 7)
+            _data.ReadBits(uint32(_bitPos & 7));
+        Restart();
+    }
+
+    /// Equivalent to Sync followed by ByteBuffer::ResetBits.
+    /// With a DecodeTrace installed, the skipped rest of a partially read byte must be zero padding.
+    void ResetBits()
+    {
+#ifdef UF_WITH_DECODE_DIFF
+        if (_reference)
+        {
+            _data.ResetBits();
+            return;
+        }
+#endif
+        if ((_bitPos & 7) && DecodeTrace::Current())
+        {
+            std::size_t byte = _start + (_bitPos >> 3);
+            if (_bytes[byte] & ((1u << (8 - (_bitPos & 7))) - 1))
+                throw UpdateFieldDesyncException(UpdateFieldStruct::Max, DecodeTrace::CurrentBase() + byte, "non zero padding after bit packed data");
+        }
+        _data.rpos(_start + ((_bitPos + 7) >> 3));
+        _data.ResetBits();
+        Restart();
+    }
+
+private:
+    void Restart()
+    {
+        _start = _data.rpos();
+        _size = _data.size();
+        _bytes = _data.contents();
+        _bitPos = 0;
+    }
+
+    uint64 Load(std::size_t byte, uint32 bits) const
+    {
+        // a read never spans more than 5 bytes, so one big endian 64-bit window always covers it
+        if (byte + 8 <= _size)
+        {
+            uint64 window;
+            memcpy(&window, _bytes + byte, sizeof(window));
+            return ByteSwap(window);
+        }
+
+        std::size_t needed = ((_bitPos & 7) + bits + 7) >> 3;
+        if (byte + needed > _size)
+            throw ByteBufferPositionException(byte, needed, _size);
+
+        uint64 window = 0;
+        for (std::size_t i = 0; byte + i < _size && i < 8; ++i)
+            window |= uint64(_bytes[byte + i]) << (56 - 8 * i);
+        return window;
+    }
+
+    static uint64 ByteSwap(uint64 value)
+    {
+#if defined(_MSC_VER)
+        return _byteswap_uint64(value);
+#else
+        return __builtin_bswap64(value);
+#endif
+    }
+
+    static uint32 CountTrailingZeros(uint32 value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return uint32(index);
+#else
+        return uint32(__builtin_ctz(value));
+#endif
+    }
+
+    ByteBuffer& _data;
+    uint8 const* _bytes;
+    std::size_t _size;
+    std::size_t _start;
+    std::size_t _bitPos;
+#ifdef UF_WITH_DECODE_DIFF
+    bool _reference = IsReferenceDecode();
+#endif
+};
+
+}
+
+#endif
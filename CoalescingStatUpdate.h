@@ -0,0 +1,173 @@
+#ifndef _COALESCINGSTATUPDATE_H
+#define _COALESCINGSTATUPDATE_H
+
+#include "Define.h"
+#include "StatUpdateRecorder.h"
+#include <algorithm>
+#include <vector>
+
+namespace UF
+{
+
+class CoalescingStatUpdate;
+
+/// Opt-in coalescing of IStatUpdate callbacks over a packet or a tick.
+/// While enabled, repeated changes of one field of one object keep the first old value and the last new value,
+/// and a single callback is emitted by Flush. Objects are flushed in the order they first changed,
+/// fields of an object in the order they first changed. Changes that end on their starting value are dropped
+/// for callbacks whose old value is always the previous value of the field; the others pass 0 from ReadCreate.
+/// OnUnitDisplayId is fired with (0, 0) for several fields and is never merged, every call is delivered.
+class StatUpdateCoalescer
+{
+    friend class CoalescingStatUpdate;
+
+public:
+    StatUpdateCoalescer() : _enabled(false) { }
+
+    void SetEnabled(bool enabled)
+    {
+        if (!enabled)
+            Flush();
+        _enabled = enabled;
+    }
+
+    bool IsEnabled() const { return _enabled; }
+
+    /// Call at the end of each SMSG_UPDATE_OBJECT, SMSG_MULTIPLE_PACKETS bundle or tick.
+    void Flush();
+
+private:
+    void Enqueue(CoalescingStatUpdate* update) { _pending.push_back(update); }
+
+    void Remove(CoalescingStatUpdate* update)
+    {
+        _pending.erase(std::remove(_pending.begin(), _pending.end(), update), _pending.end());
+        std::replace(_flushing.begin(), _flushing.end(), update, static_cast<CoalescingStatUpdate*>(nullptr));
+    }
+
+    std::vector<CoalescingStatUpdate*> _pending;
+    std::vector<CoalescingStatUpdate*> _flushing;   // objects of the Flush in progress, destroyed ones are nulled
+    bool _enabled;
+};
+
+/// Per object listener in front of the real IStatUpdate of that object.
+class CoalescingStatUpdate : public StatUpdateForwarder
+{
+    friend class StatUpdateCoalescer;
+
+public:
+    CoalescingStatUpdate(StatUpdateCoalescer& coalescer, IStatUpdate* next) : StatUpdateForwarder(next), _coalescer(coalescer), _queued(false) { }
+
+    ~CoalescingStatUpdate()
+    {
+        if (_queued)
+            _coalescer.Remove(this);
+    }
+
+    CoalescingStatUpdate(CoalescingStatUpdate const&) = delete;
+    CoalescingStatUpdate& operator=(CoalescingStatUpdate const&) = delete;
+
+    void OnObjectDynamicFlags(uint32 old, uint32 value) override { Push(StatUpdateEvent::ObjectDynamicFlags, old, value); }
+    void OnUnitHealth(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitHealth, old, value); }
+    void OnUnitPower(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::UnitPower, old, value, index); }
+    void OnUnitLevel(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitLevel, old, value); }
+    void OnUnitFlags(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitFlags, old, value); }
+    void OnUnitDisplayId(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitDisplayId, old, value); }
+    void OnContainerSlots(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ContainerSlots, old, value, index); }
+    void OnPlayerQuestLogId(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::PlayerQuestLogId, old, value, index); }
+    void OnPlayerQuestLogCount(uint32 old, uint32 value, uint32 index, uint32 objective) override { Push(StatUpdateEvent::PlayerQuestLogCount, old, value, index, objective); }
+    void OnActivePlayerSkillLineId(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerSkillLineId, old, value, index); }
+    void OnActivePlayerCoinage(uint64 old, uint64 value) override { Push(StatUpdateEvent::ActivePlayerCoinage, old, value); }
+    void OnActivePlayerInvSlot(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerInvSlot, old, value, index); }
+    void OnActivePlayerQuestCompleted(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerQuestCompleted, old, value, index); }
+
+private:
+    void Push(StatUpdateEvent event, uint64 old, uint64 value, uint32 index = 0, uint32 subIndex = 0)
+    {
+        StatUpdateRecord record = { event, index, subIndex, old, value };
+        if (!_coalescer.IsEnabled())
+        {
+            if (GetNext())
+                StatUpdateRecorder::Dispatch(record, *GetNext());
+            return;
+        }
+
+        // an object rarely has more than a handful of changed fields per packet, a linear scan is enough
+        if (event != StatUpdateEvent::UnitDisplayId)
+        {
+            for (StatUpdateRecord& pending : _records)
+            {
+                if (pending.Event == event && pending.Index == index && pending.SubIndex == subIndex)
+                {
+                    pending.Value = value;
+                    return;
+                }
+            }
+        }
+
+        if (!_queued)
+        {
+            _coalescer.Enqueue(this);
+            _queued = true;
+        }
+        _records.push_back(record);
+    }
+
+    /// The old value passed by every decoder is the field's previous value, so old == value means no change.
+    static bool HasPreviousValue(StatUpdateEvent event)
+    {
+        switch (event)
+        {
+            case StatUpdateEvent::ObjectDynamicFlags:
+            case StatUpdateEvent::ContainerSlots:
+            case StatUpdateEvent::PlayerQuestLogId:
+            case StatUpdateEvent::PlayerQuestLogCount:
+            case StatUpdateEvent::ActivePlayerInvSlot:
+            case StatUpdateEvent::ActivePlayerQuestCompleted:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// Listeners may destroy this object, nothing of it is used after the first callback.
+    void Flush()
+    {
+        _queued = false;
+        std::vector<StatUpdateRecord> records;
+        records.swap(_records);
+        IStatUpdate* next = GetNext();
+        if (!next)
+            return;
+
+        for (StatUpdateRecord const& record : records)
+            if (record.Old != record.Value || !HasPreviousValue(record.Event))
+                StatUpdateRecorder::Dispatch(record, *next);
+    }
+
+    StatUpdateCoalescer& _coalescer;
+    std::vector<StatUpdateRecord> _records;
+    bool _queued;
+};
+
+inline void StatUpdateCoalescer::Flush()
+{
+    // a Flush called by a listener hands its objects to the one in progress
+    if (!_flushing.empty())
+    {
+        _flushing.insert(_flushing.end(), _pending.begin(), _pending.end());
+        _pending.clear();
+        return;
+    }
+
+    // listeners may change objects while being notified, anything they queue goes into the next round
+    _flushing.swap(_pending);
+    for (std::size_t i = 0; i < _flushing.size(); ++i)
+        if (CoalescingStatUpdate* update = _flushing[i])
+            update->Flush();
+    _flushing.clear();
+}
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "DecodeDiff.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+
+namespace UF
+{
+
+#ifdef UF_WITH_DECODE_DIFF
+bool& ReferenceDecodeFlag()
+{
+    static thread_local bool reference = false;
+    return reference;
+}
+
+bool& DifferentialDecodeFlag()
+{
+    static thread_local bool differential = false;
+    return differential;
+}
+#endif
+
+namespace
+{
+    std::mutex HandlerLock;
+    DecodeDiff::Handler DivergenceHandler;
+    std::atomic<uint64> Compared(0);
+    std::atomic<uint64> Diverged(0);
+
+    bool SameRecord(StatUpdateRecord const& left, StatUpdateRecord const& right)
+    {
+        return left.Event == right.Event && left.Index == right.Index && left.SubIndex == right.SubIndex
+            && left.Old == right.Old && left.Value == right.Value;
+    }
+}
+
+std::string DecodeDivergence::Describe() const
+{
+    std::ostringstream out;
+    out << "decoders diverge on object 0x" << std::hex << Guid._high << ':' << Guid._low << std::dec
+        << " (type " << uint32(ObjectTypeId) << "): ";
+    switch (What)
+    {
+        case None:
+            out << "none";
+            break;
+        case Exception:
+            out << "reference " << (ReferenceError.empty() ? "succeeded" : "threw '" + ReferenceError + "'")
+                << ", optimized " << (OptimizedError.empty() ? "succeeded" : "threw '" + OptimizedError + "'");
+            break;
+        case ReadOffset:
+            out << "reference read " << ReferenceRead << " bytes, optimized " << OptimizedRead;
+            break;
+        case Fields:
+            out << "decoded values differ at byte " << FieldByte << " of their creates";
+            break;
+        case Callbacks:
+            out << "callback " << CallbackIndex << " differs";
+            break;
+    }
+    return out.str();
+}
+
+void DecodeDiff::SetHandler(Handler handler)
+{
+    std::lock_guard<std::mutex> guard(HandlerLock);
+    DivergenceHandler = std::move(handler);
+}
+
+DecodeDiff::Stats DecodeDiff::GetStats()
+{
+    Stats stats;
+    stats.Compared = Compared.load();
+    stats.Diverged = Diverged.load();
+    return stats;
+}
+
+void DecodeDiff::ResetStats()
+{
+    Compared = 0;
+    Diverged = 0;
+}
+
+void DecodeDiff::Record(DecodeDivergence const& divergence)
+{
+    ++Compared;
+    if (divergence.What == DecodeDivergence::None)
+        return;
+
+    ++Diverged;
+    std::lock_guard<std::mutex> guard(HandlerLock);
+    if (DivergenceHandler)
+        DivergenceHandler(divergence);
+}
+
+DecodeDivergence DecodeDiff::Compare(std::size_t referenceRead, std::size_t optimizedRead,
+    std::string const& referenceError, std::string const& optimizedError,
+    ByteBuffer const& referenceFields, ByteBuffer const& optimizedFields,
+    StatUpdateRecorder const& referenceCallbacks, StatUpdateRecorder const& optimizedCallbacks)
+{
+    DecodeDivergence divergence;
+    divergence.ReferenceRead = referenceRead;
+    divergence.OptimizedRead = optimizedRead;
+    divergence.ReferenceError = referenceError;
+    divergence.OptimizedError = optimizedError;
+
+    // a block both paths reject the same way is a bad block, not a decoder difference
+    if (referenceError != optimizedError)
+    {
+        divergence.What = DecodeDivergence::Exception;
+        return divergence;
+    }
+
+    if (referenceError.empty() && referenceRead != optimizedRead)
+    {
+        divergence.What = DecodeDivergence::ReadOffset;
+        return divergence;
+    }
+
+    std::size_t fieldBytes = std::min(referenceFields.size(), optimizedFields.size());
+    for (std::size_t i = 0; i < fieldBytes; ++i)
+    {
+        if (referenceFields[i] != optimizedFields[i])
+        {
+            divergence.What = DecodeDivergence::Fields;
+            divergence.FieldByte = i;
+            return divergence;
+        }
+    }
+    if (referenceFields.size() != optimizedFields.size())
+    {
+        divergence.What = DecodeDivergence::Fields;
+        divergence.FieldByte = fieldBytes;
+        return divergence;
+    }
+
+    StatUpdateRecords const& reference = referenceCallbacks.GetRecords();
+    StatUpdateRecords const& optimized = optimizedCallbacks.GetRecords();
+    std::size_t callbacks = std::min(reference.size(), optimized.size());
+    for (std::size_t i = 0; i < callbacks; ++i)
+    {
+        if (!SameRecord(reference[i], optimized[i]))
+        {
+            divergence.What = DecodeDivergence::Callbacks;
+            divergence.CallbackIndex = i;
+            return divergence;
+        }
+    }
+    if (reference.size() != optimized.size())
+    {
+        divergence.What = DecodeDivergence::Callbacks;
+        divergence.CallbackIndex = callbacks;
+    }
+    return divergence;
+}
+
+}
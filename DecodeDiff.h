@@ -0,0 +1,177 @@
+#ifndef _DECODEDIFF_H
+#define _DECODEDIFF_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "DecodeTrace.h"
+#include "ReferenceDecode.h"
+#include "StatUpdateRecorder.h"
+#include "UpdateFieldSink.h"
+#include "UpdateFieldsWriter.h"
+#include <exception>
+#include <functional>
+#include <string>
+
+namespace UF
+{
+
+/// First difference between the reference and the optimized decode of one values block.
+struct DecodeDivergence
+{
+    enum Kind : uint8
+    {
+        None,
+        Exception,                      // only one of the decodes threw, or both with different messages
+        ReadOffset,                     // both finished but consumed a different number of bytes
+        Fields,                         // decoded values differ, FieldByte is the first differing byte of their creates
+        Callbacks                       // IStatUpdate callbacks differ, CallbackIndex is the first differing one
+    };
+
+    Kind What = None;
+    ObjectGuid Guid;
+    uint8 ObjectTypeId = 0;
+    std::size_t ReferenceRead = 0;      // bytes of the block consumed
+    std::size_t OptimizedRead = 0;
+    std::size_t FieldByte = 0;
+    std::size_t CallbackIndex = 0;
+    std::string ReferenceError;
+    std::string OptimizedError;
+
+    std::string Describe() const;
+};
+
+/// Result collection of the differential decode mode.
+/// Build with UF_WITH_DECODE_DIFF to have every top level ReadCreate/ReadUpdate of UpdateFields.cpp, and
+/// ReadActivePlayerCreatePartial, run through DecodeDifferential; the handler is called for every diverging
+/// struct, from the decoding thread.
+///
+/// What the comparison cannot see:
+/// - The reference decode only swaps BitReader, the packed guid helpers and the batched InvSlots read of the
+///   ActivePlayerData create for plain ByteBuffer reads. Everything else, the staged ActivePlayerData create
+///   state machine of ReadActivePlayerCreatePartial included, is the same code in both decodes, so a bug
+///   in it decodes identically twice.
+/// - Values are compared through the create encoders of UpdateFieldsWriter.h. Fields the decoders drop
+///   (unknowns, LogoutTime, ...) are encoded as 0; a wrong value there only shows when it changes the bytes
+///   consumed.
+class DecodeDiff
+{
+public:
+    typedef std::function<void(DecodeDivergence const&)> Handler;
+
+    struct Stats
+    {
+        uint64 Compared = 0;
+        uint64 Diverged = 0;
+    };
+
+    static void SetHandler(Handler handler);
+    static Stats GetStats();
+    static void ResetStats();
+
+    /// Reports 'divergence' unless it is None.
+    static void Record(DecodeDivergence const& divergence);
+
+    /// Compares the outcome of both decodes. 'referenceFields'/'optimizedFields' are the re-encoded creates
+    /// of the decoded structs.
+    static DecodeDivergence Compare(std::size_t referenceRead, std::size_t optimizedRead,
+        std::string const& referenceError, std::string const& optimizedError,
+        ByteBuffer const& referenceFields, ByteBuffer const& optimizedFields,
+        StatUpdateRecorder const& referenceCallbacks, StatUpdateRecorder const& optimizedCallbacks);
+};
+
+/// Full create of a decoded struct with every visibility flag, the canonical form compared by DecodeDiff.
+#define UF_ENCODE_FOR_DIFF(Fields) \
+    inline void EncodeForDiff(ByteBuffer& data, Fields const& fields) \
+    { \
+        WriteCreate(data, fields, UpdateFieldFlag::Owner | UpdateFieldFlag::PartyMember | UpdateFieldFlag::UnitAll | UpdateFieldFlag::Empath); \
+    }
+
+UF_ENCODE_FOR_DIFF(ObjectData)
+UF_ENCODE_FOR_DIFF(ItemData)
+UF_ENCODE_FOR_DIFF(ContainerData)
+UF_ENCODE_FOR_DIFF(UnitData)
+UF_ENCODE_FOR_DIFF(PlayerData)
+UF_ENCODE_FOR_DIFF(ActivePlayerData)
+UF_ENCODE_FOR_DIFF(GameObjectData)
+UF_ENCODE_FOR_DIFF(DynamicObjectData)
+UF_ENCODE_FOR_DIFF(CorpseData)
+UF_ENCODE_FOR_DIFF(AreaTriggerData)
+UF_ENCODE_FOR_DIFF(SceneObjectData)
+UF_ENCODE_FOR_DIFF(ConversationData)
+
+#undef UF_ENCODE_FOR_DIFF
+
+/// Decodes one struct of a values block with decode(data, fields, update).
+/// In UF_WITH_DECODE_DIFF builds the block is first decoded by the reference paths into a copy of 'fields',
+/// without sinks, DecodeTrace and DecodeProfiler, then by the optimized paths into 'fields' itself; outcomes are compared
+/// and recorded in DecodeDiff. Decoders reached from inside 'decode' are not compared again.
+/// The caller always gets the optimized result, callbacks included.
+template<typename Fields, typename Decode>
+void DecodeDifferential(ByteBuffer& data, Fields& fields, IStatUpdate& update, Decode&& decode)
+{
+#ifndef UF_WITH_DECODE_DIFF
+    decode(data, fields, update);
+#else
+    if (IsDifferentialDecode())
+    {
+        decode(data, fields, update);
+        return;
+    }
+
+    DifferentialDecodeScope differential;
+    std::size_t start = data.rpos();
+
+    ByteBuffer referenceData(data.size() - start);
+    if (data.size() > start)
+        referenceData.append(data.contents() + start, data.size() - start);
+    Fields reference(fields);
+    StatUpdateRecorder referenceCallbacks;
+    std::string referenceError;
+    try
+    {
+        UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+        UpdateFieldDecodeScope noSink(context.Guid, context.ObjectTypeId, nullptr);
+        DecodeTraceScope noTrace(nullptr);
+        ReferenceDecodeScope referenceScope;
+        decode(referenceData, reference, referenceCallbacks);
+    }
+    catch (std::exception const& e)
+    {
+        referenceError = e.what();
+    }
+
+    StatUpdateRecorder optimizedCallbacks;
+    std::string optimizedError;
+    std::exception_ptr failure;
+    try
+    {
+        decode(data, fields, optimizedCallbacks);
+    }
+    catch (std::exception const& e)
+    {
+        optimizedError = e.what();
+        failure = std::current_exception();
+    }
+
+    ByteBuffer referenceFields, optimizedFields;
+    if (referenceError.empty() && optimizedError.empty())
+    {
+        EncodeForDiff(referenceFields, reference);
+        EncodeForDiff(optimizedFields, fields);
+    }
+
+    DecodeDivergence divergence = DecodeDiff::Compare(referenceData.rpos(), data.rpos() - start, referenceError, optimizedError,
+        referenceFields, optimizedFields, referenceCallbacks, optimizedCallbacks);
+    divergence.Guid = UpdateFieldDecodeContext::Current().Guid;
+    divergence.ObjectTypeId = UpdateFieldDecodeContext::Current().ObjectTypeId;
+    DecodeDiff::Record(divergence);
+
+    optimizedCallbacks.Replay(update);
+    if (failure)
+        std::rethrow_exception(failure);
+#endif
+}
+
+}
+
+#endif
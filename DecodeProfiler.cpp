@@ -0,0 +1,257 @@
+#include "DecodeProfiler.h"
+#include "DiagnosticCounters.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace UF
+{
+
+namespace
+{
+    uint32 const ProfileSlots = uint32(UpdateFieldStruct::Max) * 2;
+
+    struct DecoderProfile
+    {
+        std::atomic<uint64> Calls;
+        std::atomic<uint64> Ticks;
+        std::atomic<uint64> Bytes;
+        std::atomic<uint64> BitsSet;
+        std::atomic<uint64> Buckets[DecodeProfiler::BucketCount];
+        std::atomic<uint64> CountedCalls;
+        std::atomic<uint64> Counters[MAX_PERF_COUNTERS];
+    };
+
+    struct ThreadProfile
+    {
+        ThreadProfile()
+        {
+            for (DecoderProfile& profile : Decoders)
+            {
+                profile.Calls = 0;
+                profile.Ticks = 0;
+                profile.Bytes = 0;
+                profile.BitsSet = 0;
+                for (std::atomic<uint64>& bucket : profile.Buckets)
+                    bucket = 0;
+                profile.CountedCalls = 0;
+                for (std::atomic<uint64>& counter : profile.Counters)
+                    counter = 0;
+            }
+        }
+
+        DecoderProfile Decoders[ProfileSlots];
+    };
+
+    /// Thread profiles are never freed, see DiagnosticCounters.h.
+    struct ProfileRegistry
+    {
+        ProfileRegistry() : StartTicks(DecodeProfiler::ReadTicks()), StartTime(std::chrono::steady_clock::now()) { }
+
+        std::mutex Lock;
+        std::vector<std::unique_ptr<ThreadProfile>> Threads;
+        uint64 StartTicks;
+        std::chrono::steady_clock::time_point StartTime;
+    };
+
+    std::atomic<bool> UseHardwareCounters(false);
+
+    ProfileRegistry& GetRegistry()
+    {
+        static ProfileRegistry registry;
+        return registry;
+    }
+
+    ThreadProfile& GetThreadProfile()
+    {
+        static thread_local ThreadProfile* profile = nullptr;
+        if (!profile)
+        {
+            ProfileRegistry& registry = GetRegistry();
+            std::lock_guard<std::mutex> guard(registry.Lock);
+            registry.Threads.emplace_back(new ThreadProfile());
+            profile = registry.Threads.back().get();
+        }
+        return *profile;
+    }
+
+    double GetNanosecondsPerTick()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        ProfileRegistry& registry = GetRegistry();
+        uint64 ticks = DecodeProfiler::ReadTicks() - registry.StartTicks;
+        double nanoseconds = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry.StartTime).count());
+        return ticks && nanoseconds > 0.0 ? nanoseconds / double(ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+}
+
+uint32 DecodeProfiler::GetBucket(uint64 ticks)
+{
+    if (ticks < 4)
+        return uint32(ticks);
+
+    uint32 msb = 63;
+    while (!(ticks >> msb))
+        --msb;
+    return 4 + (msb - 2) * 4 + uint32((ticks >> (msb - 2)) & 3);
+}
+
+uint64 DecodeProfiler::GetBucketStart(uint32 bucket)
+{
+    if (bucket < 4)
+        return bucket;
+
+    uint32 msb = (bucket - 4) / 4 + 2;
+    return uint64(4 + (bucket - 4) % 4) << (msb - 2);
+}
+
+void DecodeProfiler::Record(UpdateFieldStruct type, bool update, uint64 ticks, uint32 bytes, uint32 bitsSet, PerfCounterValues const* counters)
+{
+    DecoderProfile& profile = GetThreadProfile().Decoders[uint32(type) * 2 + (update ? 1 : 0)];
+    AddOwnedCounter(profile.Calls, 1);
+    AddOwnedCounter(profile.Ticks, ticks);
+    AddOwnedCounter(profile.Bytes, bytes);
+    AddOwnedCounter(profile.BitsSet, bitsSet);
+    AddOwnedCounter(profile.Buckets[GetBucket(ticks)], 1);
+    if (counters)
+    {
+        AddOwnedCounter(profile.CountedCalls, 1);
+        for (uint32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+            AddOwnedCounter(profile.Counters[i], counters->Values[i]);
+    }
+}
+
+bool DecodeProfiler::SetHardwareCounters(bool enabled)
+{
+    if (enabled && !PerfCounterGroup::ForThread().IsAvailable())
+        enabled = false;
+    UseHardwareCounters.store(enabled, std::memory_order_relaxed);
+    return enabled;
+}
+
+bool DecodeProfiler::IsUsingHardwareCounters()
+{
+    return UseHardwareCounters.load(std::memory_order_relaxed);
+}
+
+DecodeProfiler::Summary DecodeProfiler::GetSummary(UpdateFieldStruct type, bool update)
+{
+    uint32 slot = uint32(type) * 2 + (update ? 1 : 0);
+    uint64 ticks = 0, bytes = 0, bitsSet = 0;
+    uint64 buckets[BucketCount] = { };
+    uint64 counters[MAX_PERF_COUNTERS] = { };
+    Summary summary;
+
+    {
+        ProfileRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.Lock);
+        for (std::unique_ptr<ThreadProfile> const& thread : registry.Threads)
+        {
+            DecoderProfile const& profile = thread->Decoders[slot];
+            summary.Calls += profile.Calls.load(std::memory_order_relaxed);
+            ticks += profile.Ticks.load(std::memory_order_relaxed);
+            bytes += profile.Bytes.load(std::memory_order_relaxed);
+            bitsSet += profile.BitsSet.load(std::memory_order_relaxed);
+            for (uint32 i = 0; i < BucketCount; ++i)
+                buckets[i] += profile.Buckets[i].load(std::memory_order_relaxed);
+            summary.CountedCalls += profile.CountedCalls.load(std::memory_order_relaxed);
+            for (uint32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+                counters[i] += profile.Counters[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    if (!summary.Calls)
+        return summary;
+
+    double nanosecondsPerTick = GetNanosecondsPerTick();
+    summary.AvgNanoseconds = double(ticks) / double(summary.Calls) * nanosecondsPerTick;
+    summary.AvgBytes = double(bytes) / double(summary.Calls);
+    summary.AvgBitsSet = double(bitsSet) / double(summary.Calls);
+    for (uint32 i = 0; summary.CountedCalls && i < MAX_PERF_COUNTERS; ++i)
+        summary.AvgCounters[i] = double(counters[i]) / double(summary.CountedCalls);
+
+    // percentiles are reported at the middle of their bucket, within 12.5% of the real value
+    uint64 p50 = (summary.Calls + 1) / 2;
+    uint64 p99 = summary.Calls - summary.Calls / 100;
+    uint64 seen = 0;
+    for (uint32 i = 0; i < BucketCount; ++i)
+    {
+        if (!buckets[i])
+            continue;
+
+        uint64 previous = seen;
+        seen += buckets[i];
+        double width = i < 4 ? 1.0 : double(uint64(1) << ((i - 4) / 4));
+        double middle = double(GetBucketStart(i)) + width / 2.0;
+        if (previous < p50 && seen >= p50)
+            summary.P50Nanoseconds = middle * nanosecondsPerTick;
+        if (previous < p99 && seen >= p99)
+            summary.P99Nanoseconds = middle * nanosecondsPerTick;
+    }
+    return summary;
+}
+
+std::string DecodeProfiler::Dump()
+{
+    std::string dump;
+    for (uint32 type = 0; type < uint32(UpdateFieldStruct::Max); ++type)
+    {
+        for (bool update : { false, true })
+        {
+            Summary summary = GetSummary(UpdateFieldStruct(type), update);
+            if (!summary.Calls)
+                continue;
+
+            char line[256];
+            snprintf(line, sizeof(line), "%s::%s: %s calls, p50 %.0fns, p99 %.0fns, avg %.0fns, avg %.1f bytes",
+                GetUpdateFieldStructName(UpdateFieldStruct(type)), update ? "ReadUpdate" : "ReadCreate", FormatCount(summary.Calls).c_str(),
+                summary.P50Nanoseconds, summary.P99Nanoseconds, summary.AvgNanoseconds, summary.AvgBytes);
+            dump += line;
+            if (update)
+            {
+                snprintf(line, sizeof(line), ", avg %.1f bits set", summary.AvgBitsSet);
+                dump += line;
+            }
+            if (summary.CountedCalls)
+            {
+                double cycles = summary.AvgCounters[PERF_COUNTER_CYCLES];
+                snprintf(line, sizeof(line), ", %.0f cycles, IPC %.2f, %.1f branch-misses, %.1f L1D-misses, %.1f LLC-misses per call",
+                    cycles, cycles > 0.0 ? summary.AvgCounters[PERF_COUNTER_INSTRUCTIONS] / cycles : 0.0,
+                    summary.AvgCounters[PERF_COUNTER_BRANCH_MISSES], summary.AvgCounters[PERF_COUNTER_L1D_MISSES],
+                    summary.AvgCounters[PERF_COUNTER_LLC_MISSES]);
+                dump += line;
+            }
+            dump += '\n';
+        }
+    }
+    return dump;
+}
+
+void DecodeProfiler::Reset()
+{
+    ProfileRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> guard(registry.Lock);
+    for (std::unique_ptr<ThreadProfile> const& thread : registry.Threads)
+    {
+        for (DecoderProfile& profile : thread->Decoders)
+        {
+            profile.Calls = 0;
+            profile.Ticks = 0;
+            profile.Bytes = 0;
+            profile.BitsSet = 0;
+            for (std::atomic<uint64>& bucket : profile.Buckets)
+                bucket = 0;
+            profile.CountedCalls = 0;
+            for (std::atomic<uint64>& counter : profile.Counters)
+                counter = 0;
+        }
+    }
+}
+
+}
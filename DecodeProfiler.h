@@ -0,0 +1,81 @@
+#ifndef _DECODEPROFILER_H
+#define _DECODEPROFILER_H
+
+#include "Define.h"
+#include "PerfCounters.h"
+#include "UpdateFieldSink.h"
+#include <string>
+
+#ifdef UF_WITH_DECODE_PROFILING
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+namespace UF
+{
+
+/// Cycle, size and mask density histograms of the top level struct decoders, kept per thread and merged by Dump.
+/// The decoders only feed it in builds with UF_WITH_DECODE_PROFILING (see StructDecodeMark); otherwise
+/// Record is never called and Dump reports nothing.
+/// With SetHardwareCounters(true) each decode also reads the PerfCounterGroup of its thread before and after;
+/// the two reads cost far more than a typical decode, so the nanosecond numbers are only meaningful with it off.
+class DecodeProfiler
+{
+public:
+    static uint32 const BucketCount = 252;
+
+    struct Summary
+    {
+        uint64 Calls = 0;
+        double AvgNanoseconds = 0.0;
+        double P50Nanoseconds = 0.0;
+        double P99Nanoseconds = 0.0;
+        double AvgBytes = 0.0;
+        double AvgBitsSet = 0.0;            // changes mask bits per update, 0 for creates
+        uint64 CountedCalls = 0;            // calls measured with hardware counters
+        double AvgCounters[MAX_PERF_COUNTERS] = { };
+    };
+
+    static uint64 ReadTicks()
+    {
+#ifdef UF_WITH_DECODE_PROFILING
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    /// 'counters' is the hardware counter difference over the decode, nullptr when not measured.
+    static void Record(UpdateFieldStruct type, bool update, uint64 ticks, uint32 bytes, uint32 bitsSet, PerfCounterValues const* counters = nullptr);
+
+    /// Enables the hardware counters for the decodes that start afterwards, on every thread. Returns false and
+    /// leaves them off when the calling thread can't open them (see PerfCounterGroup::GetError).
+    static bool SetHardwareCounters(bool enabled);
+    static bool IsUsingHardwareCounters();
+
+    static Summary GetSummary(UpdateFieldStruct type, bool update);
+
+    /// One line per decoder that ran, e.g. "UnitData::ReadUpdate: 1.2M calls, p50 90ns, p99 600ns, avg 41 bytes, avg 3.1 bits set",
+    /// followed by the per call cycles, IPC, branch and cache misses when hardware counters were used.
+    static std::string Dump();
+
+    /// Clears the histograms of all threads. Decodes running concurrently may be partially kept.
+    static void Reset();
+
+    /// Histogram bucket of a tick count: exact below 4, then 4 buckets per power of two.
+    static uint32 GetBucket(uint64 ticks);
+    static uint64 GetBucketStart(uint32 bucket);
+};
+
+}
+
+#endif
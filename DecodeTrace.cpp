@@ -0,0 +1,63 @@
+#include "DecodeTrace.h"
+
+namespace UF
+{
+
+namespace
+{
+    struct TraceContext
+    {
+        DecodeTrace* Trace = nullptr;
+        std::size_t Base = 0;
+    };
+
+    TraceContext& CurrentContext()
+    {
+        static thread_local TraceContext context;
+        return context;
+    }
+
+    std::string DescribeDesync(UpdateFieldStruct type, std::size_t position, char const* reason)
+    {
+        std::string message = "update field desync";
+        if (type < UpdateFieldStruct::Max)
+            message += std::string(" in ") + GetUpdateFieldStructName(type);
+        return message + " at offset " + std::to_string(position) + ": " + reason;
+    }
+}
+
+UpdateFieldDesyncException::UpdateFieldDesyncException(UpdateFieldStruct type, std::size_t position, char const* reason)
+    : std::runtime_error(DescribeDesync(type, position, reason)), _struct(type), _position(position)
+{
+}
+
+DecodeTrace* DecodeTrace::Current()
+{
+    return CurrentContext().Trace;
+}
+
+std::size_t DecodeTrace::CurrentBase()
+{
+    return CurrentContext().Base;
+}
+
+void DecodeTrace::CheckBlockEnd(ByteBuffer const& data, std::size_t end)
+{
+    if (CurrentContext().Trace && data.rpos() != end)
+        throw UpdateFieldDesyncException(UpdateFieldStruct::Max, CurrentContext().Base + data.rpos(),
+            data.rpos() < end ? "values block not fully consumed" : "values block overrun");
+}
+
+DecodeTraceScope::DecodeTraceScope(DecodeTrace* trace, std::size_t base) : _previous(CurrentContext().Trace), _previousBase(CurrentContext().Base)
+{
+    CurrentContext().Trace = trace;
+    CurrentContext().Base = base;
+}
+
+DecodeTraceScope::~DecodeTraceScope()
+{
+    CurrentContext().Trace = _previous;
+    CurrentContext().Base = _previousBase;
+}
+
+}
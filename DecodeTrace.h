@@ -0,0 +1,175 @@
+#ifndef _DECODETRACE_H
+#define _DECODETRACE_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "AllocationAccounting.h"
+#include "DecodeProfiler.h"
+#include "ReferenceDecode.h"
+#include "UpdateFieldSink.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+namespace UF
+{
+
+/// Thrown when a decoder left the packet in a state the server can't have produced. Everything after the
+/// failing struct is unreliable, the packet should be dropped.
+class UpdateFieldDesyncException : public std::runtime_error
+{
+public:
+    UpdateFieldDesyncException(UpdateFieldStruct type, std::size_t position, char const* reason);
+
+    /// Max when the failing struct is not known (bit reader checks).
+    UpdateFieldStruct GetStruct() const { return _struct; }
+    std::size_t GetPosition() const { return _position; }
+
+private:
+    UpdateFieldStruct _struct;
+    std::size_t _position;
+};
+
+struct DecodeTraceEntry
+{
+    UpdateFieldStruct Struct;
+    bool Update;
+    uint32 Start;                       // packet offset of the first and past the last byte read
+    uint32 End;
+};
+
+/// Per packet record of the bytes each top level struct decoder consumed.
+/// While a trace is installed on a thread the decoders also check their invariants (dynamic field sizes,
+/// zero padding of bit packed data, blocks consumed exactly) and throw UpdateFieldDesyncException.
+/// Without a trace the only cost is one thread local load per struct.
+/// Entries may be added concurrently by the workers of a parallel UpdateObjectBatch.
+class DecodeTrace
+{
+public:
+    static uint32 const Capacity = 512;
+
+    DecodeTrace() : _count(0) { }
+
+    DecodeTrace(DecodeTrace const&) = delete;
+    DecodeTrace& operator=(DecodeTrace const&) = delete;
+
+    void Clear() { _count = 0; }
+
+    void Add(UpdateFieldStruct type, bool update, std::size_t start, std::size_t end)
+    {
+        uint32 index = _count.fetch_add(1, std::memory_order_relaxed);
+        if (index < Capacity)
+            _entries[index] = { type, update, uint32(start), uint32(end) };
+    }
+
+    /// Structs decoded since Clear, including the ones past Capacity that were not stored.
+    uint32 GetTotal() const { return _count.load(std::memory_order_relaxed); }
+    uint32 GetCount() const { return GetTotal() < Capacity ? GetTotal() : Capacity; }
+    DecodeTraceEntry const& operator[](uint32 index) const { return _entries[index]; }
+
+    /// Trace installed on the calling thread and the packet offset of the buffer being decoded, see DecodeTraceScope.
+    static DecodeTrace* Current();
+    static std::size_t CurrentBase();
+
+    /// Throws when 'data' was not consumed up to 'end' exactly. No-op without trace.
+    static void CheckBlockEnd(ByteBuffer const& data, std::size_t end);
+
+private:
+    std::atomic<uint32> _count;
+    DecodeTraceEntry _entries[Capacity];
+};
+
+/// Installs a trace on the calling thread until the scope ends. 'base' is the packet offset of the first byte
+/// of the decoded buffer, for decoders running on a copy of one block.
+class DecodeTraceScope
+{
+public:
+    explicit DecodeTraceScope(DecodeTrace* trace, std::size_t base = 0);
+    ~DecodeTraceScope();
+
+    DecodeTraceScope(DecodeTraceScope const&) = delete;
+    DecodeTraceScope& operator=(DecodeTraceScope const&) = delete;
+
+private:
+    DecodeTrace* _previous;
+    std::size_t _previousBase;
+};
+
+/// Start of a top level struct decode. Finish records the consumed bytes in the installed trace,
+/// and in UF_WITH_DECODE_PROFILING builds the decode time, mask density and hardware counters in DecodeProfiler.
+class StructDecodeMark
+{
+public:
+    StructDecodeMark(ByteBuffer const& data, UpdateFieldStruct type) : _trace(DecodeTrace::Current()), _start(data.rpos()), _struct(type)
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+        , _allocations(type)
+#endif
+    {
+#ifdef UF_WITH_DECODE_PROFILING
+        _counted = DecodeProfiler::IsUsingHardwareCounters() && PerfCounterGroup::ForThread().Read(_startCounters);
+        _startTicks = DecodeProfiler::ReadTicks();
+#endif
+    }
+
+    UpdateFieldStruct GetStruct() const { return _struct; }
+
+    /// Dynamic field sizes read from the packet must fit in the rest of it, 'minElementSize' bytes per element.
+    void CheckSize(ByteBuffer const& data, uint32 count, std::size_t minElementSize) const
+    {
+        if (_trace && count > (data.size() - data.rpos()) / minElementSize)
+            throw UpdateFieldDesyncException(_struct, DecodeTrace::CurrentBase() + data.rpos(), "dynamic field size past the end of the packet");
+    }
+
+    /// 'mask' is the changes mask of an update, nullptr for a create.
+    void Finish(ByteBuffer const& data, uint32 const* mask, uint32 maskWords) const
+    {
+#ifdef UF_WITH_DECODE_PROFILING
+        // the reference decode of a differential decode would count every struct twice, with other timings
+        if (!IsReferenceDecode())
+        {
+            uint64 ticks = DecodeProfiler::ReadTicks() - _startTicks;
+            uint32 bitsSet = 0;
+            for (uint32 i = 0; mask && i < maskWords; ++i)
+                bitsSet += PopCount(mask[i]);
+            PerfCounterValues counters;
+            bool counted = _counted && PerfCounterGroup::ForThread().Read(counters);
+            if (counted)
+                counters = counters - _startCounters;
+            DecodeProfiler::Record(_struct, mask != nullptr, ticks, uint32(data.rpos() - _start), bitsSet, counted ? &counters : nullptr);
+        }
+#else
+        (void)maskWords;
+#endif
+        if (_trace)
+        {
+            std::size_t base = DecodeTrace::CurrentBase();
+            _trace->Add(_struct, mask != nullptr, base + _start, base + data.rpos());
+        }
+    }
+
+private:
+#ifdef UF_WITH_DECODE_PROFILING
+    static uint32 PopCount(uint32 value)
+    {
+#if defined(_MSC_VER)
+        return uint32(__popcnt(value));
+#else
+        return uint32(__builtin_popcount(value));
+#endif
+    }
+
+    uint64 _startTicks;
+    PerfCounterValues _startCounters;
+    bool _counted;
+#endif
+    DecodeTrace* _trace;
+    std::size_t _start;
+    UpdateFieldStruct _struct;
+#ifdef UF_WITH_ALLOC_ACCOUNTING
+    AllocationStructScope _allocations;
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _DIAGNOSTICCOUNTERS_H
+#define _DIAGNOSTICCOUNTERS_H
+
+#include "Define.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+namespace UF
+{
+
+/// Helpers shared by the per thread diagnostics (DecodeProfiler, AllocationAccounting).
+/// Each thread owns its counter block and is the only writer; blocks are kept after their thread exits so
+/// short lived decode workers still show up in dumps, and readers sum them while they are written.
+
+/// Adds to a counter only its owning thread writes, readers may see it slightly behind.
+inline void AddOwnedCounter(std::atomic<uint64>& counter, uint64 value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/// 950, 12.3K, 4.5M
+inline std::string FormatCount(uint64 count)
+{
+    char buffer[32];
+    if (count >= 1000000)
+        snprintf(buffer, sizeof(buffer), "%.1fM", double(count) / 1000000.0);
+    else if (count >= 1000)
+        snprintf(buffer, sizeof(buffer), "%.1fK", double(count) / 1000.0);
+    else
+        snprintf(buffer, sizeof(buffer), "%u", uint32(count));
+    return buffer;
+}
+
+}
+
+#endif
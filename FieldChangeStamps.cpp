@@ -0,0 +1,90 @@
+#include "FieldChangeStamps.h"
+#include "Timer.h"
+
+namespace UF
+{
+
+FieldChangeStamps::FieldChangeStamps(uint32 resolution, UpdateFieldSink* next) : UpdateFieldSink(next),
+    _resolution(resolution ? resolution : 1), _slotCount(0)
+{
+}
+
+uint32 FieldChangeStamps::Now()
+{
+    return getMSTime();
+}
+
+void FieldChangeStamps::Track(UpdateFieldStruct type, uint32 bit)
+{
+    std::vector<int16>& slots = _slots[uint32(type)];
+    if (slots.size() <= bit)
+        slots.resize(bit + 1, -1);
+    if (slots[bit] >= 0)
+        return;
+
+    slots[bit] = int16(_slotCount++);
+    _tracked[uint32(type)].push_back(uint16(bit));
+}
+
+void FieldChangeStamps::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+    std::vector<uint16> const& tracked = _tracked[uint32(type)];
+    if (!tracked.empty() && !context.Guid.IsEmpty())
+    {
+        uint32 now = Now();
+        Stamps* stamps = nullptr;
+        uint32 steps = 0;
+        for (uint16 bit : tracked)
+        {
+            if (!IsFieldDecoded(mask, maskWords, bit))
+                continue;
+
+            if (!stamps)
+            {
+                stamps = &_objects[context.Guid];
+                if (stamps->Stamps.empty())
+                    stamps->Base = now;
+                // fields tracked after the object was first stamped
+                if (stamps->Stamps.size() < _slotCount)
+                    stamps->Stamps.resize(_slotCount, 0);
+
+                steps = (now - stamps->Base) / _resolution;
+                if (steps >= 0xFFFF)
+                {
+                    // keep the newest half of the range
+                    uint32 shift = steps - 0x7FFF;
+                    Rebase(*stamps, shift);
+                    steps -= shift;
+                }
+            }
+
+            stamps->Stamps[_slots[uint32(type)][bit]] = uint16(steps + 1);
+        }
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+void FieldChangeStamps::Rebase(Stamps& stamps, uint32 shift)
+{
+    stamps.Base += shift * _resolution;
+    for (uint16& stamp : stamps.Stamps)
+        stamp = stamp > shift ? uint16(stamp - shift) : 0;
+}
+
+bool FieldChangeStamps::GetLastChange(ObjectGuid const& guid, UpdateFieldStruct type, uint32 bit, uint32& time) const
+{
+    int32 slot = GetSlot(type, bit);
+    if (slot < 0)
+        return false;
+
+    auto itr = _objects.find(guid);
+    if (itr == _objects.end() || uint32(slot) >= itr->second.Stamps.size() || !itr->second.Stamps[slot])
+        return false;
+
+    time = itr->second.Base + uint32(itr->second.Stamps[slot] - 1) * _resolution;
+    return true;
+}
+
+}
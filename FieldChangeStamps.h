@@ -0,0 +1,82 @@
+#ifndef _FIELDCHANGESTAMPS_H
+#define _FIELDCHANGESTAMPS_H
+
+#include "Define.h"
+#include "ObjectFieldIndex.h"
+#include "UpdateFieldSink.h"
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// "Last changed" time of selected fields of every object, without shadow copies of the values.
+/// Fields are chosen by changes mask bit (UnitData Health is bit 5, Power[i] 135 + i, ...) and stamped whenever a decode
+/// writes them. Each stamp is a 16 bit count of 'resolution' ms steps from a per object base time in a side array;
+/// the base moves forward when the range runs out, dropping stamps older than about 32k steps.
+class FieldChangeStamps : public UpdateFieldSink
+{
+public:
+    explicit FieldChangeStamps(uint32 resolution = 16, UpdateFieldSink* next = nullptr);
+
+    /// Starts stamping a field. Objects stamped before only get a slot for it on their next decode.
+    void Track(UpdateFieldStruct type, uint32 bit);
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    void Remove(ObjectGuid const& guid) { _objects.erase(guid); }
+    void Clear() { _objects.clear(); }
+
+    /// getMSTime() of the last write of a tracked field, rounded down to the resolution.
+    /// False if the field is not tracked, was never written or its stamp expired.
+    bool GetLastChange(ObjectGuid const& guid, UpdateFieldStruct type, uint32 bit, uint32& time) const;
+
+    /// Calls fn(guid, time) for every object whose field was written in the last 'window' ms.
+    template<typename Callback>
+    void ForEachChangedWithin(UpdateFieldStruct type, uint32 bit, uint32 window, Callback&& fn) const
+    {
+        int32 slot = GetSlot(type, bit);
+        if (slot < 0)
+            return;
+
+        uint32 now = Now();
+        for (auto const& object : _objects)
+        {
+            std::vector<uint16> const& stamps = object.second.Stamps;
+            uint16 stamp = uint32(slot) < stamps.size() ? stamps[slot] : 0;
+            if (!stamp)
+                continue;
+
+            uint32 time = object.second.Base + uint32(stamp - 1) * _resolution;
+            if (now - time <= window)
+                fn(object.first, time);
+        }
+    }
+
+private:
+    struct Stamps
+    {
+        uint32 Base = 0;
+        std::vector<uint16> Stamps;
+    };
+
+    static uint32 Now();
+
+    int32 GetSlot(UpdateFieldStruct type, uint32 bit) const
+    {
+        std::vector<int16> const& slots = _slots[uint32(type)];
+        return bit < slots.size() ? slots[bit] : -1;
+    }
+
+    void Rebase(Stamps& stamps, uint32 shift);
+
+    uint32 _resolution;
+    uint32 _slotCount;
+    std::vector<int16> _slots[uint32(UpdateFieldStruct::Max)];      // mask bit -> stamp slot, -1 when not tracked
+    std::vector<uint16> _tracked[uint32(UpdateFieldStruct::Max)];   // tracked bits with their slot
+    std::unordered_map<ObjectGuid, Stamps, ObjectGuidHash> _objects;
+};
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include "InventoryIndex.h"
+
+namespace UF
+{
+
+InventoryIndex::InventoryIndex()
+{
+    Clear();
+}
+
+void InventoryIndex::Clear()
+{
+    _bags.clear();
+    _items.clear();
+    _byEntry.clear();
+    _bags[0].NumSlots = DEFAULT_BACKPACK_SLOTS;
+    _totalFree = DEFAULT_BACKPACK_SLOTS;
+}
+
+bool InventoryIndex::CountsAsStorage(uint64 bag, uint32 slot, uint32 numSlots)
+{
+    // player slots also hold equipment, bags, bank and buyback; only the backpack counts towards free space
+    if (!bag)
+        return slot >= BACKPACK_SLOT_START && slot < BACKPACK_SLOT_START + numSlots;
+    return slot < numSlots;
+}
+
+void InventoryIndex::SetUsed(Bag& bag, uint64 bagGuid, uint32 slot, bool used)
+{
+    if (!CountsAsStorage(bagGuid, slot, bag.NumSlots))
+        return;
+
+    uint32 freeBefore = GetFree(bag);
+    if (used)
+        ++bag.Used;
+    else
+        --bag.Used;
+    _totalFree = _totalFree - freeBefore + GetFree(bag);
+}
+
+void InventoryIndex::SetSlot(uint64 bagGuid, uint32 slot, uint64 itemGuid)
+{
+    Bag& bag = _bags[bagGuid];
+    if (bag.Items.size() <= slot)
+        bag.Items.resize(slot + 1, 0);
+
+    uint64 previous = bag.Items[slot];
+    if (previous == itemGuid)
+        return;
+
+    if (previous)
+    {
+        auto itr = _items.find(previous);
+        // the item may already have been moved to another slot by an earlier change of the same packet
+        if (itr != _items.end() && itr->second.Placed && itr->second.Location.Bag == bagGuid && itr->second.Location.Slot == slot)
+        {
+            Unlink(itr->second);
+            itr->second.Placed = false;
+        }
+        SetUsed(bag, bagGuid, slot, false);
+    }
+
+    bag.Items[slot] = itemGuid;
+    if (!itemGuid)
+        return;
+
+    SetUsed(bag, bagGuid, slot, true);
+    Item& item = _items[itemGuid];
+    if (item.Placed)
+    {
+        // moved: clear the old slot without waiting for its own change
+        Bag& oldBag = _bags[item.Location.Bag];
+        if (item.Location.Slot < oldBag.Items.size() && oldBag.Items[item.Location.Slot] == itemGuid)
+        {
+            oldBag.Items[item.Location.Slot] = 0;
+            SetUsed(oldBag, item.Location.Bag, item.Location.Slot, false);
+        }
+        Unlink(item);
+    }
+
+    item.Placed = true;
+    item.Location = { bagGuid, slot };
+    Link(itemGuid, item);
+}
+
+void InventoryIndex::SetBagSize(uint64 bagGuid, uint32 numSlots)
+{
+    Bag& bag = _bags[bagGuid];
+    uint32 freeBefore = GetFree(bag);
+    uint32 used = 0;
+    for (uint32 slot = 0; slot < bag.Items.size(); ++slot)
+        if (bag.Items[slot] && CountsAsStorage(bagGuid, slot, numSlots))
+            ++used;
+    bag.NumSlots = numSlots;
+    bag.Used = used;
+    _totalFree = _totalFree - freeBefore + GetFree(bag);
+}
+
+void InventoryIndex::RemoveBag(uint64 bagGuid)
+{
+    auto itr = _bags.find(bagGuid);
+    if (itr == _bags.end() || !bagGuid)
+        return;
+
+    for (uint32 slot = 0; slot < itr->second.Items.size(); ++slot)
+        SetSlot(bagGuid, slot, 0);
+    _totalFree -= GetFree(itr->second);
+    _bags.erase(itr);
+}
+
+void InventoryIndex::Link(uint64 guid, Item& item)
+{
+    if (!item.Placed || !item.Entry)
+        return;
+
+    ByEntry& entry = _byEntry[item.Entry];
+    item.EntryPosition = uint32(entry.Items.size());
+    entry.Items.push_back(guid);
+    entry.Count += item.StackCount;
+}
+
+void InventoryIndex::Unlink(Item& item)
+{
+    if (!item.Placed || !item.Entry)
+        return;
+
+    auto itr = _byEntry.find(item.Entry);
+    if (itr == _byEntry.end())
+        return;
+
+    ByEntry& entry = itr->second;
+    uint64 last = entry.Items.back();
+    entry.Items[item.EntryPosition] = last;
+    _items[last].EntryPosition = item.EntryPosition;
+    entry.Items.pop_back();
+    entry.Count -= item.StackCount;
+    if (entry.Items.empty())
+        _byEntry.erase(itr);
+}
+
+void InventoryIndex::SetItemInfo(uint64 itemGuid, uint32 entry, uint32 stackCount)
+{
+    Item& item = _items[itemGuid];
+    if (item.Entry == entry)
+    {
+        if (item.Placed && entry)
+        {
+            ByEntry& byEntry = _byEntry[entry];
+            byEntry.Count = byEntry.Count - item.StackCount + stackCount;
+        }
+        item.StackCount = stackCount;
+        return;
+    }
+
+    Unlink(item);
+    item.Entry = entry;
+    item.StackCount = stackCount;
+    Link(itemGuid, item);
+}
+
+void InventoryIndex::RemoveItemInfo(uint64 itemGuid)
+{
+    auto itr = _items.find(itemGuid);
+    if (itr == _items.end())
+        return;
+
+    if (itr->second.Placed)
+    {
+        // still in a slot, only forget what the item object told us
+        Unlink(itr->second);
+        itr->second.Entry = 0;
+        itr->second.StackCount = 0;
+        return;
+    }
+    _items.erase(itr);
+}
+
+bool InventoryIndex::FindItem(uint64 itemGuid, ItemLocation& location) const
+{
+    auto itr = _items.find(itemGuid);
+    if (itr == _items.end() || !itr->second.Placed)
+        return false;
+    location = itr->second.Location;
+    return true;
+}
+
+std::vector<uint64> const& InventoryIndex::GetItemsByEntry(uint32 entry) const
+{
+    static std::vector<uint64> const empty;
+    auto itr = _byEntry.find(entry);
+    return itr != _byEntry.end() ? itr->second.Items : empty;
+}
+
+uint32 InventoryIndex::GetItemCount(uint32 entry) const
+{
+    auto itr = _byEntry.find(entry);
+    return itr != _byEntry.end() ? itr->second.Count : 0;
+}
+
+uint32 InventoryIndex::GetFreeSlots(uint64 bagGuid) const
+{
+    auto itr = _bags.find(bagGuid);
+    return itr != _bags.end() ? GetFree(itr->second) : 0;
+}
+
+}
@@ -0,0 +1,127 @@
+#ifndef _INVENTORYINDEX_H
+#define _INVENTORYINDEX_H
+
+#include "Define.h"
+#include "StatUpdateRecorder.h"
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// Where an item sits: 'Bag' is the low guid of the container, 0 for the player's own InvSlots.
+struct ItemLocation
+{
+    uint64 Bag;
+    uint32 Slot;
+};
+
+/// Inventory of the active player indexed from ActivePlayerData::InvSlots and ContainerData::Slots.
+/// Every slot change is applied in O(1): item guid -> location, item entry -> items, aggregated stack counts
+/// per entry (joined with ItemData::StackCount) and free slots per bag.
+class InventoryIndex
+{
+public:
+    static uint32 const BACKPACK_SLOT_START = 23;           // INVENTORY_SLOT_ITEM_START
+    static uint32 const DEFAULT_BACKPACK_SLOTS = 16;
+
+    /// Listener for the active player, forwards everything after indexing OnActivePlayerInvSlot.
+    class PlayerListener : public StatUpdateForwarder
+    {
+    public:
+        PlayerListener(InventoryIndex& index, IStatUpdate* next = nullptr) : StatUpdateForwarder(next), _index(index) { }
+
+        void OnActivePlayerInvSlot(uint64 old, uint64 value, uint32 index) override
+        {
+            _index.SetSlot(0, index, value);
+            StatUpdateForwarder::OnActivePlayerInvSlot(old, value, index);
+        }
+
+    private:
+        InventoryIndex& _index;
+    };
+
+    /// Listener for one container object, forwards everything after indexing OnContainerSlots.
+    class ContainerListener : public StatUpdateForwarder
+    {
+    public:
+        ContainerListener(InventoryIndex& index, uint64 bag, IStatUpdate* next = nullptr) : StatUpdateForwarder(next), _index(index), _bag(bag) { }
+
+        void OnContainerSlots(uint64 old, uint64 value, uint32 index) override
+        {
+            _index.SetSlot(_bag, index, value);
+            StatUpdateForwarder::OnContainerSlots(old, value, index);
+        }
+
+    private:
+        InventoryIndex& _index;
+        uint64 _bag;
+    };
+
+    InventoryIndex();
+
+    /// Places 'item' (low guid, 0 for empty) into a slot.
+    void SetSlot(uint64 bag, uint32 slot, uint64 item);
+
+    /// Number of usable slots, ContainerData::NumSlots for bags. For bag 0 the backpack size.
+    void SetBagSize(uint64 bag, uint32 numSlots);
+
+    /// Drops a container and everything indexed in it.
+    void RemoveBag(uint64 bag);
+
+    /// ObjectData::EntryID and ItemData::StackCount of an item, may arrive before or after its slot.
+    void SetItemInfo(uint64 item, uint32 entry, uint32 stackCount);
+    void RemoveItemInfo(uint64 item);
+
+    bool FindItem(uint64 item, ItemLocation& location) const;
+
+    /// Low guids of all placed items of an entry.
+    std::vector<uint64> const& GetItemsByEntry(uint32 entry) const;
+
+    /// Sum of StackCount over all placed items of an entry.
+    uint32 GetItemCount(uint32 entry) const;
+
+    uint32 GetFreeSlots(uint64 bag) const;
+    uint32 GetTotalFreeSlots() const { return _totalFree; }
+
+    void Clear();
+
+private:
+    struct Bag
+    {
+        uint32 NumSlots = 0;
+        uint32 Used = 0;
+        std::vector<uint64> Items;
+    };
+
+    struct Item
+    {
+        uint32 Entry = 0;
+        uint32 StackCount = 0;
+        bool Placed = false;
+        ItemLocation Location = { 0, 0 };
+        uint32 EntryPosition = 0;       // position in ByEntry::Items while placed with a known entry
+    };
+
+    struct ByEntry
+    {
+        std::vector<uint64> Items;
+        uint32 Count = 0;
+    };
+
+    static bool CountsAsStorage(uint64 bag, uint32 slot, uint32 numSlots);
+
+    void Link(uint64 guid, Item& item);
+    void Unlink(Item& item);
+    void SetUsed(Bag& bag, uint64 bagGuid, uint32 slot, bool used);
+    uint32 GetFree(Bag const& bag) const { return bag.NumSlots > bag.Used ? bag.NumSlots - bag.Used : 0; }
+
+    std::unordered_map<uint64, Bag> _bags;
+    std::unordered_map<uint64, Item> _items;
+    std::unordered_map<uint32, ByEntry> _byEntry;
+    uint32 _totalFree;
+};
+
+}
+
+#endif
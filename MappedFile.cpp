@@ -0,0 +1,96 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : _data(nullptr), _size(0),
+#ifdef _WIN32
+    _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+#else
+    _fd(-1)
+#endif
+{
+}
+
+bool MappedFile::Open(std::string const& path, AccessPattern access)
+{
+    Close();
+
+#ifdef _WIN32
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        access == ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size) || !size.QuadPart)
+    {
+        Close();
+        return false;
+    }
+    _size = uint64(size.QuadPart);
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping)
+    {
+        Close();
+        return false;
+    }
+
+    _data = static_cast<uint8 const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data)
+    {
+        Close();
+        return false;
+    }
+#else
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0 || !st.st_size)
+    {
+        Close();
+        return false;
+    }
+    _size = uint64(st.st_size);
+
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    madvise(data, _size, access == ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+    _data = static_cast<uint8 const*>(data);
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+#else
+    if (_data)
+        munmap(const_cast<uint8*>(_data), _size);
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+#endif
+    _data = nullptr;
+    _size = 0;
+}
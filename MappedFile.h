@@ -0,0 +1,42 @@
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include "Define.h"
+#include <string>
+
+/// Read only mapping of a whole file.
+class MappedFile
+{
+public:
+    enum AccessPattern
+    {
+        ACCESS_SEQUENTIAL,
+        ACCESS_RANDOM
+    };
+
+    MappedFile();
+    ~MappedFile() { Close(); }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    /// Fails for missing and empty files.
+    bool Open(std::string const& path, AccessPattern access);
+    void Close();
+
+    bool IsOpen() const { return _data != nullptr; }
+    uint8 const* GetData() const { return _data; }
+    uint64 GetSize() const { return _size; }
+
+private:
+    uint8 const* _data;
+    uint64 _size;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _fd;
+#endif
+};
+
+#endif
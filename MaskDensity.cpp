@@ -0,0 +1,158 @@
+#include "MaskDensity.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace UF
+{
+
+namespace
+{
+    uint32 CountTrailingZeros(uint32 value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return uint32(index);
+#else
+        return uint32(__builtin_ctz(value));
+#endif
+    }
+}
+
+MaskDensityStats& MaskDensityStats::Global()
+{
+    static MaskDensityStats stats;
+    return stats;
+}
+
+void MaskDensityStats::Merge(Counts const* counts)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    for (uint32 type = 0; type < uint32(UpdateFieldStruct::Max); ++type)
+    {
+        Counts& total = _counts[type];
+        total.Creates += counts[type].Creates;
+        total.Updates += counts[type].Updates;
+        if (total.Bits.size() < counts[type].Bits.size())
+            total.Bits.resize(counts[type].Bits.size(), 0);
+        for (std::size_t bit = 0; bit < counts[type].Bits.size(); ++bit)
+            total.Bits[bit] += counts[type].Bits[bit];
+    }
+}
+
+void MaskDensityStats::Reset()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    for (Counts& counts : _counts)
+        counts = Counts();
+}
+
+MaskDensityStats::Counts MaskDensityStats::GetCounts(UpdateFieldStruct type) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _counts[uint32(type)];
+}
+
+double MaskDensityStats::GetDensity(UpdateFieldStruct type, uint32 bit) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    Counts const& counts = _counts[uint32(type)];
+    if (!counts.Updates || bit >= counts.Bits.size())
+        return 0.0;
+    return double(counts.Bits[bit]) / double(counts.Updates);
+}
+
+std::string MaskDensityStats::ExportCsv() const
+{
+    std::string csv = "struct,bit,set,updates,density\n";
+    for (uint32 type = 0; type < uint32(UpdateFieldStruct::Max); ++type)
+    {
+        Counts counts = GetCounts(UpdateFieldStruct(type));
+        for (std::size_t bit = 0; bit < counts.Bits.size(); ++bit)
+        {
+            if (!counts.Bits[bit])
+                continue;
+
+            char line[128];
+            snprintf(line, sizeof(line), "%s,%u,%llu,%llu,%.6f\n", GetUpdateFieldStructName(UpdateFieldStruct(type)), uint32(bit),
+                (unsigned long long)counts.Bits[bit], (unsigned long long)counts.Updates, double(counts.Bits[bit]) / double(counts.Updates));
+            csv += line;
+        }
+    }
+    return csv;
+}
+
+std::string MaskDensityStats::ExportHeatmap() const
+{
+    static char const Shades[] = " .:-=+*#%@";
+    uint32 const ShadeCount = sizeof(Shades) - 2;
+
+    std::string heatmap;
+    for (uint32 type = 0; type < uint32(UpdateFieldStruct::Max); ++type)
+    {
+        Counts counts = GetCounts(UpdateFieldStruct(type));
+        if (!counts.Updates)
+            continue;
+
+        char line[128];
+        snprintf(line, sizeof(line), "%s, %llu updates\n", GetUpdateFieldStructName(UpdateFieldStruct(type)), (unsigned long long)counts.Updates);
+        heatmap += line;
+        for (std::size_t row = 0; row < counts.Bits.size(); row += 32)
+        {
+            snprintf(line, sizeof(line), "%5u |", uint32(row));
+            heatmap += line;
+            for (std::size_t bit = row; bit < row + 32 && bit < counts.Bits.size(); ++bit)
+            {
+                // any bit that was set at all gets at least the first visible shade
+                uint32 shade = 0;
+                if (counts.Bits[bit])
+                    shade = 1 + uint32(double(counts.Bits[bit]) / double(counts.Updates) * (ShadeCount - 1) + 0.5);
+                heatmap += Shades[shade];
+            }
+            heatmap += "|\n";
+        }
+    }
+    return heatmap;
+}
+
+void MaskDensityCollector::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    MaskDensityStats::Counts& counts = _counts[uint32(type)];
+    if (!mask)
+        ++counts.Creates;
+    else
+    {
+        ++counts.Updates;
+        if (counts.Bits.size() < maskWords * 32)
+            counts.Bits.resize(maskWords * 32, 0);
+
+        for (uint32 word = 0; word < maskWords; ++word)
+        {
+            uint32 bits = mask[word];
+            while (bits)
+            {
+                ++counts.Bits[word * 32 + CountTrailingZeros(bits)];
+                bits &= bits - 1;
+            }
+        }
+
+        if (++_pending >= _flushEvery)
+            Flush();
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+void MaskDensityCollector::Flush()
+{
+    _pending = 0;
+    _stats.Merge(_counts);
+    for (MaskDensityStats::Counts& counts : _counts)
+    {
+        counts.Creates = 0;
+        counts.Updates = 0;
+        std::fill(counts.Bits.begin(), counts.Bits.end(), 0);
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef _MASKDENSITY_H
+#define _MASKDENSITY_H
+
+#include "Define.h"
+#include "UpdateFieldSink.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UF
+{
+
+/// How often each changes mask bit of each struct is set in decoded updates, e.g. UnitData bit 5 (Health),
+/// bits 135-144 (Power) or ItemData bit 7 (StackCount). Shared by the MaskDensityCollector of every session.
+class MaskDensityStats
+{
+public:
+    struct Counts
+    {
+        uint64 Creates = 0;
+        uint64 Updates = 0;
+        std::vector<uint64> Bits;       // [bit], number of updates with the bit set
+    };
+
+    /// Process wide instance the collectors report to by default.
+    static MaskDensityStats& Global();
+
+    void Merge(Counts const* counts);   // one Counts per UpdateFieldStruct
+    void Reset();
+
+    Counts GetCounts(UpdateFieldStruct type) const;
+
+    /// Share of the updates of 'type' with 'bit' set.
+    double GetDensity(UpdateFieldStruct type, uint32 bit) const;
+
+    /// "struct,bit,set,updates,density" rows of every bit seen set at least once.
+    std::string ExportCsv() const;
+
+    /// One block per struct, 32 bits per row, one character per bit from ' ' (never set) to '@' (always set).
+    std::string ExportHeatmap() const;
+
+private:
+    mutable std::mutex _lock;
+    Counts _counts[uint32(UpdateFieldStruct::Max)];
+};
+
+/// Session side collector. Counts locally and merges into the shared stats every 'flushEvery' updates,
+/// so sessions on different threads don't contend on the shared counters.
+class MaskDensityCollector : public UpdateFieldSink
+{
+public:
+    explicit MaskDensityCollector(MaskDensityStats& stats = MaskDensityStats::Global(), uint32 flushEvery = 4096, UpdateFieldSink* next = nullptr)
+        : UpdateFieldSink(next), _stats(stats), _flushEvery(flushEvery), _pending(0) { }
+
+    ~MaskDensityCollector() { Flush(); }
+
+    MaskDensityCollector(MaskDensityCollector const&) = delete;
+    MaskDensityCollector& operator=(MaskDensityCollector const&) = delete;
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    void Flush();
+
+private:
+    MaskDensityStats& _stats;
+    uint32 _flushEvery;
+    uint32 _pending;
+    MaskDensityStats::Counts _counts[uint32(UpdateFieldStruct::Max)];
+};
+
+}
+
+#endif
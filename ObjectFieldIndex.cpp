@@ -0,0 +1,105 @@
+#include "ObjectFieldIndex.h"
+#include "UpdateFields.h"
+
+namespace UF
+{
+
+void ObjectFieldIndex::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+    if (!context.Guid.IsEmpty())
+    {
+        switch (type)
+        {
+            case UpdateFieldStruct::Object:
+            {
+                ObjectData const& object = *static_cast<ObjectData const*>(fields);
+                if (IsFieldDecoded(mask, maskWords, 1))
+                    Set(context.Guid, INDEX_ENTRY, MakeKey(context.ObjectTypeId, uint32(object.EntryID._value)));
+                break;
+            }
+            case UpdateFieldStruct::Unit:
+            {
+                UnitData const& unit = *static_cast<UnitData const*>(fields);
+                if (IsFieldDecoded(mask, maskWords, 40))
+                    Set(context.Guid, INDEX_FACTION, MakeKey(context.ObjectTypeId, uint32(unit.FactionTemplate._value)));
+                break;
+            }
+            case UpdateFieldStruct::GameObject:
+            {
+                GameObjectData const& go = *static_cast<GameObjectData const*>(fields);
+                if (IsFieldDecoded(mask, maskWords, 13))
+                    Set(context.Guid, INDEX_FACTION, MakeKey(context.ObjectTypeId, uint32(go.FactionTemplate._value)));
+                if (IsFieldDecoded(mask, maskWords, 15) || IsFieldDecoded(mask, maskWords, 16))
+                    Set(context.Guid, INDEX_GAMEOBJECT_STATE, MakeKey(uint8(go.TypeID._value), uint8(go.State._value)));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+void ObjectFieldIndex::Set(ObjectGuid const& guid, IndexType index, uint64 key)
+{
+    Record& record = _records[guid];
+    Link& link = record.Links[index];
+    if (link.Linked)
+    {
+        if (link.Key == key)
+            return;
+        Unset(record, index);
+    }
+
+    std::vector<ObjectGuid>& bucket = _buckets[index][key];
+    link.Key = key;
+    link.Position = uint32(bucket.size());
+    link.Linked = true;
+    bucket.push_back(guid);
+}
+
+void ObjectFieldIndex::Unset(Record& record, IndexType index)
+{
+    Link& link = record.Links[index];
+    if (!link.Linked)
+        return;
+
+    auto itr = _buckets[index].find(link.Key);
+    std::vector<ObjectGuid>& bucket = itr->second;
+    ObjectGuid last = bucket.back();
+    bucket[link.Position] = last;
+    _records[last].Links[index].Position = link.Position;
+    bucket.pop_back();
+    if (bucket.empty())
+        _buckets[index].erase(itr);
+    link.Linked = false;
+}
+
+void ObjectFieldIndex::Remove(ObjectGuid const& guid)
+{
+    auto itr = _records.find(guid);
+    if (itr == _records.end())
+        return;
+
+    for (uint32 index = 0; index < MAX_INDEX; ++index)
+        Unset(itr->second, IndexType(index));
+    _records.erase(itr);
+}
+
+void ObjectFieldIndex::Clear()
+{
+    _records.clear();
+    for (Buckets& buckets : _buckets)
+        buckets.clear();
+}
+
+std::vector<ObjectGuid> const& ObjectFieldIndex::Find(IndexType index, uint64 key) const
+{
+    static std::vector<ObjectGuid> const empty;
+    auto itr = _buckets[index].find(key);
+    return itr != _buckets[index].end() ? itr->second : empty;
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef _OBJECTFIELDINDEX_H
+#define _OBJECTFIELDINDEX_H
+
+#include "Define.h"
+#include "ObjectGuid.h"
+#include "UpdateFieldSink.h"
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+struct ObjectGuidHash
+{
+    std::size_t operator()(ObjectGuid const& guid) const
+    {
+        return std::hash<uint64>()(guid._low ^ (guid._high * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+/// Secondary indexes over decoded fields, maintained from the decode path:
+/// ObjectData::EntryID and UnitData/GameObjectData::FactionTemplate by object TypeID, GameObjectData::TypeID + State.
+/// Only decodes whose changes mask touches an indexed field do any work; queries return the bucket itself.
+class ObjectFieldIndex : public UpdateFieldSink
+{
+public:
+    explicit ObjectFieldIndex(UpdateFieldSink* next = nullptr) : UpdateFieldSink(next) { }
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    /// Call when the object is destroyed or leaves visibility.
+    void Remove(ObjectGuid const& guid);
+    void Clear();
+
+    /// Objects of a TypeID (TYPEID_UNIT, TYPEID_GAMEOBJECT, ...) with the given EntryID.
+    std::vector<ObjectGuid> const& GetByEntry(uint8 objectTypeId, uint32 entry) const { return Find(INDEX_ENTRY, MakeKey(objectTypeId, entry)); }
+
+    /// Units or gameobjects (by TypeID) with the given faction template.
+    std::vector<ObjectGuid> const& GetByFaction(uint8 objectTypeId, uint32 factionTemplate) const { return Find(INDEX_FACTION, MakeKey(objectTypeId, factionTemplate)); }
+
+    /// Calls fn(guid) for every object of a TypeID whose faction template is in 'factionTemplates',
+    /// e.g. the templates hostile to the player.
+    template<typename Factions, typename Callback>
+    void ForEachByFactions(uint8 objectTypeId, Factions const& factionTemplates, Callback&& fn) const
+    {
+        for (uint32 factionTemplate : factionTemplates)
+            for (ObjectGuid const& guid : GetByFaction(objectTypeId, factionTemplate))
+                fn(guid);
+    }
+
+    /// Gameobjects of a GameObjectTypes value in a GOState, e.g. GAMEOBJECT_TYPE_CHEST in GO_STATE_READY.
+    std::vector<ObjectGuid> const& GetGameObjects(uint8 goType, uint8 goState) const { return Find(INDEX_GAMEOBJECT_STATE, MakeKey(goType, goState)); }
+
+private:
+    enum IndexType
+    {
+        INDEX_ENTRY,
+        INDEX_FACTION,
+        INDEX_GAMEOBJECT_STATE,
+
+        MAX_INDEX
+    };
+
+    struct Link
+    {
+        uint64 Key = 0;
+        uint32 Position = 0;
+        bool Linked = false;
+    };
+
+    struct Record
+    {
+        Link Links[MAX_INDEX];
+    };
+
+    typedef std::unordered_map<uint64, std::vector<ObjectGuid>> Buckets;
+
+    static uint64 MakeKey(uint32 group, uint32 value) { return (uint64(group) << 32) | value; }
+
+    std::vector<ObjectGuid> const& Find(IndexType index, uint64 key) const;
+    void Set(ObjectGuid const& guid, IndexType index, uint64 key);
+    void Unset(Record& record, IndexType index);
+
+    std::unordered_map<ObjectGuid, Record, ObjectGuidHash> _records;
+    Buckets _buckets[MAX_INDEX];
+};
+
+}
+
+#endif
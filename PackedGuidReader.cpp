@@ -0,0 +1,27 @@
+#include "PackedGuidReader.h"
+
+namespace UF
+{
+
+namespace PackedGuid
+{
+    ShuffleTable::ShuffleTable()
+    {
+        for (uint32 mask = 0; mask < 256; ++mask)
+        {
+            uint8 count = 0;
+            for (uint32 lane = 0; lane < 16; ++lane)
+            {
+                if (lane < 8 && (mask & (1 << lane)))
+                    Control[mask][lane] = count++;
+                else
+                    Control[mask][lane] = 0x80;
+            }
+            Count[mask] = count;
+        }
+    }
+
+    ShuffleTable const Table;
+}
+
+}
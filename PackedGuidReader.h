@@ -0,0 +1,138 @@
+#ifndef _PACKEDGUIDREADER_H
+#define _PACKEDGUIDREADER_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "ObjectGuid.h"
+#include "ReferenceDecode.h"
+#include <algorithm>
+#include <vector>
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define UF_PACKED_GUID_SIMD 1
+#endif
+
+namespace UF
+{
+
+/// Largest wire size of a packed 128-bit guid: two byte masks and up to 16 value bytes.
+std::size_t const MaxPackedGuidSize = 18;
+
+namespace PackedGuid
+{
+    /// pshufb controls expanding the bytes selected by a mask into their 8 byte lanes, 0x80 for absent bytes
+    struct ShuffleTable
+    {
+        ShuffleTable();
+
+        alignas(16) uint8 Control[256][16];
+        uint8 Count[256];
+    };
+
+    extern ShuffleTable const Table;
+
+    /// Decodes one guid from 'p'. The caller guarantees MaxPackedGuidSize readable bytes. Returns the bytes consumed.
+    inline std::size_t DecodeUnchecked(uint8 const* p, ObjectGuid& guid)
+    {
+        uint8 lowMask = p[0];
+        uint8 highMask = p[1];
+        uint8 lowCount = Table.Count[lowMask];
+#ifdef UF_PACKED_GUID_SIMD
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 2));
+        __m128i lowControl = _mm_load_si128(reinterpret_cast<__m128i const*>(Table.Control[lowMask]));
+        // absent lanes keep their high bit after the offset, so they still shuffle in zero
+        __m128i highControl = _mm_add_epi8(_mm_load_si128(reinterpret_cast<__m128i const*>(Table.Control[highMask])), _mm_set1_epi8(char(lowCount)));
+        __m128i values = _mm_shuffle_epi8(bytes, _mm_unpacklo_epi64(lowControl, highControl));
+        guid._low = uint64(_mm_cvtsi128_si64(values));
+        guid._high = uint64(_mm_cvtsi128_si64(_mm_unpackhi_epi64(values, values)));
+#else
+        uint64 low = 0, high = 0;
+        uint8 const* bytes = p + 2;
+        for (uint32 i = 0; i < 8; ++i)
+            if (lowMask & (1 << i))
+                low |= uint64(*bytes++) << (i * 8);
+        for (uint32 i = 0; i < 8; ++i)
+            if (highMask & (1 << i))
+                high |= uint64(*bytes++) << (i * 8);
+        guid._low = low;
+        guid._high = high;
+#endif
+        return 2 + lowCount + Table.Count[highMask];
+    }
+
+    /// Bounds checked decode at rpos, same result as data >> guid.
+    inline void Read(ByteBuffer& data, ObjectGuid& guid)
+    {
+#ifdef UF_WITH_DECODE_DIFF
+        if (IsReferenceDecode())
+        {
+            data >> guid;
+            return;
+        }
+#endif
+        std::size_t pos = data.rpos();
+        std::size_t size = data.size();
+        if (pos + MaxPackedGuidSize <= size)
+        {
+            data.rpos(pos + DecodeUnchecked(data.contents() + pos, guid));
+            return;
+        }
+        data >> guid;
+    }
+}
+
+/// Reads 'count' consecutive packed guids into values[0..count). 'values' may be any indexable container of ObjectGuid.
+/// Runs that are guaranteed to be in bounds are decoded without per-guid checks.
+template<typename Values>
+void ReadPackedGuids(ByteBuffer& data, Values& values, std::size_t count)
+{
+#ifdef UF_WITH_DECODE_DIFF
+    if (IsReferenceDecode())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            data >> values[i];
+        return;
+    }
+#endif
+    std::size_t i = 0;
+    while (i < count)
+    {
+        std::size_t pos = data.rpos();
+        std::size_t safe = (data.size() - pos) / MaxPackedGuidSize;
+        if (!safe)
+        {
+            PackedGuid::Read(data, values[i++]);
+            continue;
+        }
+
+        uint8 const* p = data.contents() + pos;
+        uint8 const* start = p;
+        for (std::size_t end = std::min(count, i + safe); i < end; ++i)
+            p += PackedGuid::DecodeUnchecked(p, values[i]);
+        data.rpos(pos + std::size_t(p - start));
+    }
+}
+
+/// Reads consecutive packed guids into separate fields, e.g. the guid links of UnitData.
+inline void ReadPackedGuidFields(ByteBuffer& data, ObjectGuid* const* targets, std::size_t count)
+{
+    struct Targets
+    {
+        ObjectGuid* const* Fields;
+        ObjectGuid& operator[](std::size_t index) { return *Fields[index]; }
+    } fields = { targets };
+    ReadPackedGuids(data, fields, count);
+}
+
+/// Batch API for guid lists of other packets: appends 'count' packed guids to 'guids'.
+inline void ReadPackedGuidList(ByteBuffer& data, std::vector<ObjectGuid>& guids, std::size_t count)
+{
+    std::size_t first = guids.size();
+    guids.resize(first + count);
+    ObjectGuid* values = guids.data() + first;
+    ReadPackedGuids(data, values, count);
+}
+
+}
+
+#endif
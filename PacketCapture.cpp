@@ -0,0 +1,100 @@
+#include "PacketCapture.h"
+#include <cstring>
+
+bool CaptureWriter::Open(std::string const& path, uint32 build, uint64 startTime)
+{
+    Close();
+    _file = fopen(path.c_str(), "wb");
+    if (!_file)
+        return false;
+
+    memset(&_header, 0, sizeof(_header));
+    memcpy(_header.Magic, "UFPC", 4);
+    _header.Version = CAPTURE_VERSION;
+    _header.Build = build;
+    _header.StartTime = startTime;
+    _index.clear();
+    _offset = sizeof(_header);
+
+    // placeholder, rewritten by Close
+    return fwrite(&_header, sizeof(_header), 1, _file) == 1;
+}
+
+bool CaptureWriter::Write(uint16 opcode, uint32 time, uint8 const* data, uint32 size)
+{
+    if (!_file)
+        return false;
+
+    if (size && fwrite(data, size, 1, _file) != 1)
+        return false;
+
+    CaptureIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.Offset = _offset;
+    entry.Time = time;
+    entry.Size = size;
+    entry.Opcode = opcode;
+    _index.push_back(entry);
+    _offset += size;
+    return true;
+}
+
+bool CaptureWriter::Close()
+{
+    if (!_file)
+        return false;
+
+    // the index is used in place by readers, keep it aligned
+    static uint8 const padding[alignof(CaptureIndexEntry)] = { };
+    uint32 padSize = uint32((alignof(CaptureIndexEntry) - _offset % alignof(CaptureIndexEntry)) % alignof(CaptureIndexEntry));
+    bool ok = !padSize || fwrite(padding, padSize, 1, _file) == 1;
+    _offset += padSize;
+
+    _header.PacketCount = _index.size();
+    _header.IndexOffset = _offset;
+    ok = ok && (_index.empty() || fwrite(_index.data(), sizeof(CaptureIndexEntry), _index.size(), _file) == _index.size())
+        && fseek(_file, 0, SEEK_SET) == 0
+        && fwrite(&_header, sizeof(_header), 1, _file) == 1;
+    ok = fclose(_file) == 0 && ok;
+    _file = nullptr;
+    _index.clear();
+    return ok;
+}
+
+CaptureFile::CaptureFile() : _index(nullptr), _count(0)
+{
+}
+
+bool CaptureFile::Open(std::string const& path)
+{
+    Close();
+    if (!_file.Open(path, MappedFile::ACCESS_SEQUENTIAL))
+        return false;
+
+    uint64 size = _file.GetSize();
+    if (size < sizeof(CaptureHeader))
+    {
+        Close();
+        return false;
+    }
+
+    CaptureHeader const& header = GetHeader();
+    if (memcmp(header.Magic, "UFPC", 4) != 0 || header.Version != CAPTURE_VERSION
+        || header.IndexOffset < sizeof(CaptureHeader) || header.IndexOffset > size || header.PacketCount > (size - header.IndexOffset) / sizeof(CaptureIndexEntry)
+        || header.IndexOffset % alignof(CaptureIndexEntry))
+    {
+        Close();
+        return false;
+    }
+
+    _index = reinterpret_cast<CaptureIndexEntry const*>(_file.GetData() + header.IndexOffset);
+    _count = header.PacketCount;
+    return true;
+}
+
+void CaptureFile::Close()
+{
+    _file.Close();
+    _index = nullptr;
+    _count = 0;
+}
@@ -0,0 +1,94 @@
+#ifndef _PACKETCAPTURE_H
+#define _PACKETCAPTURE_H
+
+#include "Define.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// On disk capture of server packets, little endian:
+///   CaptureHeader | payloads, back to back | CaptureIndexEntry[PacketCount]
+/// The index is written last so captures can be streamed to disk; readers map the whole file and use it in place.
+struct CaptureHeader
+{
+    char Magic[4];                  // "UFPC"
+    uint32 Version;
+    uint32 Build;                   // client build the capture was taken with
+    uint32 Reserved;
+    uint64 PacketCount;
+    uint64 IndexOffset;
+    uint64 StartTime;               // unix time in ms of the first packet
+};
+
+struct CaptureIndexEntry
+{
+    uint64 Offset;                  // payload offset from the start of the file
+    uint32 Time;                    // ms since the first packet
+    uint32 Size;
+    uint16 Opcode;                  // OpcodeServer
+    uint16 Flags;
+    uint32 Reserved;
+};
+
+static_assert(sizeof(CaptureHeader) == 40, "capture header layout");
+static_assert(sizeof(CaptureIndexEntry) == 24, "capture index layout");
+
+uint32 const CAPTURE_VERSION = 1;
+
+/// Streams packets into a capture file.
+class CaptureWriter
+{
+public:
+    CaptureWriter() : _file(nullptr), _offset(0) { }
+    ~CaptureWriter() { Close(); }
+
+    CaptureWriter(CaptureWriter const&) = delete;
+    CaptureWriter& operator=(CaptureWriter const&) = delete;
+
+    bool Open(std::string const& path, uint32 build, uint64 startTime);
+    bool Write(uint16 opcode, uint32 time, uint8 const* data, uint32 size);
+
+    /// Appends the index and completes the header. Until then the file is not a valid capture.
+    bool Close();
+
+private:
+    FILE* _file;
+    uint64 _offset;
+    CaptureHeader _header;
+    std::vector<CaptureIndexEntry> _index;
+};
+
+/// Read only mapping of a capture file. Opening only validates the header and the index bounds.
+class CaptureFile
+{
+public:
+    CaptureFile();
+    ~CaptureFile() { Close(); }
+
+    CaptureFile(CaptureFile const&) = delete;
+    CaptureFile& operator=(CaptureFile const&) = delete;
+
+    bool Open(std::string const& path);
+    void Close();
+
+    bool IsOpen() const { return _file.IsOpen(); }
+    CaptureHeader const& GetHeader() const { return *reinterpret_cast<CaptureHeader const*>(_file.GetData()); }
+    uint64 GetPacketCount() const { return _count; }
+    CaptureIndexEntry const& GetEntry(uint64 index) const { return _index[index]; }
+    uint8 const* GetPayload(CaptureIndexEntry const& entry) const { return _file.GetData() + entry.Offset; }
+
+    /// Entries are not checked at open, which would touch the whole index; check them as they are used.
+    bool IsValid(CaptureIndexEntry const& entry) const
+    {
+        uint64 end = GetHeader().IndexOffset;
+        return entry.Offset <= end && entry.Size <= end - entry.Offset;
+    }
+
+private:
+    MappedFile _file;
+    CaptureIndexEntry const* _index;
+    uint64 _count;
+};
+
+#endif
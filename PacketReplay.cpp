@@ -0,0 +1,140 @@
+#include "PacketReplay.h"
+#include "AllocationAccounting.h"
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <thread>
+
+PacketReplay::PacketReplay() : _handlers(NUM_OPCODE_HANDLERS), _viewHandlers(NUM_OPCODE_HANDLERS), _stats(NUM_OPCODE_HANDLERS), _useCounters(false)
+{
+}
+
+void PacketReplay::SetHandler(OpcodeServer opcode, Handler handler)
+{
+    _handlers[opcode] = std::move(handler);
+    _viewHandlers[opcode] = nullptr;
+}
+
+void PacketReplay::SetHandler(OpcodeServer opcode, ViewHandler handler)
+{
+    _viewHandlers[opcode] = std::move(handler);
+    _handlers[opcode] = nullptr;
+}
+
+void PacketReplay::ResetStats()
+{
+    for (OpcodeStats& stats : _stats)
+        stats = OpcodeStats();
+}
+
+bool PacketReplay::SetHardwareCounters(bool enabled)
+{
+    _useCounters = enabled && PerfCounterGroup::ForThread().IsAvailable();
+    return _useCounters == enabled;
+}
+
+std::string PacketReplay::DumpStats() const
+{
+    std::string dump;
+    for (uint32 opcode = 0; opcode < _stats.size(); ++opcode)
+    {
+        OpcodeStats const& stats = _stats[opcode];
+        if (!stats.Packets)
+            continue;
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s: %llu packets, avg %.0fns, avg %.1f bytes, %llu errors",
+            GetOpcodeNameForLogging(OpcodeServer(opcode)).c_str(), (unsigned long long)stats.Packets,
+            double(stats.Nanoseconds) / double(stats.Packets), double(stats.Bytes) / double(stats.Packets),
+            (unsigned long long)stats.Errors);
+        dump += line;
+        if (stats.CountedPackets)
+        {
+            double packets = double(stats.CountedPackets);
+            double cycles = double(stats.Counters[PERF_COUNTER_CYCLES]);
+            snprintf(line, sizeof(line), ", %.0f cycles, IPC %.2f, %.1f branch-misses, %.1f L1D-misses, %.1f LLC-misses per packet",
+                cycles / packets, cycles > 0.0 ? double(stats.Counters[PERF_COUNTER_INSTRUCTIONS]) / cycles : 0.0,
+                double(stats.Counters[PERF_COUNTER_BRANCH_MISSES]) / packets, double(stats.Counters[PERF_COUNTER_L1D_MISSES]) / packets,
+                double(stats.Counters[PERF_COUNTER_LLC_MISSES]) / packets);
+            dump += line;
+        }
+        dump += '\n';
+    }
+    return dump;
+}
+
+PacketReplay::Summary PacketReplay::Run(CaptureFile const& capture, ReplaySpeed speed)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Summary summary;
+    Clock::time_point start = Clock::now();
+    for (uint64 i = 0; i < capture.GetPacketCount(); ++i)
+    {
+        CaptureIndexEntry const& entry = capture.GetEntry(i);
+        if (!capture.IsValid(entry) || entry.Opcode > MAX_OPCODE)
+        {
+            ++summary.Invalid;
+            continue;
+        }
+
+        OpcodeServer opcode = OpcodeServer(entry.Opcode);
+        if (!opcodeTable[opcode])
+        {
+            ++summary.Unknown;
+            continue;
+        }
+
+        Handler const& handler = _handlers[opcode];
+        ViewHandler const& viewHandler = _viewHandlers[opcode];
+        if (!handler && !viewHandler)
+        {
+            ++summary.Unhandled;
+            continue;
+        }
+
+        if (speed == REPLAY_SPEED_ORIGINAL)
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(entry.Time));
+
+        uint8 const* payload = capture.GetPayload(entry);
+        if (!viewHandler)
+        {
+            _packet.clear();
+            _packet.append(payload, entry.Size);
+        }
+
+        OpcodeStats& stats = _stats[opcode];
+        UF::AllocationAccounting::Totals allocationsBefore = UF::AllocationAccounting::GetThreadTotals();
+        PerfCounterValues countersBefore;
+        bool counted = _useCounters && PerfCounterGroup::ForThread().Read(countersBefore);
+        Clock::time_point handlerStart = Clock::now();
+        try
+        {
+            UF::AllocationOpcodeScope allocationScope(opcode);
+            if (viewHandler)
+                viewHandler(payload, entry.Size);
+            else
+                handler(_packet);
+        }
+        catch (std::exception const&)
+        {
+            ++stats.Errors;
+        }
+        stats.Nanoseconds += uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - handlerStart).count());
+        PerfCounterValues countersAfter;
+        if (counted && PerfCounterGroup::ForThread().Read(countersAfter))
+        {
+            stats.Counters += countersAfter - countersBefore;
+            ++stats.CountedPackets;
+        }
+        UF::AllocationAccounting::Totals allocationsAfter = UF::AllocationAccounting::GetThreadTotals();
+        stats.Allocations += allocationsAfter.Count - allocationsBefore.Count;
+        stats.AllocatedBytes += allocationsAfter.Bytes - allocationsBefore.Bytes;
+        ++stats.Packets;
+        stats.Bytes += entry.Size;
+        ++summary.Dispatched;
+    }
+
+    summary.Nanoseconds = uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    return summary;
+}
@@ -0,0 +1,78 @@
+#ifndef _PACKETREPLAY_H
+#define _PACKETREPLAY_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "Opcodes.h"
+#include "PacketCapture.h"
+#include "PerfCounters.h"
+#include <string>
+#include <functional>
+#include <vector>
+
+/// Replays a mapped capture through opcodeTable and the registered packet handlers, e.g. the
+/// SMSG_UPDATE_OBJECT handler running the UF decoders.
+/// Opcodes without an opcodeTable entry are skipped like the live session skips them.
+class PacketReplay
+{
+public:
+    typedef std::function<void(ByteBuffer& packet)> Handler;
+    /// Reads the payload in place inside the mapped capture, it stays valid until the handler returns.
+    typedef std::function<void(uint8 const* payload, std::size_t size)> ViewHandler;
+
+    enum ReplaySpeed
+    {
+        REPLAY_SPEED_MAX,                   // back to back
+        REPLAY_SPEED_ORIGINAL               // at the captured packet times
+    };
+
+    struct OpcodeStats
+    {
+        uint64 Packets = 0;
+        uint64 Bytes = 0;
+        uint64 Nanoseconds = 0;             // time spent in the handler
+        uint64 Errors = 0;                  // handlers that threw, the replay continues with the next packet
+        uint64 Allocations = 0;             // heap allocations of the handler, only counted with UF_WITH_ALLOC_ACCOUNTING
+        uint64 AllocatedBytes = 0;
+        uint64 CountedPackets = 0;          // packets measured with hardware counters
+        PerfCounterValues Counters;         // summed over the counted packets
+    };
+
+    struct Summary
+    {
+        uint64 Dispatched = 0;
+        uint64 Unhandled = 0;               // no handler registered
+        uint64 Unknown = 0;                 // not in opcodeTable
+        uint64 Invalid = 0;                 // index entries pointing outside the payload area
+        uint64 Nanoseconds = 0;
+    };
+
+    PacketReplay();
+
+    /// A ByteBuffer owns its storage, each packet is copied into one reused buffer before the handler runs.
+    void SetHandler(OpcodeServer opcode, Handler handler);
+    /// Replaces the opcode's Handler, the payload is passed without copying.
+    void SetHandler(OpcodeServer opcode, ViewHandler handler);
+
+    Summary Run(CaptureFile const& capture, ReplaySpeed speed = REPLAY_SPEED_MAX);
+
+    OpcodeStats const& GetStats(OpcodeServer opcode) const { return _stats[opcode]; }
+    void ResetStats();
+
+    /// Reads the hardware counters of the replay thread around every handler. Returns false and leaves
+    /// them off when they can't be opened, PerfCounterGroup::ForThread().GetError() tells why.
+    bool SetHardwareCounters(bool enabled);
+
+    /// One line per opcode that was dispatched: packets, average handler time and bytes, and the
+    /// per packet counters when they were used.
+    std::string DumpStats() const;
+
+private:
+    std::vector<Handler> _handlers;
+    std::vector<ViewHandler> _viewHandlers;
+    std::vector<OpcodeStats> _stats;
+    ByteBuffer _packet;
+    bool _useCounters;
+};
+
+#endif
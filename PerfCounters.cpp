@@ -0,0 +1,145 @@
+#include "PerfCounters.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    struct CounterEvent
+    {
+        uint32 Type;
+        uint64 Config;
+    };
+
+    uint64 const CacheReadMiss = (uint64(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+
+    CounterEvent const Events[MAX_PERF_COUNTERS] =
+    {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | CacheReadMiss },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | CacheReadMiss }
+    };
+
+    int OpenCounter(CounterEvent const& event, int groupFd)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.Type;
+        attr.config = event.Config;
+        attr.disabled = groupFd < 0 ? 1 : 0;        // the leader starts the whole group
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+    std::string DescribeOpenError(int error)
+    {
+        std::string message = std::string("perf_event_open failed: ") + strerror(error);
+        if (error == EACCES || error == EPERM)
+        {
+            if (FILE* file = fopen("/proc/sys/kernel/perf_event_paranoid", "r"))
+            {
+                int paranoid = 0;
+                if (fscanf(file, "%d", &paranoid) == 1)
+                {
+                    char buffer[96];
+                    snprintf(buffer, sizeof(buffer), " (kernel.perf_event_paranoid = %d, needs <= 2 or CAP_PERFMON)", paranoid);
+                    message += buffer;
+                }
+                fclose(file);
+            }
+        }
+        else if (error == ENOENT || error == EOPNOTSUPP)
+            message += " (no hardware counters, e.g. inside a VM without PMU passthrough)";
+        return message;
+    }
+#endif
+}
+
+PerfCounterGroup::PerfCounterGroup() : _opened(0)
+{
+    for (uint32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+    {
+        _fds[i] = -1;
+        _order[i] = 0;
+    }
+
+#ifdef __linux__
+    _fds[PERF_COUNTER_CYCLES] = OpenCounter(Events[PERF_COUNTER_CYCLES], -1);
+    if (_fds[PERF_COUNTER_CYCLES] < 0)
+    {
+        _error = DescribeOpenError(errno);
+        return;
+    }
+    _order[_opened++] = PERF_COUNTER_CYCLES;
+
+    // counters the PMU doesn't have are skipped, the rest of the group still works
+    for (uint32 i = PERF_COUNTER_CYCLES + 1; i < MAX_PERF_COUNTERS; ++i)
+    {
+        _fds[i] = OpenCounter(Events[i], _fds[PERF_COUNTER_CYCLES]);
+        if (_fds[i] >= 0)
+            _order[_opened++] = i;
+    }
+
+    ioctl(_fds[PERF_COUNTER_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(_fds[PERF_COUNTER_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    _error = "hardware counters need Linux perf_event_open";
+#endif
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+#ifdef __linux__
+    for (int fd : _fds)
+        if (fd >= 0)
+            close(fd);
+#endif
+}
+
+bool PerfCounterGroup::Read(PerfCounterValues& values) const
+{
+#ifdef __linux__
+    if (!IsAvailable())
+        return false;
+
+    // nr, time enabled, time running, then one value per opened counter
+    uint64 buffer[3 + MAX_PERF_COUNTERS];
+    ssize_t bytes = read(_fds[PERF_COUNTER_CYCLES], buffer, sizeof(buffer));
+    if (bytes < ssize_t((3 + _opened) * sizeof(uint64)) || buffer[0] != _opened || !buffer[2])
+        return false;
+
+    double scale = buffer[1] == buffer[2] ? 1.0 : double(buffer[1]) / double(buffer[2]);
+    values = PerfCounterValues();
+    for (uint32 i = 0; i < _opened; ++i)
+        values.Values[_order[i]] = scale == 1.0 ? buffer[3 + i] : uint64(double(buffer[3 + i]) * scale);
+    return true;
+#else
+    (void)values;
+    return false;
+#endif
+}
+
+PerfCounterGroup& PerfCounterGroup::ForThread()
+{
+    static thread_local PerfCounterGroup group;
+    return group;
+}
+
+char const* PerfCounterGroup::GetCounterName(PerfCounter counter)
+{
+    static char const* const Names[MAX_PERF_COUNTERS] = { "cycles", "instructions", "branch-misses", "L1D-misses", "LLC-misses" };
+    return counter < MAX_PERF_COUNTERS ? Names[counter] : "unknown";
+}
@@ -0,0 +1,75 @@
+#ifndef _PERFCOUNTERS_H
+#define _PERFCOUNTERS_H
+
+#include "Define.h"
+#include <string>
+
+enum PerfCounter
+{
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_L1D_MISSES,
+    PERF_COUNTER_LLC_MISSES,
+
+    MAX_PERF_COUNTERS
+};
+
+/// Hardware counter readings, or the difference of two readings.
+struct PerfCounterValues
+{
+    uint64 Values[MAX_PERF_COUNTERS] = { };
+
+    uint64 operator[](PerfCounter counter) const { return Values[counter]; }
+
+    PerfCounterValues& operator+=(PerfCounterValues const& other)
+    {
+        for (uint32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+            Values[i] += other.Values[i];
+        return *this;
+    }
+
+    PerfCounterValues operator-(PerfCounterValues const& other) const
+    {
+        PerfCounterValues difference;
+        for (uint32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+            difference.Values[i] = Values[i] > other.Values[i] ? Values[i] - other.Values[i] : 0;
+        return difference;
+    }
+};
+
+/// Cycles, instructions, branch misses and L1D/LLC read misses of the calling thread, user space only,
+/// opened as one perf_event_open group so all counters cover the same instructions.
+/// Counters the CPU or hypervisor doesn't expose are left at 0 (see HasCounter). When perf_event_open is
+/// missing or restricted (kernel.perf_event_paranoid, containers without CAP_PERFMON) the group is unavailable,
+/// Read returns false and GetError tells why; callers keep their wall clock numbers only.
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(PerfCounterGroup const&) = delete;
+    PerfCounterGroup& operator=(PerfCounterGroup const&) = delete;
+
+    bool IsAvailable() const { return _fds[PERF_COUNTER_CYCLES] >= 0; }
+    bool HasCounter(PerfCounter counter) const { return _fds[counter] >= 0; }
+    std::string const& GetError() const { return _error; }
+
+    /// Current totals since the group was opened, scaled up when the kernel multiplexed the group.
+    /// One read syscall, expect a microsecond or so; measure whole operations, not single fields.
+    bool Read(PerfCounterValues& values) const;
+
+    /// Group of the calling thread, opened on first use. The counters only count the thread that opened them.
+    static PerfCounterGroup& ForThread();
+
+    static char const* GetCounterName(PerfCounter counter);
+
+private:
+    int _fds[MAX_PERF_COUNTERS];
+    uint32 _order[MAX_PERF_COUNTERS];   // counter of each value in the group read, in the order they were opened
+    uint32 _opened;
+    std::string _error;
+};
+
+#endif
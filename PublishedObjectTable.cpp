@@ -0,0 +1,348 @@
+#include "PublishedObjectTable.h"
+#include "UpdateFields.h"
+#include <cstring>
+#include <new>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace UF
+{
+
+namespace
+{
+    std::size_t GetSegmentSize(uint32 slotCount)
+    {
+        return sizeof(PublishedTableHeader) + std::size_t(slotCount) * sizeof(PublishedObjectSlot);
+    }
+
+    void PublishUnit(PublishedObjectState& state, UnitData const& unit)
+    {
+        state.Race = uint8(unit.Race._value);
+        state.ClassId = uint8(unit.ClassId._value);
+        state.Sex = uint8(unit.Sex._value);
+        state.DisplayPower = uint8(unit.DisplayPower._value);
+        state.StandState = uint8(unit.StandState._value);
+        state.Health = int64(unit.Health._value);
+        state.MaxHealth = int64(unit.MaxHealth._value);
+        state.Level = int32(unit.Level._value);
+        state.EffectiveLevel = int32(unit.EffectiveLevel._value);
+        state.DisplayID = int32(unit.DisplayID._value);
+        state.MountDisplayID = int32(unit.MountDisplayID._value);
+        state.FactionTemplate = int32(unit.FactionTemplate._value);
+        state.Flags = uint32(unit.Flags._value);
+        state.Flags2 = uint32(unit.Flags2._value);
+        state.Flags3 = uint32(unit.Flags3._value);
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+            state.Power[i] = int32(unit.Power[i]);
+            state.MaxPower[i] = int32(unit.MaxPower[i]);
+        }
+        state.TargetLow = unit.Target._value._low;
+        state.TargetHigh = unit.Target._value._high;
+        state.ChannelSpellID = int32(unit.ChannelData._value.SpellID);
+        state.EmoteState = int32(unit.EmoteState._value);
+    }
+
+    void PublishPlayer(PublishedObjectState& state, PlayerData const& player)
+    {
+        state.HasPlayerData = 1;
+        state.PvpTitle = uint8(player.PvpTitle._value);
+        state.PlayerFlags = uint32(player.PlayerFlags._value);
+        state.PlayerFlagsEx = uint32(player.PlayerFlagsEx._value);
+        state.GuildRankID = uint32(player.GuildRankID._value);
+        state.CurrentSpecID = int32(player.CurrentSpecID._value);
+        state.HonorLevel = int32(player.HonorLevel._value);
+    }
+
+#ifndef _WIN32
+    /// True when 'name' is a complete table whose publisher process no longer exists. Segments that can't be
+    /// read, are still being created or belong to something else are never reclaimed.
+    bool IsAbandoned(std::string const& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && std::size_t(st.st_size) >= sizeof(PublishedTableHeader))
+            data = mmap(nullptr, sizeof(PublishedTableHeader), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        PublishedTableHeader const* header = static_cast<PublishedTableHeader const*>(data);
+        bool abandoned = false;
+        if (memcmp(header->Magic, "UFOT", 4) == 0)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            abandoned = header->Version == PUBLISHED_TABLE_VERSION && header->PublisherPid
+                && kill(pid_t(header->PublisherPid), 0) != 0 && errno == ESRCH;
+        }
+        munmap(data, sizeof(PublishedTableHeader));
+        return abandoned;
+    }
+#endif
+}
+
+ObjectTablePublisher::ObjectTablePublisher(UpdateFieldSink* next) : UpdateFieldSink(next), _header(nullptr), _slots(nullptr), _size(0), _dropped(0)
+{
+}
+
+ObjectTablePublisher::~ObjectTablePublisher()
+{
+    Close();
+}
+
+bool ObjectTablePublisher::Create(std::string const& name, uint32 slotCount, uint32 mode)
+{
+    Close();
+#ifdef _WIN32
+    (void)name;
+    (void)slotCount;
+    (void)mode;
+    return false;
+#else
+    if (!slotCount)
+        return false;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode_t(mode));
+    if (fd < 0 && errno == EEXIST && IsAbandoned(name))
+    {
+        // left behind by a crashed publisher, readers still mapping it keep the old one
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode_t(mode));
+    }
+    if (fd < 0)
+        return false;
+
+    std::size_t size = GetSegmentSize(slotCount);
+    void* data = ftruncate(fd, off_t(size)) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate zero filled the segment: every slot is free with an even sequence
+    _name = name;
+    _size = size;
+    _header = new (data) PublishedTableHeader();
+    _slots = reinterpret_cast<PublishedObjectSlot*>(static_cast<uint8*>(data) + sizeof(PublishedTableHeader));
+    _freeSlots.reserve(slotCount);
+    for (uint32 i = slotCount; i > 0; --i)
+        _freeSlots.push_back(i - 1);
+
+    _header->Version = PUBLISHED_TABLE_VERSION;
+    _header->SlotCount = slotCount;
+    _header->SlotSize = sizeof(PublishedObjectSlot);
+    _header->PublisherPid = uint32(getpid());
+    _header->Generation.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    // readers check the magic last, the header is complete once it is there
+    memcpy(_header->Magic, "UFOT", 4);
+    return true;
+#endif
+}
+
+void ObjectTablePublisher::Close()
+{
+#ifndef _WIN32
+    if (_header)
+    {
+        munmap(static_cast<void*>(_header), _size);
+        shm_unlink(_name.c_str());
+    }
+#endif
+    _header = nullptr;
+    _slots = nullptr;
+    _size = 0;
+    _slotByGuid.clear();
+    _freeSlots.clear();
+}
+
+void ObjectTablePublisher::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+    if (_header && !context.Guid.IsEmpty() && (type == UpdateFieldStruct::Unit || type == UpdateFieldStruct::Player))
+    {
+        if (PublishedObjectSlot* slot = GetSlot(context.Guid, context.ObjectTypeId))
+        {
+            // only this thread writes the slot, its current state can be read without the seqlock
+            PublishedObjectState state = slot->State;
+            if (type == UpdateFieldStruct::Unit)
+                PublishUnit(state, *static_cast<UnitData const*>(fields));
+            else
+                PublishPlayer(state, *static_cast<PlayerData const*>(fields));
+
+            BeginWrite(*slot);
+            memcpy(&slot->State, &state, sizeof(state));
+            EndWrite(*slot);
+        }
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+PublishedObjectSlot* ObjectTablePublisher::GetSlot(ObjectGuid const& guid, uint8 objectTypeId)
+{
+    auto itr = _slotByGuid.find(guid);
+    if (itr != _slotByGuid.end())
+        return &_slots[itr->second];
+
+    if (_freeSlots.empty())
+    {
+        ++_dropped;
+        return nullptr;
+    }
+
+    uint32 index = _freeSlots.back();
+    _freeSlots.pop_back();
+    _slotByGuid[guid] = index;
+
+    PublishedObjectSlot& slot = _slots[index];
+    PublishedObjectState state;
+    memset(&state, 0, sizeof(state));
+    state.GuidLow = guid._low;
+    state.GuidHigh = guid._high;
+    state.TypeId = objectTypeId;
+    BeginWrite(slot);
+    memcpy(&slot.State, &state, sizeof(state));
+    EndWrite(slot);
+    _header->Generation.fetch_add(1, std::memory_order_release);
+    return &slot;
+}
+
+void ObjectTablePublisher::Remove(ObjectGuid const& guid)
+{
+    auto itr = _slotByGuid.find(guid);
+    if (itr == _slotByGuid.end())
+        return;
+
+    PublishedObjectSlot& slot = _slots[itr->second];
+    BeginWrite(slot);
+    memset(&slot.State, 0, sizeof(slot.State));
+    EndWrite(slot);
+    _freeSlots.push_back(itr->second);
+    _slotByGuid.erase(itr);
+    _header->Generation.fetch_add(1, std::memory_order_release);
+}
+
+void ObjectTablePublisher::Clear()
+{
+    while (!_slotByGuid.empty())
+        Remove(_slotByGuid.begin()->first);
+}
+
+void ObjectTablePublisher::BeginWrite(PublishedObjectSlot& slot)
+{
+    slot.Sequence.store(slot.Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ObjectTablePublisher::EndWrite(PublishedObjectSlot& slot)
+{
+    slot.Sequence.store(slot.Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+ObjectTableReader::ObjectTableReader() : _header(nullptr), _slots(nullptr), _size(0)
+{
+}
+
+bool ObjectTableReader::Open(std::string const& name)
+{
+    Close();
+#ifdef _WIN32
+    (void)name;
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && std::size_t(st.st_size) >= sizeof(PublishedTableHeader))
+        data = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    _size = std::size_t(st.st_size);
+    _header = static_cast<PublishedTableHeader const*>(data);
+    _slots = reinterpret_cast<PublishedObjectSlot const*>(static_cast<uint8 const*>(data) + sizeof(PublishedTableHeader));
+    if (memcmp(_header->Magic, "UFOT", 4) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_header->Version != PUBLISHED_TABLE_VERSION || _header->SlotSize != sizeof(PublishedObjectSlot)
+        || _size < GetSegmentSize(_header->SlotCount))
+    {
+        Close();
+        return false;
+    }
+    return true;
+#endif
+}
+
+void ObjectTableReader::Close()
+{
+#ifndef _WIN32
+    if (_header)
+        munmap(const_cast<PublishedTableHeader*>(_header), _size);
+#endif
+    _header = nullptr;
+    _slots = nullptr;
+    _size = 0;
+}
+
+bool ObjectTableReader::Read(uint32 slot, PublishedObjectState& state, uint32 retries) const
+{
+    if (slot >= GetSlotCount())
+        return false;
+
+    PublishedObjectSlot const& published = _slots[slot];
+    for (uint32 attempt = 0; attempt < retries; ++attempt)
+    {
+        uint32 before = published.Sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        memcpy(&state, &published.State, sizeof(state));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (published.Sequence.load(std::memory_order_relaxed) == before)
+            return state.GuidLow || state.GuidHigh;
+    }
+    return false;
+}
+
+bool ObjectTableReader::Find(ObjectGuid const& guid, PublishedObjectState& state, uint32* slot) const
+{
+    for (uint32 i = 0; i < GetSlotCount(); ++i)
+    {
+        // cheap unlocked peek first, the seqlock read confirms the match
+        PublishedObjectState const& peek = _slots[i].State;
+        if (peek.GuidLow != guid._low || peek.GuidHigh != guid._high)
+            continue;
+
+        if (Read(i, state) && state.GuidLow == guid._low && state.GuidHigh == guid._high)
+        {
+            if (slot)
+                *slot = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
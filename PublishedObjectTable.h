@@ -0,0 +1,170 @@
+#ifndef _PUBLISHEDOBJECTTABLE_H
+#define _PUBLISHEDOBJECTTABLE_H
+
+#include "Define.h"
+#include "ObjectFieldIndex.h"
+#include "ObjectGuid.h"
+#include "UpdateFieldSink.h"
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// Hot UnitData/PlayerData fields of one object as published to other processes. Plain data, the same layout
+/// in every process built from this header; SlotSize in the table header guards against mismatches.
+struct PublishedObjectState
+{
+    uint64 GuidLow;
+    uint64 GuidHigh;                    // both 0 while the slot is free
+    uint8 TypeId;
+    uint8 Race;
+    uint8 ClassId;
+    uint8 Sex;
+    uint8 DisplayPower;
+    uint8 StandState;
+    uint8 PvpTitle;
+    uint8 HasPlayerData;                // the Player* fields below are valid
+    int64 Health;
+    int64 MaxHealth;
+    int32 Level;
+    int32 EffectiveLevel;
+    int32 DisplayID;
+    int32 MountDisplayID;
+    int32 FactionTemplate;
+    uint32 Flags;
+    uint32 Flags2;
+    uint32 Flags3;
+    int32 Power[10];
+    int32 MaxPower[10];
+    uint64 TargetLow;
+    uint64 TargetHigh;
+    int32 ChannelSpellID;
+    int32 EmoteState;
+    uint32 PlayerFlags;
+    uint32 PlayerFlagsEx;
+    uint32 GuildRankID;
+    int32 CurrentSpecID;
+    int32 HonorLevel;
+    uint32 Reserved;
+};
+
+static_assert(std::is_trivially_copyable<PublishedObjectState>::value, "published state is copied with memcpy");
+static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32) && sizeof(std::atomic<uint64>) == sizeof(uint64),
+    "atomics in shared memory must be plain words");
+
+/// One object. Sequence is a seqlock: odd while the publisher writes State, bumped twice per write.
+struct alignas(64) PublishedObjectSlot
+{
+    std::atomic<uint32> Sequence;
+    uint32 Reserved;
+    PublishedObjectState State;
+};
+
+/// Start of the shared memory segment, followed by SlotCount slots.
+struct alignas(64) PublishedTableHeader
+{
+    char Magic[4];                      // "UFOT"
+    uint32 Version;
+    uint32 SlotCount;
+    uint32 SlotSize;                    // sizeof(PublishedObjectSlot)
+    uint32 PublisherPid;                // process serving the segment, a dead one lets the name be reclaimed
+    std::atomic<uint64> Generation;     // bumped whenever a slot is assigned to another object or freed
+};
+
+uint32 const PUBLISHED_TABLE_VERSION = 2;
+
+/// Publishes the hot fields of decoded units and players into a POSIX shared memory segment ("/name").
+/// Plug it into the decode sink chain like ObjectFieldIndex; every UnitData/PlayerData decode rewrites the
+/// object's slot under its seqlock, so readers in other processes never block the decoder and never see a torn
+/// state. Like ObjectFieldIndex it must be fed by one decode thread at a time.
+/// Not available on Windows, Create fails there.
+class ObjectTablePublisher : public UpdateFieldSink
+{
+public:
+    explicit ObjectTablePublisher(UpdateFieldSink* next = nullptr);
+    ~ObjectTablePublisher();
+
+    ObjectTablePublisher(ObjectTablePublisher const&) = delete;
+    ObjectTablePublisher& operator=(ObjectTablePublisher const&) = delete;
+
+    /// Creates the segment with permission bits 'mode', owner only by default: readers running as another
+    /// user need a wider mode. Fails while another live publisher serves 'name'; a segment left behind by
+    /// a publisher process that is gone is replaced. It is unlinked again by Close.
+    bool Create(std::string const& name, uint32 slotCount, uint32 mode = 0600);
+    void Close();
+
+    bool IsOpen() const { return _header != nullptr; }
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    /// Call when the object is destroyed or leaves visibility, frees its slot.
+    void Remove(ObjectGuid const& guid);
+    void Clear();
+
+    /// Decodes not published because every slot was taken.
+    uint64 GetDroppedCount() const { return _dropped; }
+
+private:
+    PublishedObjectSlot* GetSlot(ObjectGuid const& guid, uint8 objectTypeId);
+    static void BeginWrite(PublishedObjectSlot& slot);
+    static void EndWrite(PublishedObjectSlot& slot);
+
+    std::string _name;
+    PublishedTableHeader* _header;
+    PublishedObjectSlot* _slots;
+    std::size_t _size;
+    std::unordered_map<ObjectGuid, uint32, ObjectGuidHash> _slotByGuid;
+    std::vector<uint32> _freeSlots;
+    uint64 _dropped;
+};
+
+/// Read only view of a segment created by ObjectTablePublisher, for other processes.
+class ObjectTableReader
+{
+public:
+    ObjectTableReader();
+    ~ObjectTableReader() { Close(); }
+
+    ObjectTableReader(ObjectTableReader const&) = delete;
+    ObjectTableReader& operator=(ObjectTableReader const&) = delete;
+
+    /// Fails when the segment doesn't exist or was built with another layout.
+    bool Open(std::string const& name);
+    void Close();
+
+    bool IsOpen() const { return _header != nullptr; }
+    uint32 GetSlotCount() const { return _header ? _header->SlotCount : 0; }
+
+    /// Changes whenever slots change owner; cached guid -> slot lookups are stale once it moved.
+    uint64 GetGeneration() const { return _header->Generation.load(std::memory_order_acquire); }
+
+    /// Consistent copy of a slot. Returns false for free slots, or when the publisher kept writing
+    /// the slot for all 'retries' attempts.
+    bool Read(uint32 slot, PublishedObjectState& state, uint32 retries = 64) const;
+
+    /// Scans the table for 'guid', stores its slot in 'slot' for later Read calls.
+    bool Find(ObjectGuid const& guid, PublishedObjectState& state, uint32* slot = nullptr) const;
+
+    /// Calls fn(slot, state) for every published object.
+    template<typename Callback>
+    void ForEach(Callback&& fn) const
+    {
+        PublishedObjectState state;
+        for (uint32 i = 0; i < GetSlotCount(); ++i)
+            if (Read(i, state))
+                fn(i, state);
+    }
+
+private:
+    PublishedTableHeader const* _header;
+    PublishedObjectSlot const* _slots;
+    std::size_t _size;
+};
+
+}
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef _QUESTCOMPLETEDBITS_H
+#define _QUESTCOMPLETEDBITS_H
+
+#include "Define.h"
+#include "UpdateFields.h"
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#define UF_QUEST_BITS_SIMD 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace UF
+{
+
+uint32 const QUEST_COMPLETED_WORDS = 875;
+uint32 const MAX_QUEST_COMPLETED_BITS = QUEST_COMPLETED_WORDS * 64;
+
+namespace QuestBits
+{
+    inline uint32 CountTrailingZeros(uint64 value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return uint32(index);
+#else
+        return uint32(__builtin_ctzll(value));
+#endif
+    }
+
+    inline uint32 PopCount(uint64 value)
+    {
+#if defined(_MSC_VER)
+        return uint32(__popcnt64(value));
+#else
+        return uint32(__builtin_popcountll(value));
+#endif
+    }
+
+    /// Calls fn(questBit) for every bit of 'bits', 'index' being the word the bits belong to.
+    template<typename Callback>
+    void ForEachBit(uint32 index, uint64 bits, Callback&& fn)
+    {
+        while (bits)
+        {
+            uint32 bit = CountTrailingZeros(bits);
+            bits &= bits - 1;
+            fn(index * 64 + bit + 1);
+        }
+    }
+}
+
+/// Completed quests are stored by quest bit (QuestV2 UniqueBitFlag), 1-based like on the server side.
+inline bool IsQuestBitSet(uint64 const* words, uint32 questBit)
+{
+    if (!questBit || questBit > MAX_QUEST_COMPLETED_BITS)
+        return false;
+    --questBit;
+    return (words[questBit >> 6] & (uint64(1) << (questBit & 63))) != 0;
+}
+
+inline uint32 CountQuestBits(uint64 const* words, uint32 count = QUEST_COMPLETED_WORDS)
+{
+    uint32 total = 0;
+    for (uint32 i = 0; i < count; ++i)
+        total += QuestBits::PopCount(words[i]);
+    return total;
+}
+
+/// Compares two snapshots and calls onChanged(wordIndex, oldWord, newWord) for every word that gained bits.
+/// Unchanged words are skipped two at a time with a vector xor. Returns the number of newly set bits.
+template<typename Callback>
+uint32 DiffQuestBits(uint64 const* oldWords, uint64 const* newWords, uint32 count, Callback&& onChanged)
+{
+    uint32 added = 0;
+    uint32 i = 0;
+#ifdef UF_QUEST_BITS_SIMD
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i before = _mm_loadu_si128(reinterpret_cast<__m128i const*>(oldWords + i));
+        __m128i after = _mm_loadu_si128(reinterpret_cast<__m128i const*>(newWords + i));
+        __m128i changed = _mm_xor_si128(before, after);
+        if (_mm_testz_si128(changed, changed))
+            continue;
+
+        for (uint32 j = i; j < i + 2; ++j)
+        {
+            uint64 gained = newWords[j] & ~oldWords[j];
+            if (gained)
+            {
+                added += QuestBits::PopCount(gained);
+                onChanged(j, oldWords[j], newWords[j]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        uint64 gained = newWords[i] & ~oldWords[i];
+        if (gained)
+        {
+            added += QuestBits::PopCount(gained);
+            onChanged(i, oldWords[i], newWords[i]);
+        }
+    }
+    return added;
+}
+
+/// Calls fn(questBit) for every set bit, in ascending order.
+template<typename Callback>
+void ForEachQuestBit(uint64 const* words, uint32 count, Callback&& fn)
+{
+    for (uint32 i = 0; i < count; ++i)
+        QuestBits::ForEachBit(i, words[i], fn);
+}
+
+/// Mirror of ActivePlayerData::QuestCompleted for quest availability checks.
+/// Sync diffs the decoded words against the mirror and reports only quests that became completed.
+class QuestCompletedIndex
+{
+public:
+    QuestCompletedIndex() : _completedCount(0)
+    {
+        for (uint64& word : _words)
+            word = 0;
+    }
+
+    bool IsQuestCompleted(uint32 questBit) const { return IsQuestBitSet(_words, questBit); }
+    uint32 GetCompletedCount() const { return _completedCount; }
+
+    template<typename Callback>
+    void ForEachCompleted(Callback&& fn) const { ForEachQuestBit(_words, QUEST_COMPLETED_WORDS, fn); }
+
+    /// Calls onCompleted(questBit) for each quest completed since the previous Sync. Returns their number.
+    template<typename Callback>
+    uint32 Sync(ActivePlayerData const& data, Callback&& onCompleted)
+    {
+        uint64 current[QUEST_COMPLETED_WORDS];
+        for (uint32 i = 0; i < QUEST_COMPLETED_WORDS; ++i)
+            current[i] = data.QuestCompleted[i];
+
+        uint32 added = DiffQuestBits(_words, current, QUEST_COMPLETED_WORDS, [&](uint32 index, uint64 oldWord, uint64 newWord)
+        {
+            QuestBits::ForEachBit(index, newWord & ~oldWord, onCompleted);
+        });
+
+        for (uint32 i = 0; i < QUEST_COMPLETED_WORDS; ++i)
+            _words[i] = current[i];
+        _completedCount = CountQuestBits(_words);
+        return added;
+    }
+
+    uint32 Sync(ActivePlayerData const& data) { return Sync(data, [](uint32) { }); }
+
+private:
+    uint64 _words[QUEST_COMPLETED_WORDS];
+    uint32 _completedCount;
+};
+
+/// Direct lookup on decoded fields, without a mirror.
+inline bool IsQuestCompleted(ActivePlayerData const& data, uint32 questBit)
+{
+    if (!questBit || questBit > MAX_QUEST_COMPLETED_BITS)
+        return false;
+    --questBit;
+    return (uint64(data.QuestCompleted[questBit >> 6]) & (uint64(1) << (questBit & 63))) != 0;
+}
+
+}
+
+#endif
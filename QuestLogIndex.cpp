@@ -0,0 +1,123 @@
+#include "QuestLogIndex.h"
+#include "Timer.h"
+
+namespace UF
+{
+
+QuestLogIndex::QuestLogIndex(IStatUpdate* next) : StatUpdateForwarder(next)
+{
+    Clear();
+}
+
+void QuestLogIndex::Clear()
+{
+    for (uint32 slot = 0; slot < MAX_QUEST_LOG_SLOTS; ++slot)
+        ResetSlot(slot, 0);
+    _slotByQuest.clear();
+    _incompleteSlots = 0;
+}
+
+void QuestLogIndex::ResetSlot(uint32 slot, uint32 questId)
+{
+    Slot& entry = _slots[slot];
+    entry.QuestId = questId;
+    entry.Incomplete = 0;
+    for (uint32 i = 0; i < MAX_QUEST_LOG_OBJECTIVES; ++i)
+    {
+        entry.Progress[i] = 0;
+        entry.ChangeTime[i] = 0;
+    }
+}
+
+void QuestLogIndex::OnPlayerQuestLogId(uint32 old, uint32 value, uint32 index)
+{
+    if (index < MAX_QUEST_LOG_SLOTS)
+    {
+        auto itr = _slotByQuest.find(old);
+        if (itr != _slotByQuest.end() && itr->second == index)
+            _slotByQuest.erase(itr);
+
+        ResetSlot(index, value);
+        if (value)
+            _slotByQuest[value] = uint8(index);
+        RefreshIncomplete(index);
+    }
+
+    StatUpdateForwarder::OnPlayerQuestLogId(old, value, index);
+}
+
+void QuestLogIndex::OnPlayerQuestLogCount(uint32 old, uint32 value, uint32 index, uint32 objective)
+{
+    if (index < MAX_QUEST_LOG_SLOTS && objective < MAX_QUEST_LOG_OBJECTIVES)
+    {
+        Slot& entry = _slots[index];
+        entry.Progress[objective] = uint16(value);
+        entry.ChangeTime[objective] = getMSTime();
+        RefreshIncomplete(index, objective);
+    }
+
+    StatUpdateForwarder::OnPlayerQuestLogCount(old, value, index, objective);
+}
+
+void QuestLogIndex::SetObjectiveRequirements(uint32 questId, std::vector<uint16> required)
+{
+    if (required.size() > MAX_QUEST_LOG_OBJECTIVES)
+        required.resize(MAX_QUEST_LOG_OBJECTIVES);
+    _requirements[questId] = std::move(required);
+
+    int32 slot = FindSlot(questId);
+    if (slot >= 0)
+        RefreshIncomplete(uint32(slot));
+}
+
+void QuestLogIndex::RefreshIncomplete(uint32 slot)
+{
+    for (uint32 i = 0; i < MAX_QUEST_LOG_OBJECTIVES; ++i)
+        RefreshIncomplete(slot, i);
+}
+
+void QuestLogIndex::RefreshIncomplete(uint32 slot, uint32 objective)
+{
+    Slot& entry = _slots[slot];
+    bool incomplete = false;
+    if (entry.QuestId)
+    {
+        auto itr = _requirements.find(entry.QuestId);
+        if (itr != _requirements.end() && objective < itr->second.size())
+            incomplete = entry.Progress[objective] < itr->second[objective];
+    }
+
+    if (incomplete)
+        entry.Incomplete |= 1u << objective;
+    else
+        entry.Incomplete &= ~(1u << objective);
+
+    if (entry.Incomplete)
+        _incompleteSlots |= 1u << slot;
+    else
+        _incompleteSlots &= ~(1u << slot);
+}
+
+uint16 QuestLogIndex::GetObjectiveProgress(uint32 questId, uint32 objective) const
+{
+    int32 slot = FindSlot(questId);
+    if (slot < 0 || objective >= MAX_QUEST_LOG_OBJECTIVES)
+        return 0;
+    return _slots[slot].Progress[objective];
+}
+
+uint32 QuestLogIndex::GetObjectiveChangeTime(uint32 questId, uint32 objective) const
+{
+    int32 slot = FindSlot(questId);
+    if (slot < 0 || objective >= MAX_QUEST_LOG_OBJECTIVES)
+        return 0;
+    return _slots[slot].ChangeTime[objective];
+}
+
+uint32 QuestLogIndex::GetIncompleteObjectives(uint32 questId) const
+{
+    int32 slot = FindSlot(questId);
+    return slot >= 0 ? _slots[slot].Incomplete : 0;
+}
+
+}
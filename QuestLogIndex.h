@@ -0,0 +1,75 @@
+#ifndef _QUESTLOGINDEX_H
+#define _QUESTLOGINDEX_H
+
+#include "Define.h"
+#include "StatUpdateRecorder.h"
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+uint32 const MAX_QUEST_LOG_SLOTS = 25;
+uint32 const MAX_QUEST_LOG_OBJECTIVES = 24;
+
+/// Incrementally maintained view of PlayerData::QuestLog, fed by the quest log callbacks of the player's listener.
+/// Answers questId -> slot lookups, objective progress with the time of its last change and the objectives
+/// that are still incomplete, all in O(1).
+class QuestLogIndex : public StatUpdateForwarder
+{
+public:
+    explicit QuestLogIndex(IStatUpdate* next = nullptr);
+
+    void OnPlayerQuestLogId(uint32 old, uint32 value, uint32 index) override;
+    void OnPlayerQuestLogCount(uint32 old, uint32 value, uint32 index, uint32 objective) override;
+
+    /// Required amount per objective, from the quest template. Objectives without requirement count as done.
+    void SetObjectiveRequirements(uint32 questId, std::vector<uint16> required);
+
+    /// Slot holding the quest, or -1.
+    int32 FindSlot(uint32 questId) const
+    {
+        auto itr = _slotByQuest.find(questId);
+        return itr != _slotByQuest.end() ? int32(itr->second) : -1;
+    }
+
+    bool HasQuest(uint32 questId) const { return _slotByQuest.count(questId) != 0; }
+    uint32 GetQuestId(uint32 slot) const { return _slots[slot].QuestId; }
+
+    uint16 GetObjectiveProgress(uint32 questId, uint32 objective) const;
+
+    /// getMSTime() of the last change of the objective, 0 if it never changed since the quest was taken.
+    uint32 GetObjectiveChangeTime(uint32 questId, uint32 objective) const;
+
+    /// Bit i set for each objective i that did not reach its required amount yet.
+    uint32 GetIncompleteObjectives(uint32 questId) const;
+
+    bool IsQuestObjectivesComplete(uint32 questId) const { return HasQuest(questId) && !GetIncompleteObjectives(questId); }
+
+    /// Bit i set for each slot holding a quest with incomplete objectives.
+    uint32 GetSlotsWithIncompleteObjectives() const { return _incompleteSlots; }
+
+    void Clear();
+
+private:
+    struct Slot
+    {
+        uint32 QuestId;
+        uint32 Incomplete;
+        uint16 Progress[MAX_QUEST_LOG_OBJECTIVES];
+        uint32 ChangeTime[MAX_QUEST_LOG_OBJECTIVES];
+    };
+
+    void ResetSlot(uint32 slot, uint32 questId);
+    void RefreshIncomplete(uint32 slot);
+    void RefreshIncomplete(uint32 slot, uint32 objective);
+
+    Slot _slots[MAX_QUEST_LOG_SLOTS];
+    std::unordered_map<uint32, uint8> _slotByQuest;
+    std::unordered_map<uint32, std::vector<uint16>> _requirements;
+    uint32 _incompleteSlots;
+};
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef _REFERENCEDECODE_H
+#define _REFERENCEDECODE_H
+
+#include "Define.h"
+
+namespace UF
+{
+
+#ifdef UF_WITH_DECODE_DIFF
+/// Per thread switch of the decode helpers (BitReader, packed guids) back to the plain ByteBuffer reads.
+/// Only exists in builds with UF_WITH_DECODE_DIFF, see DecodeDiff.h.
+bool& ReferenceDecodeFlag();
+
+inline bool IsReferenceDecode() { return ReferenceDecodeFlag(); }
+
+class ReferenceDecodeScope
+{
+public:
+    ReferenceDecodeScope() : _previous(ReferenceDecodeFlag()) { ReferenceDecodeFlag() = true; }
+    ~ReferenceDecodeScope() { ReferenceDecodeFlag() = _previous; }
+
+    ReferenceDecodeScope(ReferenceDecodeScope const&) = delete;
+    ReferenceDecodeScope& operator=(ReferenceDecodeScope const&) = delete;
+
+private:
+    bool _previous;
+};
+
+/// Set while DecodeDifferential runs its two decodes; decoders it reaches decode plainly instead of starting
+/// another comparison.
+bool& DifferentialDecodeFlag();
+
+inline bool IsDifferentialDecode() { return DifferentialDecodeFlag(); }
+
+class DifferentialDecodeScope
+{
+public:
+    DifferentialDecodeScope() : _previous(DifferentialDecodeFlag()) { DifferentialDecodeFlag() = true; }
+    ~DifferentialDecodeScope() { DifferentialDecodeFlag() = _previous; }
+
+    DifferentialDecodeScope(DifferentialDecodeScope const&) = delete;
+    DifferentialDecodeScope& operator=(DifferentialDecodeScope const&) = delete;
+
+private:
+    bool _previous;
+};
+#else
+inline bool IsReferenceDecode() { return false; }
+inline bool IsDifferentialDecode() { return false; }
+#endif
+
+}
+
+#endif
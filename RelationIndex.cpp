@@ -0,0 +1,116 @@
+#include "RelationIndex.h"
+#include "UpdateFields.h"
+
+namespace UF
+{
+
+void RelationIndex::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+    if (!context.Guid.IsEmpty())
+    {
+        if (type == UpdateFieldStruct::Unit)
+        {
+            UnitData const& unit = *static_cast<UnitData const*>(fields);
+            struct
+            {
+                uint32 Bit;
+                RelationType Type;
+                ObjectGuid const& Value;
+            } const links[] =
+            {
+                { 11, RelationType::Charm, unit.Charm._value },
+                { 12, RelationType::Summon, unit.Summon._value },
+                { 14, RelationType::CharmedBy, unit.CharmedBy._value },
+                { 15, RelationType::SummonedBy, unit.SummonedBy._value },
+                { 16, RelationType::CreatedBy, unit.CreatedBy._value },
+                { 17, RelationType::DemonCreator, unit.DemonCreator._value },
+                { 19, RelationType::Target, unit.Target._value },
+            };
+
+            for (auto const& link : links)
+                if (IsFieldDecoded(mask, maskWords, link.Bit))
+                    Set(context.Guid, link.Type, link.Value);
+        }
+        else if (type == UpdateFieldStruct::GameObject)
+        {
+            if (IsFieldDecoded(mask, maskWords, 9))
+                Set(context.Guid, RelationType::GameObjectCreatedBy, static_cast<GameObjectData const*>(fields)->CreatedBy._value);
+        }
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+void RelationIndex::Set(ObjectGuid const& source, RelationType type, ObjectGuid const& target)
+{
+    auto itr = _records.find(source);
+    if (itr == _records.end())
+    {
+        if (target.IsEmpty())
+            return;
+        itr = _records.emplace(source, Record()).first;
+    }
+
+    Edge& edge = itr->second.Edges[uint32(type)];
+    if (edge.Target == target)
+        return;
+
+    Unset(itr->second, type);
+    if (target.IsEmpty())
+        return;
+
+    std::vector<ObjectGuid>& sources = _sources[Key{ target, type }];
+    edge.Target = target;
+    edge.Position = uint32(sources.size());
+    sources.push_back(source);
+}
+
+void RelationIndex::Unset(Record& record, RelationType type)
+{
+    Edge& edge = record.Edges[uint32(type)];
+    if (edge.Target.IsEmpty())
+        return;
+
+    auto itr = _sources.find(Key{ edge.Target, type });
+    std::vector<ObjectGuid>& sources = itr->second;
+    ObjectGuid last = sources.back();
+    sources[edge.Position] = last;
+    _records[last].Edges[uint32(type)].Position = edge.Position;
+    sources.pop_back();
+    if (sources.empty())
+        _sources.erase(itr);
+    edge.Target = ObjectGuid();
+}
+
+void RelationIndex::Remove(ObjectGuid const& guid)
+{
+    auto itr = _records.find(guid);
+    if (itr == _records.end())
+        return;
+
+    for (uint32 type = 0; type < uint32(RelationType::Max); ++type)
+        Unset(itr->second, RelationType(type));
+    _records.erase(itr);
+}
+
+void RelationIndex::Clear()
+{
+    _records.clear();
+    _sources.clear();
+}
+
+std::vector<ObjectGuid> const& RelationIndex::GetSources(RelationType type, ObjectGuid const& target) const
+{
+    static std::vector<ObjectGuid> const empty;
+    auto itr = _sources.find(Key{ target, type });
+    return itr != _sources.end() ? itr->second : empty;
+}
+
+ObjectGuid RelationIndex::GetTarget(RelationType type, ObjectGuid const& source) const
+{
+    auto itr = _records.find(source);
+    return itr != _records.end() ? itr->second.Edges[uint32(type)].Target : ObjectGuid();
+}
+
+}
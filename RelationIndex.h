@@ -0,0 +1,91 @@
+#ifndef _RELATIONINDEX_H
+#define _RELATIONINDEX_H
+
+#include "Define.h"
+#include "ObjectFieldIndex.h"
+#include "UpdateFieldSink.h"
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// Guid links between objects, named after the field holding them on the source object.
+enum class RelationType : uint8
+{
+    Target,                 // UnitData::Target
+    Charm,                  // UnitData::Charm
+    Summon,                 // UnitData::Summon
+    CharmedBy,              // UnitData::CharmedBy
+    SummonedBy,             // UnitData::SummonedBy
+    CreatedBy,              // UnitData::CreatedBy
+    DemonCreator,           // UnitData::DemonCreator
+    GameObjectCreatedBy,    // GameObjectData::CreatedBy
+
+    Max
+};
+
+/// Reverse edges of the guid links of UnitData and GameObjectData, kept up to date from the decode path.
+/// GetSources(RelationType::Target, me) is "who is targeting me", GetSources(RelationType::SummonedBy, x) "all summons of x".
+class RelationIndex : public UpdateFieldSink
+{
+public:
+    explicit RelationIndex(UpdateFieldSink* next = nullptr) : UpdateFieldSink(next) { }
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    /// Drops the links of an object that was destroyed or left visibility. Links pointing to it stay,
+    /// the objects holding them still hold the guid.
+    void Remove(ObjectGuid const& guid);
+    void Clear();
+
+    /// Objects whose 'type' field holds 'target'.
+    std::vector<ObjectGuid> const& GetSources(RelationType type, ObjectGuid const& target) const;
+
+    /// Current value of the 'type' field of 'source', empty when unknown.
+    ObjectGuid GetTarget(RelationType type, ObjectGuid const& source) const;
+
+    /// Calls fn(source, target) for the sources of every target, e.g. the pets (SummonedBy) of all group members.
+    template<typename Targets, typename Callback>
+    void ForEachSource(RelationType type, Targets const& targets, Callback&& fn) const
+    {
+        for (ObjectGuid const& target : targets)
+            for (ObjectGuid const& source : GetSources(type, target))
+                fn(source, target);
+    }
+
+private:
+    struct Edge
+    {
+        ObjectGuid Target;
+        uint32 Position = 0;
+    };
+
+    struct Record
+    {
+        Edge Edges[uint32(RelationType::Max)];
+    };
+
+    struct Key
+    {
+        ObjectGuid Target;
+        RelationType Type;
+
+        bool operator==(Key const& right) const { return Type == right.Type && Target == right.Target; }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const { return ObjectGuidHash()(key.Target) ^ (std::size_t(key.Type) << 3); }
+    };
+
+    void Set(ObjectGuid const& source, RelationType type, ObjectGuid const& target);
+    void Unset(Record& record, RelationType type);
+
+    std::unordered_map<ObjectGuid, Record, ObjectGuidHash> _records;
+    std::unordered_map<Key, std::vector<ObjectGuid>, KeyHash> _sources;
+};
+
+}
+
+#endif
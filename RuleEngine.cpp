@@ -0,0 +1,247 @@
+#include "RuleEngine.h"
+#include "UpdateFields.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace UF
+{
+
+RuleExpr::RuleExpr(int64 value)
+{
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+    node->Op = OP_CONST;
+    node->Value = value;
+    _node = node;
+}
+
+RuleExpr::RuleExpr(RuleField const& field)
+{
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+    node->Op = OP_FIELD;
+    node->Value = 0;
+    node->Field = field;
+    _node = node;
+}
+
+RuleExpr::RuleExpr(OpCode op, RuleExpr const& left, RuleExpr const& right)
+{
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+    node->Op = op;
+    node->Value = 0;
+    node->Left = left._node;
+    node->Right = right._node;
+    _node = node;
+}
+
+namespace RuleFields
+{
+    static RuleExpr Make(UpdateFieldStruct type, uint32 bit, int64 (*read)(void const*, uint32), uint32 index = 0)
+    {
+        return RuleExpr(RuleField{ type, bit, read, index });
+    }
+
+    static ObjectData const& AsObject(void const* fields) { return *static_cast<ObjectData const*>(fields); }
+    static UnitData const& AsUnit(void const* fields) { return *static_cast<UnitData const*>(fields); }
+
+    static uint32 CheckPowerIndex(uint32 index)
+    {
+        if (index >= 10)
+            throw std::out_of_range("RuleFields: power index past UnitData::Power");
+        return index;
+    }
+
+    RuleExpr EntryID() { return Make(UpdateFieldStruct::Object, 1, [](void const* f, uint32) { return int64(AsObject(f).EntryID._value); }); }
+    RuleExpr DynamicFlags() { return Make(UpdateFieldStruct::Object, 2, [](void const* f, uint32) { return int64(AsObject(f).DynamicFlags._value); }); }
+    RuleExpr Health() { return Make(UpdateFieldStruct::Unit, 5, [](void const* f, uint32) { return int64(AsUnit(f).Health._value); }); }
+    RuleExpr MaxHealth() { return Make(UpdateFieldStruct::Unit, 6, [](void const* f, uint32) { return int64(AsUnit(f).MaxHealth._value); }); }
+    RuleExpr DisplayID() { return Make(UpdateFieldStruct::Unit, 7, [](void const* f, uint32) { return int64(AsUnit(f).DisplayID._value); }); }
+    RuleExpr Level() { return Make(UpdateFieldStruct::Unit, 30, [](void const* f, uint32) { return int64(AsUnit(f).Level._value); }); }
+    RuleExpr FactionTemplate() { return Make(UpdateFieldStruct::Unit, 40, [](void const* f, uint32) { return int64(AsUnit(f).FactionTemplate._value); }); }
+    RuleExpr UnitFlags() { return Make(UpdateFieldStruct::Unit, 41, [](void const* f, uint32) { return int64(AsUnit(f).Flags._value); }); }
+    RuleExpr Power(uint32 index) { return Make(UpdateFieldStruct::Unit, 135 + CheckPowerIndex(index), [](void const* f, uint32 i) { return int64(AsUnit(f).Power[i]); }, index); }
+    RuleExpr MaxPower(uint32 index) { return Make(UpdateFieldStruct::Unit, 145 + CheckPowerIndex(index), [](void const* f, uint32 i) { return int64(AsUnit(f).MaxPower[i]); }, index); }
+}
+
+uint32 RuleEngine::GetSlot(RuleField const& field)
+{
+    for (uint32 slot = 0; slot < _fields.size(); ++slot)
+        if (_fields[slot].Struct == field.Struct && _fields[slot].Bit == field.Bit && _fields[slot].Index == field.Index)
+            return slot;
+
+    _fields.push_back(field);
+    _rulesByField.emplace_back();
+    _fieldsByStruct[uint32(field.Struct)].push_back(uint32(_fields.size() - 1));
+    return uint32(_fields.size() - 1);
+}
+
+uint32 RuleEngine::Compile(RuleExpr::Node const& node, std::vector<Instruction>& program, uint32 depth)
+{
+    switch (node.Op)
+    {
+        case RuleExpr::OP_CONST:
+            program.push_back({ node.Op, 0, node.Value });
+            return depth + 1;
+        case RuleExpr::OP_FIELD:
+            program.push_back({ node.Op, GetSlot(node.Field), 0 });
+            return depth + 1;
+        case RuleExpr::OP_NOT:
+        {
+            uint32 maxDepth = Compile(*node.Left, program, depth);
+            program.push_back({ node.Op, 0, 0 });
+            return maxDepth;
+        }
+        default:
+        {
+            uint32 leftDepth = Compile(*node.Left, program, depth);
+            uint32 rightDepth = Compile(*node.Right, program, depth + 1);
+            program.push_back({ node.Op, 0, 0 });
+            return std::max(leftDepth, rightDepth);
+        }
+    }
+}
+
+uint32 RuleEngine::AddRule(RuleExpr const& condition, Callback callback, uint32 objectTypeMask)
+{
+    uint32 ruleId = uint32(_rules.size());
+    Rule rule;
+    uint32 depth = Compile(*condition.GetNode(), rule.Program, 0);
+    rule.Handler = std::move(callback);
+    rule.ObjectTypeMask = objectTypeMask;
+    rule.Generation = 0;
+
+    for (Instruction const& instruction : rule.Program)
+    {
+        if (instruction.Op != RuleExpr::OP_FIELD)
+            continue;
+
+        std::vector<uint32>& rules = _rulesByField[instruction.Slot];
+        if (std::find(rules.begin(), rules.end(), ruleId) == rules.end())
+            rules.push_back(ruleId);
+    }
+
+    if (_stack.size() < depth)
+        _stack.resize(depth);
+    _rules.push_back(std::move(rule));
+    return ruleId;
+}
+
+bool RuleEngine::Evaluate(Rule const& rule, Object const& object)
+{
+    int64* stack = _stack.data();
+    uint32 top = 0;
+    for (Instruction const& instruction : rule.Program)
+    {
+        switch (instruction.Op)
+        {
+            case RuleExpr::OP_CONST:
+                stack[top++] = instruction.Value;
+                continue;
+            case RuleExpr::OP_FIELD:
+                stack[top++] = object.Values[instruction.Slot];
+                continue;
+            case RuleExpr::OP_NOT:
+                stack[top - 1] = !stack[top - 1];
+                continue;
+            default:
+                break;
+        }
+
+        int64 right = stack[--top];
+        int64& left = stack[top - 1];
+        switch (instruction.Op)
+        {
+            case RuleExpr::OP_ADD: left = left + right; break;
+            case RuleExpr::OP_SUB: left = left - right; break;
+            case RuleExpr::OP_MUL: left = left * right; break;
+            case RuleExpr::OP_DIV: left = right ? left / right : 0; break;
+            case RuleExpr::OP_LT: left = left < right; break;
+            case RuleExpr::OP_LE: left = left <= right; break;
+            case RuleExpr::OP_GT: left = left > right; break;
+            case RuleExpr::OP_GE: left = left >= right; break;
+            case RuleExpr::OP_EQ: left = left == right; break;
+            case RuleExpr::OP_NE: left = left != right; break;
+            case RuleExpr::OP_BIT_AND: left = left & right; break;
+            case RuleExpr::OP_HAS_FLAGS: left = (left & right) == right; break;
+            case RuleExpr::OP_AND: left = left && right; break;
+            case RuleExpr::OP_OR: left = left || right; break;
+            default: break;
+        }
+    }
+    return top && stack[0] != 0;
+}
+
+void RuleEngine::OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    UpdateFieldDecodeContext const& context = UpdateFieldDecodeContext::Current();
+    std::vector<uint32> const& slots = _fieldsByStruct[uint32(type)];
+    if (!slots.empty() && !context.Guid.IsEmpty())
+    {
+        Object& object = _objects[context.Guid];
+        object.Values.resize(_fields.size(), 0);
+        object.Seen.resize(_fields.size(), 0);
+        object.Matched.resize(_rules.size(), 0);
+
+        ++_generation;
+        _dirty.clear();
+        for (uint32 slot : slots)
+        {
+            RuleField const& field = _fields[slot];
+            if (!IsFieldDecoded(mask, maskWords, field.Bit))
+                continue;
+
+            int64 value = field.Read(fields, field.Index);
+            if (object.Seen[slot] && value == object.Values[slot])
+                continue;
+
+            object.Seen[slot] = 1;
+            object.Values[slot] = value;
+            for (uint32 ruleId : _rulesByField[slot])
+            {
+                if (_rules[ruleId].Generation == _generation)
+                    continue;
+                _rules[ruleId].Generation = _generation;
+                _dirty.push_back(ruleId);
+            }
+        }
+
+        // rules in registration order, whatever order their fields changed in
+        std::sort(_dirty.begin(), _dirty.end());
+        for (uint32 ruleId : _dirty)
+        {
+            Rule const& rule = _rules[ruleId];
+            if (rule.ObjectTypeMask && !(rule.ObjectTypeMask & (1u << context.ObjectTypeId)))
+                continue;
+
+            bool matched = Evaluate(rule, object);
+            if (matched == bool(object.Matched[ruleId]))
+                continue;
+
+            object.Matched[ruleId] = matched;
+            if (rule.Handler)
+                _fired.emplace_back(ruleId, matched);
+        }
+
+        // 'object' and '_dirty' are not used past this point, handlers can change the engine
+        if (!_fired.empty())
+        {
+            ObjectGuid guid = context.Guid;
+            std::vector<std::pair<uint32, bool>> fired;
+            fired.swap(_fired);
+            for (std::pair<uint32, bool> const& transition : fired)
+                _rules[transition.first].Handler(guid, transition.first, transition.second);
+            fired.clear();
+            if (_fired.empty())
+                _fired.swap(fired);
+        }
+    }
+
+    UpdateFieldSink::OnStructDecoded(type, fields, mask, maskWords);
+}
+
+bool RuleEngine::IsMatched(ObjectGuid const& guid, uint32 ruleId) const
+{
+    auto itr = _objects.find(guid);
+    return itr != _objects.end() && ruleId < itr->second.Matched.size() && itr->second.Matched[ruleId];
+}
+
+}
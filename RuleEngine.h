@@ -0,0 +1,167 @@
+#ifndef _RULEENGINE_H
+#define _RULEENGINE_H
+
+#include "Define.h"
+#include "ObjectFieldIndex.h"
+#include "UpdateFieldSink.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// Field a rule reads: the changes mask bit that marks it written and how to read it from the decoded struct.
+struct RuleField
+{
+    UpdateFieldStruct Struct;
+    uint32 Bit;
+    int64 (*Read)(void const* fields, uint32 index);
+    uint32 Index;
+};
+
+/// Condition over fields, built with the operators below and compiled by RuleEngine::AddRule.
+/// Integer arithmetic; Health < 30% of MaxHealth is RuleFields::Health() * 100 < RuleFields::MaxHealth() * 30.
+class RuleExpr
+{
+public:
+    enum OpCode : uint8
+    {
+        OP_CONST,
+        OP_FIELD,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_EQ,
+        OP_NE,
+        OP_BIT_AND,
+        OP_HAS_FLAGS,
+        OP_AND,
+        OP_OR,
+        OP_NOT
+    };
+
+    struct Node
+    {
+        OpCode Op;
+        int64 Value;
+        RuleField Field;
+        std::shared_ptr<Node const> Left;
+        std::shared_ptr<Node const> Right;
+    };
+
+    RuleExpr(int64 value);
+    explicit RuleExpr(RuleField const& field);
+    RuleExpr(OpCode op, RuleExpr const& left, RuleExpr const& right);
+
+    std::shared_ptr<Node const> const& GetNode() const { return _node; }
+
+private:
+    std::shared_ptr<Node const> _node;
+};
+
+inline RuleExpr operator+(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_ADD, left, right); }
+inline RuleExpr operator-(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_SUB, left, right); }
+inline RuleExpr operator*(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_MUL, left, right); }
+inline RuleExpr operator/(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_DIV, left, right); }
+inline RuleExpr operator<(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_LT, left, right); }
+inline RuleExpr operator<=(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_LE, left, right); }
+inline RuleExpr operator>(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_GT, left, right); }
+inline RuleExpr operator>=(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_GE, left, right); }
+inline RuleExpr operator==(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_EQ, left, right); }
+inline RuleExpr operator!=(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_NE, left, right); }
+inline RuleExpr operator&(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_BIT_AND, left, right); }
+inline RuleExpr operator&&(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_AND, left, right); }
+inline RuleExpr operator||(RuleExpr const& left, RuleExpr const& right) { return RuleExpr(RuleExpr::OP_OR, left, right); }
+inline RuleExpr operator!(RuleExpr const& expr) { return RuleExpr(RuleExpr::OP_NOT, expr, RuleExpr(0)); }
+
+/// (value & flags) == flags
+inline RuleExpr HasFlags(RuleExpr const& value, RuleExpr const& flags) { return RuleExpr(RuleExpr::OP_HAS_FLAGS, value, flags); }
+
+namespace RuleFields
+{
+    RuleExpr EntryID();
+    RuleExpr DynamicFlags();
+    RuleExpr Health();
+    RuleExpr MaxHealth();
+    RuleExpr DisplayID();
+    RuleExpr Level();
+    RuleExpr FactionTemplate();
+    RuleExpr UnitFlags();
+    /// 'index' below 10, throws std::out_of_range otherwise.
+    RuleExpr Power(uint32 index);
+    RuleExpr MaxPower(uint32 index);
+}
+
+/// Field threshold triggers. Rules are compiled once into a postfix program; each decode only re-evaluates the
+/// rules reading a field the changes mask marks as written and whose value actually changed, so the cost follows
+/// the changes instead of objects x rules. Callbacks fire on transitions: matched = true when the condition
+/// becomes true for an object, false when it stops holding.
+/// Inputs from other structs of the same object (ObjectData for a UnitData rule) use the last decoded value.
+/// Callbacks run once every rule of the decode was evaluated, so they may add rules, remove objects or clear the engine.
+class RuleEngine : public UpdateFieldSink
+{
+public:
+    typedef std::function<void(ObjectGuid const& guid, uint32 ruleId, bool matched)> Callback;
+
+    explicit RuleEngine(UpdateFieldSink* next = nullptr) : UpdateFieldSink(next), _generation(0) { }
+
+    /// 'objectTypeMask' limits the rule to objects with (1 << TypeID) in the mask, 0 for all.
+    /// Objects already known are evaluated the next time one of the rule's fields changes.
+    uint32 AddRule(RuleExpr const& condition, Callback callback, uint32 objectTypeMask = 0);
+
+    void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords) override;
+
+    bool IsMatched(ObjectGuid const& guid, uint32 ruleId) const;
+
+    void Remove(ObjectGuid const& guid) { _objects.erase(guid); }
+    void Clear() { _objects.clear(); }
+
+private:
+    struct Instruction
+    {
+        RuleExpr::OpCode Op;
+        uint32 Slot;
+        int64 Value;
+    };
+
+    struct Rule
+    {
+        std::vector<Instruction> Program;
+        Callback Handler;
+        uint32 ObjectTypeMask;
+        uint32 Generation;
+    };
+
+    struct Object
+    {
+        std::vector<int64> Values;
+        std::vector<uint8> Seen;        // Values[slot] was decoded for this object
+        std::vector<uint8> Matched;
+    };
+
+    uint32 GetSlot(RuleField const& field);
+    uint32 Compile(RuleExpr::Node const& node, std::vector<Instruction>& program, uint32 depth);
+    bool Evaluate(Rule const& rule, Object const& object);
+
+    std::vector<RuleField> _fields;
+    std::vector<std::vector<uint32>> _rulesByField;
+    std::vector<uint32> _fieldsByStruct[uint32(UpdateFieldStruct::Max)];
+    std::deque<Rule> _rules;            // a deque keeps a running handler in place while it adds rules
+    std::vector<int64> _stack;
+    std::vector<uint32> _dirty;
+    std::vector<std::pair<uint32, bool>> _fired;
+    uint32 _generation;
+    std::unordered_map<ObjectGuid, Object, ObjectGuidHash> _objects;
+};
+
+}
+
+#endif
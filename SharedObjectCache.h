@@ -0,0 +1,433 @@
+#ifndef _SHAREDOBJECTCACHE_H
+#define _SHAREDOBJECTCACHE_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "DecodeDiff.h"
+#include "ObjectGuid.h"
+#include "StatUpdateRecorder.h"
+#include "UpdateFields.h"
+#include "UpdateFieldsWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace UF
+{
+
+/// Object state shared by all sessions of a process that see an object the same way.
+///
+/// Entries are keyed by guid and by the viewer's field visibility flags: every viewer class
+/// (strangers, party members, owner, ...) receives identical values blocks from the server, so it can
+/// share one decoded copy. Each session holds a Handle on one immutable version of the entry's state.
+/// The first session that receives an update decodes it into the next version and records its callbacks;
+/// the others find the same bytes in the entry's update log, move their handle to that version and
+/// only replay the callbacks. Until a session receives an update it keeps reading the version it is at.
+/// A session whose stream diverges from the log detaches onto a private copy of its own version.
+///
+/// The update log only holds the updates between the slowest attached session and the current version, at
+/// most UpdateLogLimit of them: an entry with a single session, or whose sessions are all in step, logs
+/// nothing. Callbacks of the logged updates are kept back to back in one vector per entry.
+///
+/// There is no per-session overlay. Owner-only and party-only fields are covered by the key, since sessions
+/// that see them get their own entry. Values the server computes per viewer inside one visibility class
+/// (dynamic flags, display or faction overrides, ...) fork the entry instead: a session whose create block
+/// decodes to a different state than every live entry of its key starts another entry, and sessions that
+/// agree on such values share it. Each distinct value set costs one more decoded copy and one more decode
+/// per update. States are compared through their creates with every visibility flag, which write every
+/// field the UnitData and GameObjectData decoders keep.
+/// Versions cost a copy of Fields per shared update while other sessions still read the previous version;
+/// a version nobody holds anymore is updated in place.
+template<typename Fields>
+class SharedObjectCache
+{
+public:
+    typedef std::function<void(ByteBuffer&, Fields&, IStatUpdate&)> DecodeFn;
+
+    /// Updates a session may fall behind the others before it detaches.
+    static uint32 const UpdateLogLimit = 64;
+
+private:
+    typedef std::shared_ptr<Fields const> State;
+
+    struct LoggedUpdate
+    {
+        std::vector<uint8> Bytes;
+        std::size_t CallbacksEnd = 0;           // end of this update's records in Entry::Callbacks
+        std::weak_ptr<Fields const> Result;     // version the update produced, while some session holds it
+    };
+
+    struct Entry
+    {
+        std::mutex Lock;
+        State Current;
+        uint64 Sequence = 0;                    // number of updates applied to Current
+        std::vector<uint8> CreateBytes;         // last create block that decoded to Current, at CreateSequence
+        uint64 CreateSequence = 0;
+        StatUpdateRecorder CreateCallbacks;
+        std::vector<uint8> Encoded;             // EncodeForDiff of Current, empty until needed
+        std::map<uint64, uint32> Readers;       // attached handles per sequence
+        std::vector<LoggedUpdate> Log;          // updates LogStart to Sequence - 1
+        uint64 LogStart = 0;
+        StatUpdateRecords Callbacks;            // callbacks of the logged updates, in log order
+    };
+
+public:
+    class Handle
+    {
+        friend class SharedObjectCache;
+
+    public:
+        Handle() : _sequence(0) { }
+        Handle(Handle&& other) : _entry(std::move(other._entry)), _state(std::move(other._state)),
+            _private(std::move(other._private)), _sequence(other._sequence) { }
+        ~Handle() { Release(); }
+
+        Handle& operator=(Handle&& other)
+        {
+            if (this != &other)
+            {
+                Release();
+                _entry = std::move(other._entry);
+                _state = std::move(other._state);
+                _private = std::move(other._private);
+                _sequence = other._sequence;
+            }
+            return *this;
+        }
+
+        bool IsValid() const { return _state || _private; }
+        bool IsShared() const { return bool(_state); }
+
+        /// Calls 'reader' with the field values this session has received so far.
+        template<typename Reader>
+        void Read(Reader&& reader) const
+        {
+            if (_private)
+                reader(static_cast<Fields const&>(*_private));
+            else
+                reader(*_state);
+        }
+
+    private:
+        void Release()
+        {
+            if (!_entry)
+                return;
+
+            std::lock_guard<std::mutex> guard(_entry->Lock);
+            RemoveReader(*_entry, _sequence);
+            Trim(*_entry);
+        }
+
+        std::shared_ptr<Entry> _entry;
+        State _state;
+        std::unique_ptr<Fields> _private;
+        uint64 _sequence;               // number of updates applied to _state
+    };
+
+    /// Handles a create block. Attaches to a live entry of the same key whose current state the block decodes
+    /// to, without decoding when another session attached with the same bytes at the same point; otherwise
+    /// the decoded state starts a new entry.
+    Handle Create(ObjectGuid const& guid, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, uint8 const* block, std::size_t size,
+        DecodeFn const& decode, IStatUpdate& update)
+    {
+        Key key(guid, fieldVisibilityFlags);
+        std::vector<std::shared_ptr<Entry>> candidates = GetEntries(key);
+        Handle handle;
+
+        for (std::shared_ptr<Entry> const& entry : candidates)
+        {
+            std::unique_lock<std::mutex> guard(entry->Lock);
+            if (entry->CreateSequence == entry->Sequence && Equals(entry->CreateBytes, block, size))
+            {
+                Attach(handle, entry);
+                StatUpdateRecorder callbacks = entry->CreateCallbacks;
+                guard.unlock();
+                callbacks.Replay(update);
+                std::lock_guard<std::mutex> statsGuard(_lock);
+                ++_stats.CreatesShared;
+                return handle;
+            }
+        }
+
+        std::shared_ptr<Fields> values = std::make_shared<Fields>();
+        StatUpdateRecorder callbacks;
+        Decode(decode, *values, block, size, callbacks);
+        callbacks.Replay(update);
+
+        if (!candidates.empty())
+        {
+            ByteBuffer encoded;
+            EncodeForDiff(encoded, *values);
+            for (std::shared_ptr<Entry> const& entry : candidates)
+            {
+                std::lock_guard<std::mutex> guard(entry->Lock);
+                if (entry->Encoded.empty())
+                {
+                    ByteBuffer current;
+                    EncodeForDiff(current, *entry->Current);
+                    entry->Encoded.assign(current.contents(), current.contents() + current.size());
+                }
+                if (!Equals(entry->Encoded, encoded.contents(), encoded.size()))
+                    continue;
+
+                // later sessions zoning in at this point attach without decoding
+                entry->CreateBytes.assign(block, block + size);
+                entry->CreateSequence = entry->Sequence;
+                entry->CreateCallbacks = callbacks;
+                Attach(handle, entry);
+                std::lock_guard<std::mutex> statsGuard(_lock);
+                ++_stats.CreatesShared;
+                return handle;
+            }
+        }
+
+        std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+        entry->Current = values;
+        entry->CreateBytes.assign(block, block + size);
+        entry->CreateCallbacks = callbacks;
+        Attach(handle, entry);
+
+        std::lock_guard<std::mutex> guard(_lock);
+        _entries[key].push_back(entry);
+        ++_stats.CreatesDecoded;
+        return handle;
+    }
+
+    /// Applies a values update block received by the session owning 'handle'.
+    void Update(Handle& handle, uint8 const* block, std::size_t size, DecodeFn const& decode, IStatUpdate& update)
+    {
+        if (handle._private)
+        {
+            Decode(decode, *handle._private, block, size, update);
+            return;
+        }
+
+        Entry& entry = *handle._entry;
+        std::unique_lock<std::mutex> guard(entry.Lock);
+        if (handle._sequence < entry.Sequence)
+        {
+            std::size_t index = std::size_t(handle._sequence - entry.LogStart);
+            if (handle._sequence < entry.LogStart || index >= entry.Log.size() || !Equals(entry.Log[index].Bytes, block, size))
+            {
+                // this session saw a different stream or fell too far behind, continue on a private copy of the state it had
+                Detach(handle, guard);
+                Decode(decode, *handle._private, block, size, update);
+                return;
+            }
+
+            LoggedUpdate& logged = entry.Log[index];
+            bool redecoded = false;
+            State next = handle._sequence + 1 == entry.Sequence ? entry.Current : logged.Result.lock();
+            if (!next)
+            {
+                // no session holds that version anymore, rebuild it from this session's own
+                std::shared_ptr<Fields> values = std::make_shared<Fields>(*handle._state);
+                StatUpdateForwarder ignored;
+                Decode(decode, *values, block, size, ignored);
+                logged.Result = values;
+                next = values;
+                redecoded = true;
+            }
+
+            std::size_t callbacksBegin = index ? entry.Log[index - 1].CallbacksEnd : 0;
+            StatUpdateRecords callbacks(entry.Callbacks.begin() + callbacksBegin, entry.Callbacks.begin() + logged.CallbacksEnd);
+            MoveReader(handle, next);
+            guard.unlock();
+
+            for (StatUpdateRecord const& record : callbacks)
+                StatUpdateRecorder::Dispatch(record, update);
+            std::lock_guard<std::mutex> statsGuard(_lock);
+            ++(redecoded ? _stats.UpdatesRedecoded : _stats.UpdatesShared);
+            return;
+        }
+
+        // the entry and this handle are the only holders of the current version, no other session reads it
+        std::shared_ptr<Fields> values;
+        if (entry.Current.use_count() == 2)
+        {
+            values = std::const_pointer_cast<Fields>(entry.Current);
+            if (!entry.Log.empty())
+                entry.Log.back().Result.reset();
+        }
+        else
+            values = std::make_shared<Fields>(*entry.Current);
+
+        StatUpdateRecorder callbacks;
+        Decode(decode, *values, block, size, callbacks);
+
+        // log the update only while another session is attached, it will read it when it gets there
+        if (entry.Readers.size() > 1 || entry.Readers.begin()->second > 1)
+        {
+            if (entry.Log.empty())
+                entry.LogStart = entry.Sequence;
+            entry.Callbacks.insert(entry.Callbacks.end(), callbacks.GetRecords().begin(), callbacks.GetRecords().end());
+            entry.Log.emplace_back();
+            LoggedUpdate& logged = entry.Log.back();
+            logged.Bytes.assign(block, block + size);
+            logged.CallbacksEnd = entry.Callbacks.size();
+            logged.Result = values;
+        }
+
+        entry.Current = values;
+        entry.Encoded.clear();
+        ++entry.Sequence;
+        MoveReader(handle, entry.Current);
+        guard.unlock();
+
+        callbacks.Replay(update);
+        std::lock_guard<std::mutex> statsGuard(_lock);
+        ++_stats.UpdatesDecoded;
+    }
+
+    /// Drops map slots of objects no session references anymore.
+    void Purge()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        for (auto itr = _entries.begin(); itr != _entries.end();)
+        {
+            std::vector<std::weak_ptr<Entry>>& entries = itr->second;
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [](std::weak_ptr<Entry> const& entry) { return entry.expired(); }), entries.end());
+            if (entries.empty())
+                itr = _entries.erase(itr);
+            else
+                ++itr;
+        }
+    }
+
+    struct Stats
+    {
+        uint64 CreatesDecoded = 0;
+        uint64 CreatesShared = 0;
+        uint64 UpdatesDecoded = 0;
+        uint64 UpdatesShared = 0;
+        uint64 UpdatesRedecoded = 0;    // shared updates whose version had to be rebuilt for a lagging session
+        uint64 Detached = 0;
+    };
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        return _stats;
+    }
+
+private:
+    struct Key
+    {
+        Key(ObjectGuid const& guid, EnumFlag<UpdateFieldFlag> flags)
+            : Low(guid._low), High(guid._high), Flags(uint32(static_cast<UpdateFieldFlag>(flags))) { }
+
+        bool operator==(Key const& right) const { return Low == right.Low && High == right.High && Flags == right.Flags; }
+
+        uint64 Low;
+        uint64 High;
+        uint32 Flags;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const
+        {
+            return std::hash<uint64>()(key.Low ^ (key.High * 0x9E3779B97F4A7C15ULL) ^ (uint64(key.Flags) << 56));
+        }
+    };
+
+    static bool Equals(std::vector<uint8> const& bytes, uint8 const* block, std::size_t size)
+    {
+        return bytes.size() == size && (!size || memcmp(bytes.data(), block, size) == 0);
+    }
+
+    static void Decode(DecodeFn const& decode, Fields& values, uint8 const* block, std::size_t size, IStatUpdate& update)
+    {
+        ByteBuffer data(size);
+        data.append(block, size);
+        DecodeDifferential(data, values, update, decode);
+    }
+
+    /// Call with the entry locked or not yet published.
+    static void Attach(Handle& handle, std::shared_ptr<Entry> const& entry)
+    {
+        handle._entry = entry;
+        handle._state = entry->Current;
+        handle._sequence = entry->Sequence;
+        ++entry->Readers[handle._sequence];
+    }
+
+    /// Moves 'handle' one update forward, to 'next'. Call with the entry locked.
+    static void MoveReader(Handle& handle, State const& next)
+    {
+        Entry& entry = *handle._entry;
+        RemoveReader(entry, handle._sequence);
+        handle._state = next;
+        ++entry.Readers[++handle._sequence];
+        Trim(entry);
+    }
+
+    static void RemoveReader(Entry& entry, uint64 sequence)
+    {
+        auto itr = entry.Readers.find(sequence);
+        if (!--itr->second)
+            entry.Readers.erase(itr);
+    }
+
+    /// Drops the logged updates every attached handle is past, and the oldest ones beyond UpdateLogLimit.
+    /// Call with the entry locked.
+    static void Trim(Entry& entry)
+    {
+        uint64 keepFrom = entry.Readers.empty() ? entry.Sequence : entry.Readers.begin()->first;
+        if (entry.Sequence - keepFrom > UpdateLogLimit)
+            keepFrom = entry.Sequence - UpdateLogLimit;
+        if (keepFrom <= entry.LogStart || entry.Log.empty())
+            return;
+
+        std::size_t count = std::size_t(std::min<uint64>(keepFrom - entry.LogStart, entry.Log.size()));
+        std::size_t records = entry.Log[count - 1].CallbacksEnd;
+        entry.Log.erase(entry.Log.begin(), entry.Log.begin() + count);
+        entry.Callbacks.erase(entry.Callbacks.begin(), entry.Callbacks.begin() + records);
+        for (LoggedUpdate& logged : entry.Log)
+            logged.CallbacksEnd -= records;
+        entry.LogStart += count;
+    }
+
+    std::vector<std::shared_ptr<Entry>> GetEntries(Key const& key) const
+    {
+        std::vector<std::shared_ptr<Entry>> entries;
+        std::lock_guard<std::mutex> guard(_lock);
+        auto itr = _entries.find(key);
+        if (itr != _entries.end())
+            for (std::weak_ptr<Entry> const& weak : itr->second)
+                if (std::shared_ptr<Entry> entry = weak.lock())
+                    entries.push_back(std::move(entry));
+        return entries;
+    }
+
+    void Detach(Handle& handle, std::unique_lock<std::mutex>& guard)
+    {
+        handle._private.reset(new Fields(*handle._state));
+        handle._state.reset();
+        RemoveReader(*handle._entry, handle._sequence);
+        Trim(*handle._entry);
+        guard.unlock();
+        handle._entry.reset();
+
+        std::lock_guard<std::mutex> statsGuard(_lock);
+        ++_stats.Detached;
+    }
+
+    mutable std::mutex _lock;
+    std::unordered_map<Key, std::vector<std::weak_ptr<Entry>>, KeyHash> _entries;
+    Stats _stats;
+};
+
+typedef SharedObjectCache<UnitData> SharedUnitCache;
+typedef SharedObjectCache<GameObjectData> SharedGameObjectCache;
+
+}
+
+#endif
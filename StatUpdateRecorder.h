@@ -0,0 +1,155 @@
+#ifndef _STATUPDATERECORDER_H
+#define _STATUPDATERECORDER_H
+
+#include "Define.h"
+#include "UpdateFields.h"
+#include <vector>
+
+namespace UF
+{
+
+/// Forwards every IStatUpdate callback to another listener.
+/// Derive from it to observe a subset of callbacks without breaking the rest.
+class StatUpdateForwarder : public IStatUpdate
+{
+public:
+    explicit StatUpdateForwarder(IStatUpdate* next = nullptr) : _next(next) { }
+
+    void SetNext(IStatUpdate* next) { _next = next; }
+    IStatUpdate* GetNext() const { return _next; }
+
+    void OnObjectDynamicFlags(uint32 old, uint32 value) override { if (_next) _next->OnObjectDynamicFlags(old, value); }
+    void OnUnitHealth(uint32 old, uint32 value) override { if (_next) _next->OnUnitHealth(old, value); }
+    void OnUnitPower(uint32 old, uint32 value, uint32 index) override { if (_next) _next->OnUnitPower(old, value, index); }
+    void OnUnitLevel(uint32 old, uint32 value) override { if (_next) _next->OnUnitLevel(old, value); }
+    void OnUnitFlags(uint32 old, uint32 value) override { if (_next) _next->OnUnitFlags(old, value); }
+    void OnUnitDisplayId(uint32 old, uint32 value) override { if (_next) _next->OnUnitDisplayId(old, value); }
+    void OnContainerSlots(uint64 old, uint64 value, uint32 index) override { if (_next) _next->OnContainerSlots(old, value, index); }
+    void OnPlayerQuestLogId(uint32 old, uint32 value, uint32 index) override { if (_next) _next->OnPlayerQuestLogId(old, value, index); }
+    void OnPlayerQuestLogCount(uint32 old, uint32 value, uint32 index, uint32 objective) override { if (_next) _next->OnPlayerQuestLogCount(old, value, index, objective); }
+    void OnActivePlayerSkillLineId(uint32 old, uint32 value, uint32 index) override { if (_next) _next->OnActivePlayerSkillLineId(old, value, index); }
+    void OnActivePlayerCoinage(uint64 old, uint64 value) override { if (_next) _next->OnActivePlayerCoinage(old, value); }
+    void OnActivePlayerInvSlot(uint64 old, uint64 value, uint32 index) override { if (_next) _next->OnActivePlayerInvSlot(old, value, index); }
+    void OnActivePlayerQuestCompleted(uint64 old, uint64 value, uint32 index) override { if (_next) _next->OnActivePlayerQuestCompleted(old, value, index); }
+
+private:
+    IStatUpdate* _next;
+};
+
+enum class StatUpdateEvent : uint8
+{
+    ObjectDynamicFlags,
+    UnitHealth,
+    UnitPower,
+    UnitLevel,
+    UnitFlags,
+    UnitDisplayId,
+    ContainerSlots,
+    PlayerQuestLogId,
+    PlayerQuestLogCount,
+    ActivePlayerSkillLineId,
+    ActivePlayerCoinage,
+    ActivePlayerInvSlot,
+    ActivePlayerQuestCompleted,
+    Max
+};
+
+struct StatUpdateRecord
+{
+    StatUpdateEvent Event;
+    uint32 Index;
+    uint32 SubIndex;
+    uint64 Old;
+    uint64 Value;
+};
+
+typedef std::vector<StatUpdateRecord> StatUpdateRecords;
+
+/// Captures IStatUpdate callbacks so they can be replayed later, in the same order, on another listener.
+class StatUpdateRecorder : public IStatUpdate
+{
+public:
+    void OnObjectDynamicFlags(uint32 old, uint32 value) override { Push(StatUpdateEvent::ObjectDynamicFlags, old, value); }
+    void OnUnitHealth(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitHealth, old, value); }
+    void OnUnitPower(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::UnitPower, old, value, index); }
+    void OnUnitLevel(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitLevel, old, value); }
+    void OnUnitFlags(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitFlags, old, value); }
+    void OnUnitDisplayId(uint32 old, uint32 value) override { Push(StatUpdateEvent::UnitDisplayId, old, value); }
+    void OnContainerSlots(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ContainerSlots, old, value, index); }
+    void OnPlayerQuestLogId(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::PlayerQuestLogId, old, value, index); }
+    void OnPlayerQuestLogCount(uint32 old, uint32 value, uint32 index, uint32 objective) override { Push(StatUpdateEvent::PlayerQuestLogCount, old, value, index, objective); }
+    void OnActivePlayerSkillLineId(uint32 old, uint32 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerSkillLineId, old, value, index); }
+    void OnActivePlayerCoinage(uint64 old, uint64 value) override { Push(StatUpdateEvent::ActivePlayerCoinage, old, value); }
+    void OnActivePlayerInvSlot(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerInvSlot, old, value, index); }
+    void OnActivePlayerQuestCompleted(uint64 old, uint64 value, uint32 index) override { Push(StatUpdateEvent::ActivePlayerQuestCompleted, old, value, index); }
+
+    StatUpdateRecords const& GetRecords() const { return _records; }
+    bool IsEmpty() const { return _records.empty(); }
+    void Clear() { _records.clear(); }
+
+    void Replay(IStatUpdate& update) const
+    {
+        for (StatUpdateRecord const& record : _records)
+            Dispatch(record, update);
+    }
+
+    static void Dispatch(StatUpdateRecord const& record, IStatUpdate& update)
+    {
+        switch (record.Event)
+        {
+            case StatUpdateEvent::ObjectDynamicFlags:
+                update.OnObjectDynamicFlags(uint32(record.Old), uint32(record.Value));
+                break;
+            case StatUpdateEvent::UnitHealth:
+                update.OnUnitHealth(uint32(record.Old), uint32(record.Value));
+                break;
+            case StatUpdateEvent::UnitPower:
+                update.OnUnitPower(uint32(record.Old), uint32(record.Value), record.Index);
+                break;
+            case StatUpdateEvent::UnitLevel:
+                update.OnUnitLevel(uint32(record.Old), uint32(record.Value));
+                break;
+            case StatUpdateEvent::UnitFlags:
+                update.OnUnitFlags(uint32(record.Old), uint32(record.Value));
+                break;
+            case StatUpdateEvent::UnitDisplayId:
+                update.OnUnitDisplayId(uint32(record.Old), uint32(record.Value));
+                break;
+            case StatUpdateEvent::ContainerSlots:
+                update.OnContainerSlots(record.Old, record.Value, record.Index);
+                break;
+            case StatUpdateEvent::PlayerQuestLogId:
+                update.OnPlayerQuestLogId(uint32(record.Old), uint32(record.Value), record.Index);
+                break;
+            case StatUpdateEvent::PlayerQuestLogCount:
+                update.OnPlayerQuestLogCount(uint32(record.Old), uint32(record.Value), record.Index, record.SubIndex);
+                break;
+            case StatUpdateEvent::ActivePlayerSkillLineId:
+                update.OnActivePlayerSkillLineId(uint32(record.Old), uint32(record.Value), record.Index);
+                break;
+            case StatUpdateEvent::ActivePlayerCoinage:
+                update.OnActivePlayerCoinage(record.Old, record.Value);
+                break;
+            case StatUpdateEvent::ActivePlayerInvSlot:
+                update.OnActivePlayerInvSlot(record.Old, record.Value, record.Index);
+                break;
+            case StatUpdateEvent::ActivePlayerQuestCompleted:
+                update.OnActivePlayerQuestCompleted(record.Old, record.Value, record.Index);
+                break;
+            default:
+                break;
+        }
+    }
+
+private:
+    void Push(StatUpdateEvent event, uint64 old, uint64 value, uint32 index = 0, uint32 subIndex = 0)
+    {
+        _records.push_back({ event, index, subIndex, old, value });
+    }
+
+    StatUpdateRecords _records;
+};
+
+}
+
+#endif
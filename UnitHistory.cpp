@@ -0,0 +1,187 @@
+#include "UnitHistory.h"
+#include "Timer.h"
+
+namespace UF
+{
+
+void UnitHistory::Listener::OnUnitHealth(uint32 old, uint32 value)
+{
+    _history.AddHealthSample(_slot, value, getMSTime());
+    StatUpdateForwarder::OnUnitHealth(old, value);
+}
+
+void UnitHistory::Listener::OnUnitPower(uint32 old, uint32 value, uint32 index)
+{
+    _history.AddPowerSample(_slot, index, value, getMSTime());
+    StatUpdateForwarder::OnUnitPower(old, value, index);
+}
+
+UnitHistory::UnitHistory(uint32 powerCount) : _capacity(0), _tracks(1 + powerCount)
+{
+}
+
+uint32 UnitHistory::AddUnit(ObjectGuid const& guid)
+{
+    if (_freeSlots.empty())
+    {
+        uint32 first = _capacity;
+        Grow();
+        for (uint32 slot = _capacity; slot > first; --slot)
+            _freeSlots.push_back(slot - 1);
+    }
+
+    uint32 slot = _freeSlots.back();
+    _freeSlots.pop_back();
+    _guids[slot] = guid;
+    return slot;
+}
+
+void UnitHistory::RemoveUnit(uint32 slot)
+{
+    for (Track& track : _tracks)
+    {
+        for (uint32 sample = 0; sample < UNIT_HISTORY_SAMPLES; ++sample)
+            track.Valid[sample * _capacity + slot] = 0;
+        track.Latest[slot] = 0.0f;
+        track.Head[slot] = 0;
+    }
+    _guids[slot] = ObjectGuid();
+    _freeSlots.push_back(slot);
+}
+
+void UnitHistory::Grow()
+{
+    // a multiple of 4 keeps every vector block inside one unit range
+    uint32 capacity = _capacity ? _capacity * 2 : 64;
+    for (Track& track : _tracks)
+    {
+        std::vector<int32> times(UNIT_HISTORY_SAMPLES * capacity, 0);
+        std::vector<float> values(UNIT_HISTORY_SAMPLES * capacity, 0.0f);
+        std::vector<int32> valid(UNIT_HISTORY_SAMPLES * capacity, 0);
+        for (uint32 sample = 0; sample < UNIT_HISTORY_SAMPLES; ++sample)
+        {
+            for (uint32 slot = 0; slot < _capacity; ++slot)
+            {
+                times[sample * capacity + slot] = track.Times[sample * _capacity + slot];
+                values[sample * capacity + slot] = track.Values[sample * _capacity + slot];
+                valid[sample * capacity + slot] = track.Valid[sample * _capacity + slot];
+            }
+        }
+        track.Times.swap(times);
+        track.Values.swap(values);
+        track.Valid.swap(valid);
+        track.Latest.resize(capacity, 0.0f);
+        track.Head.resize(capacity, 0);
+    }
+    _guids.resize(capacity);
+    _capacity = capacity;
+}
+
+void UnitHistory::AddPowerSample(uint32 slot, uint32 powerIndex, uint32 value, uint32 time)
+{
+    if (1 + powerIndex < _tracks.size())
+        AddSample(1 + powerIndex, slot, value, time);
+}
+
+void UnitHistory::AddSample(uint32 trackIndex, uint32 slot, uint32 value, uint32 time)
+{
+    Track& track = _tracks[trackIndex];
+    uint32 index = track.Head[slot] * _capacity + slot;
+    track.Times[index] = int32(time);
+    track.Values[index] = float(value);
+    track.Valid[index] = -1;
+    track.Latest[slot] = float(value);
+    track.Head[slot] = uint8((track.Head[slot] + 1) % UNIT_HISTORY_SAMPLES);
+}
+
+void UnitHistory::GetSlopes(Track const& track, uint32 now, uint32 window, float* slopes) const
+{
+    // x is the sample age in seconds, y the value relative to the latest one, which keeps the float sums small
+    uint32 slot = 0;
+#ifdef UF_UNIT_HISTORY_SIMD
+    __m128i const nowTime = _mm_set1_epi32(int32(now));
+    __m128i const oldest = _mm_set1_epi32(-int32(window) - 1);
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const toSeconds = _mm_set1_ps(0.001f);
+    for (; slot + 4 <= _capacity; slot += 4)
+    {
+        __m128 latest = _mm_loadu_ps(&track.Latest[slot]);
+        __m128 n = _mm_setzero_ps(), sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sxy = _mm_setzero_ps(), sxx = _mm_setzero_ps();
+        for (uint32 sample = 0; sample < UNIT_HISTORY_SAMPLES; ++sample)
+        {
+            uint32 index = sample * _capacity + slot;
+            __m128i age = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&track.Times[index])), nowTime);
+            __m128i valid = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&track.Valid[index])), _mm_cmpgt_epi32(age, oldest));
+            __m128 weight = _mm_castsi128_ps(valid);
+            __m128 x = _mm_and_ps(weight, _mm_mul_ps(_mm_cvtepi32_ps(age), toSeconds));
+            __m128 y = _mm_and_ps(weight, _mm_sub_ps(_mm_loadu_ps(&track.Values[index]), latest));
+            n = _mm_add_ps(n, _mm_and_ps(weight, one));
+            sx = _mm_add_ps(sx, x);
+            sy = _mm_add_ps(sy, y);
+            sxy = _mm_add_ps(sxy, _mm_mul_ps(x, y));
+            sxx = _mm_add_ps(sxx, _mm_mul_ps(x, x));
+        }
+
+        __m128 numerator = _mm_sub_ps(_mm_mul_ps(n, sxy), _mm_mul_ps(sx, sy));
+        __m128 denominator = _mm_sub_ps(_mm_mul_ps(n, sxx), _mm_mul_ps(sx, sx));
+        // fewer than two samples in the window, or all at the same time
+        __m128 defined = _mm_cmpgt_ps(denominator, _mm_set1_ps(1e-6f));
+        __m128 slope = _mm_div_ps(numerator, _mm_or_ps(_mm_and_ps(defined, denominator), _mm_andnot_ps(defined, one)));
+        _mm_storeu_ps(slopes + slot, _mm_and_ps(defined, slope));
+    }
+#endif
+    for (; slot < _capacity; ++slot)
+    {
+        float latest = track.Latest[slot];
+        float n = 0.0f, sx = 0.0f, sy = 0.0f, sxy = 0.0f, sxx = 0.0f;
+        for (uint32 sample = 0; sample < UNIT_HISTORY_SAMPLES; ++sample)
+        {
+            uint32 index = sample * _capacity + slot;
+            int32 age = int32(uint32(track.Times[index]) - now);
+            if (!track.Valid[index] || age < -int32(window))
+                continue;
+
+            float x = float(age) * 0.001f;
+            float y = track.Values[index] - latest;
+            n += 1.0f;
+            sx += x;
+            sy += y;
+            sxy += x * y;
+            sxx += x * x;
+        }
+
+        float denominator = n * sxx - sx * sx;
+        slopes[slot] = denominator > 1e-6f ? (n * sxy - sx * sy) / denominator : 0.0f;
+    }
+}
+
+void UnitHistory::GetDamageTakenRates(uint32 now, uint32 window, float* rates) const
+{
+    GetSlopes(_tracks[0], now, window, rates);
+    for (uint32 slot = 0; slot < _capacity; ++slot)
+        rates[slot] = rates[slot] < 0.0f ? -rates[slot] : 0.0f;
+}
+
+void UnitHistory::GetTimeToDie(uint32 now, uint32 window, float* seconds) const
+{
+    GetDamageTakenRates(now, window, seconds);
+    Track const& health = _tracks[0];
+    for (uint32 slot = 0; slot < _capacity; ++slot)
+        seconds[slot] = seconds[slot] > 0.0f ? health.Latest[slot] / seconds[slot] : -1.0f;
+}
+
+void UnitHistory::GetRegenRates(uint32 powerIndex, uint32 now, uint32 window, float* rates) const
+{
+    if (1 + powerIndex >= _tracks.size())
+    {
+        for (uint32 slot = 0; slot < _capacity; ++slot)
+            rates[slot] = 0.0f;
+        return;
+    }
+
+    GetSlopes(_tracks[1 + powerIndex], now, window, rates);
+    for (uint32 slot = 0; slot < _capacity; ++slot)
+        rates[slot] = rates[slot] > 0.0f ? rates[slot] : 0.0f;
+}
+
+}
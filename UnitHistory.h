@@ -0,0 +1,86 @@
+#ifndef _UNITHISTORY_H
+#define _UNITHISTORY_H
+
+#include "Define.h"
+#include "ObjectGuid.h"
+#include "StatUpdateRecorder.h"
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UF_UNIT_HISTORY_SIMD 1
+#endif
+
+namespace UF
+{
+
+uint32 const UNIT_HISTORY_SAMPLES = 16;
+
+/// Short Health and Power[i] history of every tracked unit in fixed size ring buffers.
+/// Storage is structure of arrays, sample-major: sample k of all units is contiguous, so the batch queries
+/// run over 4 units per instruction. Rates are least squares slopes over the samples of a time window,
+/// in units per second; the result arrays are indexed by the slot returned from AddUnit.
+class UnitHistory
+{
+public:
+    /// Listener of one unit, records samples and forwards the callbacks.
+    class Listener : public StatUpdateForwarder
+    {
+    public:
+        Listener(UnitHistory& history, uint32 slot, IStatUpdate* next = nullptr) : StatUpdateForwarder(next), _history(history), _slot(slot) { }
+
+        void OnUnitHealth(uint32 old, uint32 value) override;
+        void OnUnitPower(uint32 old, uint32 value, uint32 index) override;
+
+    private:
+        UnitHistory& _history;
+        uint32 _slot;
+    };
+
+    /// Tracks Health and Power[0 .. powerCount).
+    explicit UnitHistory(uint32 powerCount = 1);
+
+    uint32 AddUnit(ObjectGuid const& guid);
+    void RemoveUnit(uint32 slot);
+
+    /// Size the result arrays of the batch queries need.
+    uint32 GetCapacity() const { return _capacity; }
+    ObjectGuid const& GetGuid(uint32 slot) const { return _guids[slot]; }
+    bool IsUsed(uint32 slot) const { return !_guids[slot].IsEmpty(); }
+
+    void AddHealthSample(uint32 slot, uint32 value, uint32 time) { AddSample(0, slot, value, time); }
+    void AddPowerSample(uint32 slot, uint32 powerIndex, uint32 value, uint32 time);
+
+    /// Health lost per second, 0 for units not losing health.
+    void GetDamageTakenRates(uint32 now, uint32 window, float* rates) const;
+
+    /// Seconds until Health reaches 0 at the current damage rate, -1 when not losing health.
+    void GetTimeToDie(uint32 now, uint32 window, float* seconds) const;
+
+    /// Power[powerIndex] gained per second, 0 for units not gaining.
+    void GetRegenRates(uint32 powerIndex, uint32 now, uint32 window, float* rates) const;
+
+private:
+    struct Track
+    {
+        std::vector<int32> Times;       // [sample * capacity + slot], getMSTime() of the sample
+        std::vector<float> Values;
+        std::vector<int32> Valid;       // -1 for samples that were written
+        std::vector<float> Latest;      // [slot]
+        std::vector<uint8> Head;        // [slot], next sample to overwrite
+    };
+
+    void AddSample(uint32 track, uint32 slot, uint32 value, uint32 time);
+    void Grow();
+
+    /// Signed rate per second of a track for every slot.
+    void GetSlopes(Track const& track, uint32 now, uint32 window, float* slopes) const;
+
+    uint32 _capacity;
+    std::vector<Track> _tracks;
+    std::vector<ObjectGuid> _guids;
+    std::vector<uint32> _freeSlots;
+};
+
+}
+
+#endif
@@ -0,0 +1,24 @@
+#include "UpdateFieldSink.h"
+
+namespace UF
+{
+
+char const* GetUpdateFieldStructName(UpdateFieldStruct type)
+{
+    static char const* const Names[] =
+    {
+        "ObjectData", "ItemData", "ContainerData", "UnitData", "PlayerData", "ActivePlayerData", "GameObjectData",
+        "DynamicObjectData", "CorpseData", "AreaTriggerData", "SceneObjectData", "ConversationData"
+    };
+    static_assert(sizeof(Names) / sizeof(Names[0]) == uint32(UpdateFieldStruct::Max), "one name per struct");
+
+    return type < UpdateFieldStruct::Max ? Names[uint32(type)] : nullptr;
+}
+
+UpdateFieldDecodeContext& UpdateFieldDecodeContext::Current()
+{
+    static thread_local UpdateFieldDecodeContext context;
+    return context;
+}
+
+}
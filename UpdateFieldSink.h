@@ -0,0 +1,95 @@
+#ifndef _UPDATEFIELDSINK_H
+#define _UPDATEFIELDSINK_H
+
+#include "Define.h"
+#include "ObjectGuid.h"
+
+namespace UF
+{
+
+/// Top level structs of a values block, in the order they are serialized.
+enum class UpdateFieldStruct : uint8
+{
+    Object,
+    Item,
+    Container,
+    Unit,
+    Player,
+    ActivePlayer,
+    GameObject,
+    DynamicObject,
+    Corpse,
+    AreaTrigger,
+    SceneObject,
+    Conversation,
+
+    Max
+};
+
+/// "UnitData" for UpdateFieldStruct::Unit, nullptr for Max.
+char const* GetUpdateFieldStructName(UpdateFieldStruct type);
+
+/// Observer of decoded structs, called once after every top level ReadCreate/ReadUpdate.
+/// Sinks are chained like StatUpdateForwarder: overrides call the base to keep the rest of the chain working.
+class UpdateFieldSink
+{
+public:
+    explicit UpdateFieldSink(UpdateFieldSink* next = nullptr) : _next(next) { }
+    virtual ~UpdateFieldSink() { }
+
+    void SetNext(UpdateFieldSink* next) { _next = next; }
+    UpdateFieldSink* GetNext() const { return _next; }
+
+    /// 'mask' holds the changes mask of an update as read from the packet, 32 bits per word, bit i of the
+    /// UpdateMask in word i / 32. It is nullptr for a create, where every field was (re)written.
+    virtual void OnStructDecoded(UpdateFieldStruct type, void const* fields, uint32 const* mask, uint32 maskWords)
+    {
+        if (_next)
+            _next->OnStructDecoded(type, fields, mask, maskWords);
+    }
+
+private:
+    UpdateFieldSink* _next;
+};
+
+/// True when field 'bit' was written by the decode being reported.
+inline bool IsFieldDecoded(uint32 const* mask, uint32 maskWords, uint32 bit)
+{
+    return !mask || (bit / 32 < maskWords && (mask[bit / 32] & (1u << (bit % 32))) != 0);
+}
+
+/// Object whose values block the current thread is decoding. The decoders don't know which object they fill,
+/// so whoever dispatches a values block describes it here for the sinks.
+struct UpdateFieldDecodeContext
+{
+    ObjectGuid Guid;
+    uint8 ObjectTypeId = 0;             // TypeID of the object (TYPEID_UNIT, TYPEID_GAMEOBJECT, ...)
+    UpdateFieldSink* Sink = nullptr;
+
+    static UpdateFieldDecodeContext& Current();
+};
+
+/// Describes the values block decoded on this thread until the scope ends.
+class UpdateFieldDecodeScope
+{
+public:
+    UpdateFieldDecodeScope(ObjectGuid const& guid, uint8 objectTypeId, UpdateFieldSink* sink) : _previous(UpdateFieldDecodeContext::Current())
+    {
+        UpdateFieldDecodeContext& context = UpdateFieldDecodeContext::Current();
+        context.Guid = guid;
+        context.ObjectTypeId = objectTypeId;
+        context.Sink = sink;
+    }
+
+    ~UpdateFieldDecodeScope() { UpdateFieldDecodeContext::Current() = _previous; }
+
+    UpdateFieldDecodeScope(UpdateFieldDecodeScope const&) = delete;
+    UpdateFieldDecodeScope& operator=(UpdateFieldDecodeScope const&) = delete;
+
+private:
+    UpdateFieldDecodeContext _previous;
+};
+
+}
+
+#endif
@@ -1,27 +1,77 @@
+#include "UpdateFieldsStream.h"
+#include "AllocationAccounting.h"
+#include "BitReader.h"
+#include "DecodeDiff.h"
+#include "DecodeTrace.h"
+#include "PackedGuidReader.h"
+#include "StatUpdateRecorder.h"
+#include "UpdateFieldSink.h"
+#include <type_traits>
 
 
 namespace UF
 {
 
+    /// Grows 'values' to hold 'index'. Callers truncate to the received size once all elements are read.
     template<typename T>
-    T& EnsureCapasity(std::vector<T> values, uint32 index)
+    T& EnsureCapasity(std::vector<T>& values, uint32 index)
     {
-        values.emplace(values.begin() + index);
-
+        if (index >= values.size())
+        {
+            UF_ALLOCATION_SITE("EnsureCapasity");
+            values.resize(index + 1);
+        }
         return values[index];
     }
 
+static inline void NotifyDecoded(StructDecodeMark const& mark, ByteBuffer const& data, void const* fields, uint32 const* mask, uint32 maskWords)
+{
+    mark.Finish(data, mask, maskWords);
+    if (UpdateFieldSink* sink = UpdateFieldDecodeContext::Current().Sink)
+        sink->OnStructDecoded(mark.GetStruct(), fields, mask, maskWords);
+}
+
+#ifdef UF_WITH_DECODE_DIFF
+/// Listener for decoders without IStatUpdate, StatUpdateForwarder without next ignores every callback.
+static IStatUpdate& NoStatUpdate()
+{
+    static StatUpdateForwarder none;
+    return none;
+}
+
+/// Sends a top level decoder through DecodeDifferential, which calls it again for each of its two decodes.
+/// 'read' is the decoder's own call on diffData and diffUpdate.
+#define UF_DECODE_DIFFERENTIAL(update, read) \
+    if (!IsDifferentialDecode()) \
+    { \
+        typedef std::remove_reference<decltype(*this)>::type DiffFields; \
+        DecodeDifferential(data, *this, update, [&](ByteBuffer& diffData, DiffFields& diffFields, IStatUpdate& diffUpdate) \
+        { \
+            (void)diffUpdate; \
+            diffFields.read; \
+        }); \
+        return; \
+    }
+#else
+#define UF_DECODE_DIFFERENTIAL(update, read)
+#endif
+
 
 void ObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
 {
+    UF_DECODE_DIFFERENTIAL(update, ReadCreate(diffData, fieldVisibilityFlags, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Object);
     data >> EntryID._value;
     data >> DynamicFlags._value;
     data >> Scale._value;
     //update.OnObjectDynamicFlags(0, DynamicFlags);
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void ObjectData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
 {
+    UF_DECODE_DIFFERENTIAL(update, ReadUpdate(diffData, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Object);
     uint32 mask = data.ReadBits(4);
     UpdateMask<4> changesMask(mask);
     data.ResetBits();
@@ -43,6 +93,7 @@ void ObjectData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
             data >> Scale._value;
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void ItemEnchantment::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
@@ -192,6 +243,8 @@ void SocketedGem::ReadUpdate(ByteBuffer& data)
 
 void ItemData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::Item);
  
     data >> Owner._value;
     data >> ContainedIn._value;
@@ -228,6 +281,8 @@ void ItemData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisib
     }
     uint32 apSize = data.read<uint32>();
     uint32 gemSize = data.read<uint32>();
+    mark.CheckSize(data, apSize, 4);
+    mark.CheckSize(data, gemSize, 37);
     if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
     {
         data >> DynamicFlags2._value;
@@ -243,22 +298,28 @@ void ItemData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisib
     }
     uint32 itemId = data.read<uint32>();
     uint32 size = data.read<uint32>();
-    for (std::size_t i = 0; i < size; ++i)
+    mark.CheckSize(data, size, 4);
     {
-        uint32 id = data.read<uint32>();
-        BonusListIDs._value.push_back(id);
+        UF_ALLOCATION_SITE("BonusListIDs");
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            uint32 id = data.read<uint32>();
+            BonusListIDs._value.push_back(id);
 
+        }
     }
     Modifiers._value.ReadCreate(data, fieldVisibilityFlags);
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void ItemData::ReadUpdate(ByteBuffer& data)
 {
-    uint32 maskdata[2] = { 0, 0 };
-    UpdateMask<2> mask1(data.ReadBits(2));
-    for (std::size_t i = 0; i < 2; ++i)
-        if (mask1[i])
-            maskdata[i] = data.ReadBits(32);
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::Item);
+    uint32 maskdata[2];
+    BitReader bits(data);
+    bits.ReadMaskBlocks(2, maskdata);
+    bits.ResetBits();
     UpdateMask<64> changesMask(maskdata, sizeof(maskdata)/sizeof(uint32));
     /*if (changesMask[0] && changesMask[1])
     {
@@ -268,7 +329,6 @@ void ItemData::ReadUpdate(ByteBuffer& data)
             data >> EnsureCapasity(BonusListIDs._value, i);
         }
     }*/
-    data.ResetBits();
 
     if (changesMask[0])
     {
@@ -358,27 +418,34 @@ void ItemData::ReadUpdate(ByteBuffer& data)
             }
         }
     }
+    NotifyDecoded(mark, data, this, maskdata, 2);
 }
 
 void ContainerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
 {
+    UF_DECODE_DIFFERENTIAL(update, ReadCreate(diffData, fieldVisibilityFlags, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Container);
+    uint64 old[36];
     for (std::size_t i = 0; i < 36; ++i)
-    {
-        data >> Slots[i];
-    }
+        old[i] = Slots[i]._low;
+    ReadPackedGuids(data, Slots, 36);
     data >> NumSlots._value;
+    for (std::size_t i = 0; i < 36; ++i)
+        if (old[i] != Slots[i]._low)
+            update.OnContainerSlots(old[i], Slots[i]._low, i);
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void ContainerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
 {
-    uint32 maskdata[2] = { 0, 0 };
-    UpdateMask<2> mask1(data.ReadBits(2));
-    for (std::size_t i = 0; i < 2; ++i)
-        if (mask1[i])
-            maskdata[i] = data.ReadBits(32);
+    UF_DECODE_DIFFERENTIAL(update, ReadUpdate(diffData, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Container);
+    uint32 maskdata[2];
+    BitReader bits(data);
+    bits.ReadMaskBlocks(2, maskdata);
+    bits.ResetBits();
     UpdateMask<64> changesMask(maskdata, sizeof(maskdata)/sizeof(uint32));
 
-    data.ResetBits();
     if (changesMask[0])
     {
         if (changesMask[1])
@@ -392,12 +459,13 @@ void ContainerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         {
             if (changesMask[3 + i])
             {
-                uint32 old = 0;
-                data >> Slots[i];
-                update.OnContainerSlots(0, Slots[i]._low, i);
+                uint64 old = Slots[i]._low;
+                PackedGuid::Read(data, Slots[i]);
+                update.OnContainerSlots(old, Slots[i]._low, i);
             }
         }
     }
+    NotifyDecoded(mark, data, this, maskdata, 2);
 }
 
 void UnitChannel::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
@@ -454,6 +522,8 @@ void PassiveSpellHistory::ReadUpdate(ByteBuffer& data)
 
 void UnitData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
 {
+    UF_DECODE_DIFFERENTIAL(update, ReadCreate(diffData, fieldVisibilityFlags, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Unit);
     data >> Health._value;
     update.OnUnitHealth(0, Health);
     data >> MaxHealth._value;
@@ -466,23 +536,21 @@ void UnitData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisib
     data >> StateAnimID._value;
     data >> StateAnimKitID._value;
     uint32 size = data.read<uint32>();
+    mark.CheckSize(data, size, 4);
     for (std::size_t i = 0; i < size; ++i)
     {
         data >> EnsureCapasity(StateWorldEffectIDs._value, i);
     }
-    data >> Charm._value;
-    data >> Summon._value;
+    StateWorldEffectIDs._value.resize(size);
+    ObjectGuid* charms[] = { &Charm._value, &Summon._value };
+    ReadPackedGuidFields(data, charms, 2);
     if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
     {
-        data >> Critter._value;
+        PackedGuid::Read(data, Critter._value);
     }
-    data >> CharmedBy._value;
-    data >> SummonedBy._value;
-    data >> CreatedBy._value;
-    data >> DemonCreator._value;
-    data >> LookAtControllerTarget._value;
-    data >> Target._value;
-    data >> BattlePetCompanionGUID._value;
+    ObjectGuid* links[] = { &CharmedBy._value, &SummonedBy._value, &CreatedBy._value, &DemonCreator._value,
+        &LookAtControllerTarget._value, &Target._value, &BattlePetCompanionGUID._value };
+    ReadPackedGuidFields(data, links, 7);
     data >> BattlePetDBID._value;
     ChannelData._value.ReadCreate(data, fieldVisibilityFlags);
     data >> SummonedByHomeRealm._value;
@@ -638,6 +706,9 @@ void UnitData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisib
     uint32 ps = data.read<uint32>();
     uint32 we = data.read<uint32>();
     uint32 co = data.read<uint32>();
+    mark.CheckSize(data, ps, 8);
+    mark.CheckSize(data, we, 4);
+    mark.CheckSize(data, co, 2);
     data >> SkinningOwnerGUID._value;
     data >> unknown;
 
@@ -657,15 +728,17 @@ void UnitData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisib
     {
         data >> ChannelObjects[i];
     }
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void UnitData::ReadUpdate(ByteBuffer& data, IStatUpdate &update)
 {
-    UpdateMask<8> mask(data.ReadBits(8));//changed 3.4.2 guess
-    uint32 m[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-    for (std::size_t i = 0; i < 8; ++i)
-        if (mask[i])
-            m[i] = data.ReadBits(32);
+    UF_DECODE_DIFFERENTIAL(update, ReadUpdate(diffData, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Unit);
+    uint32 m[8];
+    BitReader bits(data);
+    bits.ReadMaskBlocks(8, m);//changed 3.4.2 guess
+    bits.Sync();
 
     UpdateMask<32 * 8> changesMask(m, sizeof(m)/sizeof(uint32));
 
@@ -674,14 +747,12 @@ void UnitData::ReadUpdate(ByteBuffer& data, IStatUpdate &update)
         if (changesMask[1])
         {
             uint32 size = data.ReadBits(32);
-            if (size)
+            mark.CheckSize(data, size, 4);
+            for (std::size_t i = 0; i < size; ++i)
             {
-                data >> EnsureCapasity(StateWorldEffectIDs._value, size);
-                for (std::size_t i = 0; i < size; ++i)
-                {
-                    data >> StateWorldEffectIDs._value[i];
-                }
+                data >> EnsureCapasity(StateWorldEffectIDs._value, i);
             }
+            StateWorldEffectIDs._value.resize(size);
         }
     }
     data.ResetBits();
@@ -762,43 +833,43 @@ void UnitData::ReadUpdate(ByteBuffer& data, IStatUpdate &update)
         }
         if (changesMask[11])
         {
-            data >> Charm._value;
+            PackedGuid::Read(data, Charm._value);
         }
         if (changesMask[12])
         {
-            data >> Summon._value;
+            PackedGuid::Read(data, Summon._value);
         }
         if (changesMask[13])
         {
-            data >> Critter._value;
+            PackedGuid::Read(data, Critter._value);
         }
         if (changesMask[14])
         {
-            data >> CharmedBy._value;
+            PackedGuid::Read(data, CharmedBy._value);
         }
         if (changesMask[15])
         {
-            data >> SummonedBy._value;
+            PackedGuid::Read(data, SummonedBy._value);
         }
         if (changesMask[16])
         {
-            data >> CreatedBy._value;
+            PackedGuid::Read(data, CreatedBy._value);
         }
         if (changesMask[17])
         {
-            data >> DemonCreator._value;
+            PackedGuid::Read(data, DemonCreator._value);
         }
         if (changesMask[18])
         {
-            data >> LookAtControllerTarget._value;
+            PackedGuid::Read(data, LookAtControllerTarget._value);
         }
         if (changesMask[19])
         {
-            data >> Target._value;
+            PackedGuid::Read(data, Target._value);
         }
         if (changesMask[20])
         {
-            data >> BattlePetCompanionGUID._value;
+            PackedGuid::Read(data, BattlePetCompanionGUID._value);
         }
         if (changesMask[21])
         {
@@ -1277,6 +1348,7 @@ void UnitData::ReadUpdate(ByteBuffer& data, IStatUpdate &update)
             }
         }
     }
+    NotifyDecoded(mark, data, this, m, 8);
 }
 
 void ChrCustomizationChoice::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
@@ -1411,6 +1483,8 @@ void ArenaCooldown::ReadUpdate(ByteBuffer& data)
 
 void PlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
 {
+    UF_DECODE_DIFFERENTIAL(update, ReadCreate(diffData, fieldVisibilityFlags, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Player);
     data >> DuelArbiter._value;
     data >> WowAccount._value;
     data >> LootTargetGUID._value;
@@ -1420,6 +1494,7 @@ void PlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVis
     data >> GuildDeleteDate._value;
     data >> GuildLevel._value;
     uint32 csize = data.read<uint32>();
+    mark.CheckSize(data, csize, 8);
     data >> PartyType._value;
     data >> NativeSex._value;
     data >> Inebriation._value;
@@ -1454,6 +1529,7 @@ void PlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVis
     uint64 LogoutTime;
     data >> LogoutTime;
     uint32 acsize = data.read<uint32>();//position verified @3.4.2
+    mark.CheckSize(data, acsize, 32);
     uint32 Field_B0, Field_B4;//guess
     data >> Field_B0 >> Field_B0;//guess
 
@@ -1471,15 +1547,17 @@ void PlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVis
     {
         ArenaCooldowns[i].ReadCreate(data, fieldVisibilityFlags);
     }
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void PlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
 {
-    UpdateMask<4> mask(data.ReadBits(4));
-    uint32 m[4] = { 0, 0, 0, 0 };
-    for (std::size_t i = 0; i < 4; ++i)
-        if (mask[i])
-            m[i] = data.ReadBits(32);
+    UF_DECODE_DIFFERENTIAL(update, ReadUpdate(diffData, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::Player);
+    uint32 m[4];
+    BitReader bits(data);
+    bits.ReadMaskBlocks(4, m);
+    bits.Sync();
 
     UpdateMask<32 * 4> changesMask(m, sizeof(m)/sizeof(uint32));
     bool noQuestLogChangesMask = data.ReadBit();
@@ -1687,6 +1765,7 @@ void PlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         }
 
     }
+    NotifyDecoded(mark, data, this, m, 4);
 }
 
 void SkillInfo::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
@@ -1707,16 +1786,15 @@ void SkillInfo::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisi
 
 void SkillInfo::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
 {
-    uint32 m[2] = { data.read<uint32>(), data.ReadBits(25) };
-    UpdateMask<57> msk(m, sizeof(m)/sizeof(uint32));
-    uint32 v[57] = { 0 };
-    memset(v, 0, sizeof(v));
-    for (std::size_t i = 0; i < 57; ++i)
-        if (msk[i])
-            v[i] = data.ReadBits(32);
+    uint32 m[2];
+    m[0] = data.read<uint32>();
+    BitReader bits(data);
+    m[1] = bits.ReadBits(25);
+    uint32 v[57];
+    bits.ReadMaskBlocks(57, m, v);
+    bits.ResetBits();
     UpdateMask<1793> changesMask(v, sizeof(v)/sizeof(uint32));
 
-    data.ResetBits();
     if (changesMask[0])
     {
         for (std::size_t i = 0; i < 256; ++i)
@@ -1968,273 +2046,394 @@ void GlyphInfo::ReadUpdate(ByteBuffer& data)
 }
 
 
-void ActivePlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
+template<typename Read>
+static bool ReadResumable(ByteBuffer& data, bool resumable, Read&& read)
 {
-    uint32 pos = data.rpos();
-    for (std::size_t i = 0; i < 129 + 12; ++i)
-    {
-        data >> InvSlots[i];
-    }
-    data >> FarsightObject._value;
-    data >> ComboTarget._value;
-    uint32 titlesize = data.read<uint32>();
-    data >> Coinage._value;
-    update.OnActivePlayerCoinage(0, Coinage);
-    data >> XP._value;
-    data >> NextLevelXP._value;
-    data >> TrialXP._value;
-    Skill._value.ReadCreate(data, fieldVisibilityFlags, update);
-    data >> CharacterPoints._value;
-    data >> MaxTalentTiers._value;
-    data >> TrackCreatureMask._value;
-    for (std::size_t i = 0; i < 2; ++i)
+    std::size_t pos = data.rpos();
+    try
     {
-        data >> TrackResourceMask[i];
-    }
-    data >> MainhandExpertise._value;
-    data >> OffhandExpertise._value;
-    data >> RangedExpertise._value;
-    data >> CombatRatingExpertise._value;
-    data >> BlockPercentage._value;
-    data >> DodgePercentage._value;
-    data >> DodgePercentageFromAttribute._value;
-    data >> ParryPercentage._value;
-    data >> ParryPercentageFromAttribute._value;
-    data >> CritPercentage._value;
-    data >> RangedCritPercentage._value;
-    data >> OffhandCritPercentage._value;
-    for (std::size_t i = 0; i < 7; ++i)
-    {
-        data >> SpellCritPercentage[i];
-        data >> ModDamageDonePos[i];
-        data >> ModDamageDoneNeg[i];
-        data >> ModDamageDonePercent[i];
-    }
-    data >> ShieldBlock._value;
-    data >> Mastery._value;
-    data >> Speed._value;
-    data >> Avoidance._value;
-    data >> Sturdiness._value;
-    data >> Unk340_3._value;
-    data >> Versatility._value;
-    data >> VersatilityBonus._value;
-    data >> PvpPowerDamage._value;
-    data >> PvpPowerHealing._value;
-    for (std::size_t i = 0; i < 240; ++i)
-    {
-        data >> ExploredZones[i];
+        read();
     }
-    for (std::size_t i = 0; i < 2; ++i)
+    catch (ByteBufferPositionException const&)
     {
-        RestInfo[i].ReadCreate(data, fieldVisibilityFlags);
+        if (!resumable)
+            throw;
+        data.rpos(pos);
+        data.ResetBits();
+        return false;
     }
-    data >> ModHealingDonePos._value;
-    data >> ModHealingPercent._value;
-    data >> ModHealingDonePercent._value;
-    data >> ModPeriodicHealingDonePercent._value;
-    for (std::size_t i = 0; i < 3; ++i)
-    {
-        data >> WeaponDmgMultipliers[i];
-        data >> WeaponAtkSpeedMultipliers[i];
-    }
-    data >> ModSpellPowerPercent._value;
-    data >> ModResiliencePercent._value;
-    data >> OverrideSpellPowerByAPPercent._value;
-    data >> OverrideAPBySpellPowerPercent._value;
-    data >> ModTargetResistance._value;
-    data >> ModTargetPhysicalResistance._value;
-    data >> LocalFlags._value;
-    data >> GrantableLevels._value;
-    data >> MultiActionBars._value;
-    data >> LifetimeMaxRank._value;
-    data >> NumRespecs._value;
-    data >> AmmoID._value;
-    data >> PvpMedals._value;
-    for (std::size_t i = 0; i < 12; ++i)
-    {
-        data >> BuybackPrice[i];
-        data >> BuybackTimestamp[i];
-    }
-    data >> TodayHonorableKills._value;
-    data >> TodayDishonorableKills._value;
-    data >> YesterdayHonorableKills._value;
-    data >> YesterdayDishonorableKills._value;
-    data >> LastWeekHonorableKills._value;
-    data >> LastWeekDishonorableKills._value;
-    data >> ThisWeekHonorableKills._value;
-    data >> ThisWeekDishonorableKills._value;
-    data >> ThisWeekContribution._value;
-    data >> LifetimeHonorableKills._value;
-    data >> LifetimeDishonorableKills._value;
-    data >> YesterdayContribution._value;
-    data >> LastWeekContribution._value;
-    data >> LastWeekRank._value;
-    data >> WatchedFactionIndex._value;
-    for (std::size_t i = 0; i < 32; ++i)
-    {
-        data >> CombatRatings[i];
-    }
-    data >> MaxLevel._value;//60, 70, 80 ....
-    data >> ScalingPlayerLevelDelta._value;
-    data >> MaxCreatureScalingLevel._value;
-    for (std::size_t i = 0; i < 4; ++i)
-    {
-        data >> NoReagentCostMask[i];
-    }
-    data >> PetSpellPower._value;
-    for (std::size_t i = 0; i < 2; ++i)
-    {
-        data >> ProfessionSkillLine[i];//pos verified @3.4.2
-    }
-    data >> UiHitModifier._value;
-    data >> UiSpellHitModifier._value;
-    data >> HomeRealmTimeOffset._value;
-    data >> ModPetHaste._value;
-    //JailersTowerLevelMax, JailersTowerLevel
-    data >> LocalRegenFlags._value;
-    data >> AuraVision._value;
-    data >> NumBackpackSlots._value;
-    data >> OverrideSpellsID._value;
-    data >> LfgBonusFactionID._value;
-    data >> LootSpecID._value;
-    data >> OverrideZonePVPType._value;
-    for (std::size_t i = 0; i < 4; ++i)
-    {
-        data >> BagSlotFlags[i];
-    }
-    for (std::size_t i = 0; i < 7; ++i)
-    {
-        data >> BankBagSlotFlags[i];
-    }
-    for (std::size_t i = 0; i < 875; ++i)
-    {
-        data >> QuestCompleted[i];
-    }
-    data >> Honor._value;
-    data >> HonorNextLevel._value;//5500
-    data >> PvpTierMaxFromWins._value;
-    data >> PvpLastWeeksTierMaxFromWins._value;
-    data >> NumBankSlots._value;
-    uint32 rsSize = data.read<uint32>();
-    uint32 rspsize = data.read<uint32>();
-
-    uint32 dqcsize = data.read<uint32>();
-    uint32 aqlxqsize = data.read<uint32>();
-
-    uint32 Unk254size = data.read<uint32>();//not exist in 10.1.5
-
-    uint32 hsize = data.read<uint32>();
-    uint32 hfsize = data.read<uint32>();
-
-    uint32 tsize = data.read<uint32>();
-    //ToyFlags
-    uint32 tmsize = data.read<uint32>();
-    uint32 ctmsize = data.read<uint32>();
+    return true;
+}
 
-    uint32 srssize = data.read<uint32>();
-    //RuneforgePowers
-    //TransmogIllusions
-    uint32 crsize = data.read<uint32>();
-    uint32 spmlsize = data.read<uint32>();
-    uint32 sfmlsize = data.read<uint32>();
-    for (std::size_t i = 0; i < 1; ++i)
+static bool ReadActivePlayerCreateStages(ActivePlayerData& fields, ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags,
+    IStatUpdate& update, ActivePlayerCreateCursor& cursor, bool resumable)
+{
+    ActivePlayerData& f = fields;
+    uint32* sizes = cursor.Sizes;
+    for (;;)
     {
-        uint32 size = data.read<uint32>();
-        for (std::size_t j = 0; j < size; ++j)
+        switch (cursor.Stage)
         {
-            Research[i][j].ReadCreate(data, fieldVisibilityFlags);
+            case ACTIVE_PLAYER_CREATE_INV_SLOTS:
+            {
+                uint64 old[129 + 12];
+                for (std::size_t i = cursor.Index; i < 129 + 12; ++i)
+                    old[i] = f.InvSlots[i]._low;
+                uint32 first = cursor.Index;
+                // the whole array is decoded in one batch when it is known to be received completely
+                if (!cursor.Index && !IsReferenceDecode() && (!resumable || data.size() - data.rpos() >= (129 + 12) * MaxPackedGuidSize))
+                {
+                    ReadPackedGuids(data, f.InvSlots, 129 + 12);
+                    cursor.Index = 129 + 12;
+                }
+                bool complete = true;
+                for (; cursor.Index < 129 + 12; ++cursor.Index)
+                {
+                    if (!ReadResumable(data, resumable, [&] { data >> f.InvSlots[cursor.Index]; }))
+                    {
+                        complete = false;
+                        break;
+                    }
+                }
+                for (std::size_t i = first; i < cursor.Index; ++i)
+                    if (old[i] != f.InvSlots[i]._low)
+                        update.OnActivePlayerInvSlot(old[i], f.InvSlots[i]._low, i);
+                if (!complete)
+                    return false;
+                break;
+            }
+            case ACTIVE_PLAYER_CREATE_HEADER:
+                if (!ReadResumable(data, resumable, [&]
+                {
+                    data >> f.FarsightObject._value;
+                    data >> f.ComboTarget._value;
+                    sizes[ACTIVE_PLAYER_SIZE_KNOWN_TITLES] = data.read<uint32>();
+                    data >> f.Coinage._value;
+                    data >> f.XP._value;
+                    data >> f.NextLevelXP._value;
+                    data >> f.TrialXP._value;
+                }))
+                    return false;
+                update.OnActivePlayerCoinage(0, f.Coinage);
+                break;
+            case ACTIVE_PLAYER_CREATE_SKILL:
+            {
+                // skill callbacks are held back until the whole SkillInfo was received
+                StatUpdateRecorder skillUpdates;
+                if (!ReadResumable(data, resumable, [&] { f.Skill._value.ReadCreate(data, fieldVisibilityFlags, skillUpdates); }))
+                    return false;
+                skillUpdates.Replay(update);
+                break;
+            }
+            case ACTIVE_PLAYER_CREATE_STATS:
+                if (!ReadResumable(data, resumable, [&]
+                {
+                    data >> f.CharacterPoints._value;
+                    data >> f.MaxTalentTiers._value;
+                    data >> f.TrackCreatureMask._value;
+                    for (std::size_t i = 0; i < 2; ++i)
+                    {
+                        data >> f.TrackResourceMask[i];
+                    }
+                    data >> f.MainhandExpertise._value;
+                    data >> f.OffhandExpertise._value;
+                    data >> f.RangedExpertise._value;
+                    data >> f.CombatRatingExpertise._value;
+                    data >> f.BlockPercentage._value;
+                    data >> f.DodgePercentage._value;
+                    data >> f.DodgePercentageFromAttribute._value;
+                    data >> f.ParryPercentage._value;
+                    data >> f.ParryPercentageFromAttribute._value;
+                    data >> f.CritPercentage._value;
+                    data >> f.RangedCritPercentage._value;
+                    data >> f.OffhandCritPercentage._value;
+                    for (std::size_t i = 0; i < 7; ++i)
+                    {
+                        data >> f.SpellCritPercentage[i];
+                        data >> f.ModDamageDonePos[i];
+                        data >> f.ModDamageDoneNeg[i];
+                        data >> f.ModDamageDonePercent[i];
+                    }
+                    data >> f.ShieldBlock._value;
+                    data >> f.Mastery._value;
+                    data >> f.Speed._value;
+                    data >> f.Avoidance._value;
+                    data >> f.Sturdiness._value;
+                    data >> f.Unk340_3._value;
+                    data >> f.Versatility._value;
+                    data >> f.VersatilityBonus._value;
+                    data >> f.PvpPowerDamage._value;
+                    data >> f.PvpPowerHealing._value;
+                }))
+                    return false;
+                break;
+            case ACTIVE_PLAYER_CREATE_EXPLORED_ZONES:
+                for (; cursor.Index < 240; ++cursor.Index)
+                    if (!ReadResumable(data, resumable, [&] { data >> f.ExploredZones[cursor.Index]; }))
+                        return false;
+                break;
+            case ACTIVE_PLAYER_CREATE_MISC:
+                if (!ReadResumable(data, resumable, [&]
+                {
+                    for (std::size_t i = 0; i < 2; ++i)
+                    {
+                        f.RestInfo[i].ReadCreate(data, fieldVisibilityFlags);
+                    }
+                    data >> f.ModHealingDonePos._value;
+                    data >> f.ModHealingPercent._value;
+                    data >> f.ModHealingDonePercent._value;
+                    data >> f.ModPeriodicHealingDonePercent._value;
+                    for (std::size_t i = 0; i < 3; ++i)
+                    {
+                        data >> f.WeaponDmgMultipliers[i];
+                        data >> f.WeaponAtkSpeedMultipliers[i];
+                    }
+                    data >> f.ModSpellPowerPercent._value;
+                    data >> f.ModResiliencePercent._value;
+                    data >> f.OverrideSpellPowerByAPPercent._value;
+                    data >> f.OverrideAPBySpellPowerPercent._value;
+                    data >> f.ModTargetResistance._value;
+                    data >> f.ModTargetPhysicalResistance._value;
+                    data >> f.LocalFlags._value;
+                    data >> f.GrantableLevels._value;
+                    data >> f.MultiActionBars._value;
+                    data >> f.LifetimeMaxRank._value;
+                    data >> f.NumRespecs._value;
+                    data >> f.AmmoID._value;
+                    data >> f.PvpMedals._value;
+                    for (std::size_t i = 0; i < 12; ++i)
+                    {
+                        data >> f.BuybackPrice[i];
+                        data >> f.BuybackTimestamp[i];
+                    }
+                    data >> f.TodayHonorableKills._value;
+                    data >> f.TodayDishonorableKills._value;
+                    data >> f.YesterdayHonorableKills._value;
+                    data >> f.YesterdayDishonorableKills._value;
+                    data >> f.LastWeekHonorableKills._value;
+                    data >> f.LastWeekDishonorableKills._value;
+                    data >> f.ThisWeekHonorableKills._value;
+                    data >> f.ThisWeekDishonorableKills._value;
+                    data >> f.ThisWeekContribution._value;
+                    data >> f.LifetimeHonorableKills._value;
+                    data >> f.LifetimeDishonorableKills._value;
+                    data >> f.YesterdayContribution._value;
+                    data >> f.LastWeekContribution._value;
+                    data >> f.LastWeekRank._value;
+                    data >> f.WatchedFactionIndex._value;
+                    for (std::size_t i = 0; i < 32; ++i)
+                    {
+                        data >> f.CombatRatings[i];
+                    }
+                    data >> f.MaxLevel._value;//60, 70, 80 ....
+                    data >> f.ScalingPlayerLevelDelta._value;
+                    data >> f.MaxCreatureScalingLevel._value;
+                    for (std::size_t i = 0; i < 4; ++i)
+                    {
+                        data >> f.NoReagentCostMask[i];
+                    }
+                    data >> f.PetSpellPower._value;
+                    for (std::size_t i = 0; i < 2; ++i)
+                    {
+                        data >> f.ProfessionSkillLine[i];//pos verified @3.4.2
+                    }
+                    data >> f.UiHitModifier._value;
+                    data >> f.UiSpellHitModifier._value;
+                    data >> f.HomeRealmTimeOffset._value;
+                    data >> f.ModPetHaste._value;
+                    //JailersTowerLevelMax, JailersTowerLevel
+                    data >> f.LocalRegenFlags._value;
+                    data >> f.AuraVision._value;
+                    data >> f.NumBackpackSlots._value;
+                    data >> f.OverrideSpellsID._value;
+                    data >> f.LfgBonusFactionID._value;
+                    data >> f.LootSpecID._value;
+                    data >> f.OverrideZonePVPType._value;
+                    for (std::size_t i = 0; i < 4; ++i)
+                    {
+                        data >> f.BagSlotFlags[i];
+                    }
+                    for (std::size_t i = 0; i < 7; ++i)
+                    {
+                        data >> f.BankBagSlotFlags[i];
+                    }
+                }))
+                    return false;
+                break;
+            case ACTIVE_PLAYER_CREATE_QUEST_COMPLETED:
+                for (; cursor.Index < 875; ++cursor.Index)
+                {
+                    uint64 old = f.QuestCompleted[cursor.Index];
+                    if (!ReadResumable(data, resumable, [&] { data >> f.QuestCompleted[cursor.Index]; }))
+                        return false;
+                    if (f.QuestCompleted[cursor.Index] & ~old)
+                        update.OnActivePlayerQuestCompleted(old, f.QuestCompleted[cursor.Index], cursor.Index);
+                }
+                break;
+            case ACTIVE_PLAYER_CREATE_DYNAMIC_HEADER:
+                if (!ReadResumable(data, resumable, [&]
+                {
+                    data >> f.Honor._value;
+                    data >> f.HonorNextLevel._value;//5500
+                    data >> f.PvpTierMaxFromWins._value;
+                    data >> f.PvpLastWeeksTierMaxFromWins._value;
+                    data >> f.NumBankSlots._value;
+                    sizes[ACTIVE_PLAYER_SIZE_RESEARCH_SITES] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_RESEARCH_SITE_PROGRESS] = data.read<uint32>();
+
+                    sizes[ACTIVE_PLAYER_SIZE_DAILY_QUESTS_COMPLETED] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_AVAILABLE_QUEST_LINE_X_QUEST_IDS] = data.read<uint32>();
+
+                    sizes[ACTIVE_PLAYER_SIZE_UNK254] = data.read<uint32>();//not exist in 10.1.5
+
+                    sizes[ACTIVE_PLAYER_SIZE_HEIRLOOMS] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_HEIRLOOM_FLAGS] = data.read<uint32>();
+
+                    sizes[ACTIVE_PLAYER_SIZE_TOYS] = data.read<uint32>();
+                    //ToyFlags
+                    sizes[ACTIVE_PLAYER_SIZE_TRANSMOG] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_CONDITIONAL_TRANSMOG] = data.read<uint32>();
+
+                    sizes[ACTIVE_PLAYER_SIZE_SELF_RES_SPELLS] = data.read<uint32>();
+                    //RuneforgePowers
+                    //TransmogIllusions
+                    sizes[ACTIVE_PLAYER_SIZE_CHARACTER_RESTRICTIONS] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_SPELL_PCT_MOD_BY_LABEL] = data.read<uint32>();
+                    sizes[ACTIVE_PLAYER_SIZE_SPELL_FLAT_MOD_BY_LABEL] = data.read<uint32>();
+                    for (std::size_t i = 0; i < 1; ++i)
+                    {
+                        uint32 size = data.read<uint32>();
+                        for (std::size_t j = 0; j < size; ++j)
+                        {
+                            f.Research[i][j].ReadCreate(data, fieldVisibilityFlags);
+                        }
+                    }
+                    uint32 UiChromieTimeExpansionID, unk2, unk3 = 0;
+                    data >> UiChromieTimeExpansionID;
+                    data >> f.TransportServerTime._value;//position verifyed
+                    data >> unk2 >> unk3;
+                    for (std::size_t i = 0; i < 6; ++i)//position verifyed  0x15 00 00 00 00 00 00 00 0x16 00 00 00 00 00 00 00 0x17 00 ....
+                    {
+                        f.GlyphInfos[i].ReadCreate(data, fieldVisibilityFlags);
+                    }
+                    data >> f.GlyphsEnabled._value;
+                    data >> f.Unk340._value;
+                }))
+                    return false;
+                cursor.Array = ACTIVE_PLAYER_SIZE_KNOWN_TITLES;
+                break;
+            case ACTIVE_PLAYER_CREATE_DYNAMIC_VALUES:
+                for (; cursor.Array <= ACTIVE_PLAYER_SIZE_SPELL_FLAT_MOD_BY_LABEL; ++cursor.Array, cursor.Index = 0)
+                {
+                    for (; cursor.Index < sizes[cursor.Array]; ++cursor.Index)
+                    {
+                        uint32 i = cursor.Index;
+                        if (!ReadResumable(data, resumable, [&]
+                        {
+                            switch (cursor.Array)
+                            {
+                                case ACTIVE_PLAYER_SIZE_KNOWN_TITLES: data >> f.KnownTitles[i]; break;
+                                case ACTIVE_PLAYER_SIZE_RESEARCH_SITES: data >> f.ResearchSites[i]; break;
+                                case ACTIVE_PLAYER_SIZE_RESEARCH_SITE_PROGRESS: data >> f.ResearchSiteProgress[i]; break;
+                                case ACTIVE_PLAYER_SIZE_DAILY_QUESTS_COMPLETED: data >> f.DailyQuestsCompleted[i]; break;
+                                case ACTIVE_PLAYER_SIZE_AVAILABLE_QUEST_LINE_X_QUEST_IDS: data >> f.AvailableQuestLineXQuestIDs[i]; break;
+                                case ACTIVE_PLAYER_SIZE_UNK254: data >> f.Unk254[i]; break;
+                                case ACTIVE_PLAYER_SIZE_HEIRLOOMS: data >> f.Heirlooms[i]; break;
+                                case ACTIVE_PLAYER_SIZE_HEIRLOOM_FLAGS: data >> f.HeirloomFlags[i]; break;
+                                case ACTIVE_PLAYER_SIZE_TOYS: data >> f.Toys[i]; break;
+                                case ACTIVE_PLAYER_SIZE_TRANSMOG: data >> f.Transmog[i]; break;
+                                case ACTIVE_PLAYER_SIZE_CONDITIONAL_TRANSMOG: data >> f.ConditionalTransmog[i]; break;
+                                case ACTIVE_PLAYER_SIZE_SELF_RES_SPELLS: data >> f.SelfResSpells[i]; break;
+                                case ACTIVE_PLAYER_SIZE_SPELL_PCT_MOD_BY_LABEL: f.SpellPctModByLabel[i].ReadCreate(data, fieldVisibilityFlags); break;
+                                case ACTIVE_PLAYER_SIZE_SPELL_FLAT_MOD_BY_LABEL: f.SpellFlatModByLabel[i].ReadCreate(data, fieldVisibilityFlags); break;
+                                default: break;
+                            }
+                        }))
+                            return false;
+                    }
+                }
+                break;
+            case ACTIVE_PLAYER_CREATE_TRAILER:
+                if (!ReadResumable(data, resumable, [&]
+                {
+                    for (std::size_t i = 0; i < 7; ++i)
+                    {
+                        f.PvpInfo[i].ReadCreate(data, fieldVisibilityFlags);
+                    }
+                    (bool&)f.InsertItemsLeftToRight = data.ReadBit();
+                    data.ResetBits();
+                    for (std::size_t i = 0; i < sizes[ACTIVE_PLAYER_SIZE_CHARACTER_RESTRICTIONS]; ++i)
+                    {
+                        f.CharacterRestrictions[i].ReadCreate(data, fieldVisibilityFlags);
+                    }
+
+                    if (data.rpos() + 49 > data.size())
+                        throw ByteBufferPositionException(data.rpos(), 49, data.size());
+                    data.rpos(data.rpos() + 49);
+                }))
+                    return false;
+                break;
+            default:
+                return true;
         }
-    }
-    uint32 UiChromieTimeExpansionID, unk2, unk3 = 0;
-    data >> UiChromieTimeExpansionID;
-    data >> TransportServerTime._value;//position verifyed
-    data >> unk2 >> unk3;
-    for (std::size_t i = 0; i < 6; ++i)//position verifyed  0x15 00 00 00 00 00 00 00 0x16 00 00 00 00 00 00 00 0x17 00 ....
-    {
-        GlyphInfos[i].ReadCreate(data, fieldVisibilityFlags);
-    }
-    data >> GlyphsEnabled._value;
-    data >> Unk340._value;
 
-    for (std::size_t i = 0; i < titlesize; ++i)
-    {
-        data >> KnownTitles[i];
-    }
-    for (std::size_t i = 0; i < rsSize; ++i)
-    {
-        data >> ResearchSites[i];
-    }
-    for (std::size_t i = 0; i < rspsize; ++i)
-    {
-        data >> ResearchSiteProgress[i];
-    }
-    for (std::size_t i = 0; i < dqcsize; ++i)
-    {
-        data >> DailyQuestsCompleted[i];
-    }
-    for (std::size_t i = 0; i < aqlxqsize; ++i)
-    {
-        data >> AvailableQuestLineXQuestIDs[i];
-    }
-    for (std::size_t i = 0; i < Unk254size; ++i)
-    {
-        data >> Unk254[i];
-    }
-    for (std::size_t i = 0; i < hsize; ++i)
-    {
-        data >> Heirlooms[i];
-    }
-    for (std::size_t i = 0; i < hfsize; ++i)
-    {
-        data >> HeirloomFlags[i];
+        ++cursor.Stage;
+        cursor.Index = 0;
     }
-    for (std::size_t i = 0; i < tsize; ++i)
-    {
-        data >> Toys[i];
-    }
-    for (std::size_t i = 0; i < tmsize; ++i)
-    {
-        data >> Transmog[i];
-    }
-    for (std::size_t i = 0; i < ctmsize; ++i)
-    {
-        data >> ConditionalTransmog[i];
-    }
-    for (std::size_t i = 0; i < srssize; ++i)
-    {
-        data >> SelfResSpells[i];
-    }
-    for (std::size_t i = 0; i < spmlsize; ++i)
-    {
-        SpellPctModByLabel[i].ReadCreate(data, fieldVisibilityFlags);
-    }
-    for (std::size_t i = 0; i < sfmlsize; ++i)
-    {
-        SpellFlatModByLabel[i].ReadCreate(data, fieldVisibilityFlags);
-    }
-    for (std::size_t i = 0; i < 7; ++i)
+}
+
+bool ReadActivePlayerCreatePartial(ActivePlayerData& fields, ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags,
+    IStatUpdate& update, ActivePlayerCreateCursor& cursor)
+{
+#ifdef UF_WITH_DECODE_DIFF
+    if (!IsDifferentialDecode())
     {
-        PvpInfo[i].ReadCreate(data, fieldVisibilityFlags);
+        // the reference decode starts from its own copy of the cursor
+        ActivePlayerCreateCursor const start = cursor;
+        bool complete = false;
+        DecodeDifferential(data, fields, update, [&](ByteBuffer& diffData, ActivePlayerData& diffFields, IStatUpdate& diffUpdate)
+        {
+            ActivePlayerCreateCursor referenceCursor = start;
+            bool reference = IsReferenceDecode();
+            bool done = ReadActivePlayerCreatePartial(diffFields, diffData, fieldVisibilityFlags, diffUpdate, reference ? referenceCursor : cursor);
+            if (!reference)
+                complete = done;
+        });
+        return complete;
     }
-    (bool&)InsertItemsLeftToRight = data.ReadBit();
-    data.ResetBits();
-    for (std::size_t i = 0; i < crsize; ++i)
+#endif
+    StructDecodeMark mark(data, UpdateFieldStruct::ActivePlayer);
+    if (!ReadActivePlayerCreateStages(fields, data, fieldVisibilityFlags, update, cursor, true))
     {
-        CharacterRestrictions[i].ReadCreate(data, fieldVisibilityFlags);
+        // the segment decoded so far is traced and profiled, sinks wait for the complete struct
+        mark.Finish(data, nullptr, 0);
+        return false;
     }
 
-    data.rpos(data.rpos() + 49);
+    NotifyDecoded(mark, data, &fields, nullptr, 0);
+    return true;
+}
+
+void ActivePlayerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
+{
+    UF_DECODE_DIFFERENTIAL(update, ReadCreate(diffData, fieldVisibilityFlags, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::ActivePlayer);
+    ActivePlayerCreateCursor cursor;
+    ReadActivePlayerCreateStages(*this, data, fieldVisibilityFlags, update, cursor, false);
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void ActivePlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
 {
-    uint32 m[2] = { data.read<uint32>(), data.ReadBits(16) };//changed 3.4.2 guess
-    UpdateMask<48> msk(m, sizeof(m)/sizeof(uint32));
+    UF_DECODE_DIFFERENTIAL(update, ReadUpdate(diffData, diffUpdate));
+    StructDecodeMark mark(data, UpdateFieldStruct::ActivePlayer);
+    uint32 m[2];
+    m[0] = data.read<uint32>();
+    BitReader bits(data);
+    m[1] = bits.ReadBits(16);//changed 3.4.2 guess
     uint32 v[48];
-    memset(v, 0, sizeof(v));
-    for (std::size_t i = 0; i < 48; ++i)
-        if (msk[i])
-            v[i] = data.ReadBits(32);
+    bits.ReadMaskBlocks(48, m, v);
+    bits.Sync();
     UpdateMask<32 * 48> changesMask(v, sizeof(v)/sizeof(uint32));
 
     if (changesMask[0])
@@ -2512,7 +2711,7 @@ void ActivePlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         }
         if (changesMask[25])
         {
-            uint32 old = Coinage;
+            uint64 old = Coinage;
             data >> Coinage._value;
             update.OnActivePlayerCoinage(old, Coinage);
         }
@@ -2901,8 +3100,8 @@ void ActivePlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         {
             if (changesMask[117 + i])
             {
-                uint32 old = InvSlots[i]._low;
-                data >> InvSlots[i];
+                uint64 old = InvSlots[i]._low;
+                PackedGuid::Read(data, InvSlots[i]);
                 update.OnActivePlayerInvSlot(old, InvSlots[i]._low, i);
             }
         }
@@ -3056,9 +3255,10 @@ void ActivePlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         {
             if (changesMask[629 + i])
             {
+                uint64 old = QuestCompleted[i];
                 data >> QuestCompleted[i];
-                if (QuestCompleted[i])
-                    update.OnActivePlayerQuestCompleted(0, QuestCompleted[i], i);
+                if (QuestCompleted[i] & ~old)
+                    update.OnActivePlayerQuestCompleted(old, QuestCompleted[i], i);
             }
         }
     }
@@ -3073,20 +3273,25 @@ void ActivePlayerData::ReadUpdate(ByteBuffer& data, IStatUpdate& update)
         }
     }
     data.ResetBits();
+    NotifyDecoded(mark, data, this, v, 48);
 }
 
 void GameObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::GameObject);
     data >> DisplayID._value;
     data >> SpellVisualID._value;
     data >> StateSpellVisualID._value;
     data >> SpawnTrackingStateAnimID._value;
     data >> SpawnTrackingStateAnimKitID._value;
     uint32 swesize = data.read<uint32>();
+    mark.CheckSize(data, swesize, 4);
     for (std::size_t i = 0; i < swesize; ++i)
     {
         data >> EnsureCapasity(StateWorldEffectIDs._value, i);
     }
+    StateWorldEffectIDs._value.resize(swesize);
     data >> CreatedBy._value;
     data >> GuildGUID._value;
     data >> Flags._value;
@@ -3103,6 +3308,8 @@ void GameObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fiel
     uint32 edssize = data.read<uint32>();
     data >> CustomParam._value;
     uint32 wesize = data.read<uint32>();
+    mark.CheckSize(data, edssize, 4);
+    mark.CheckSize(data, wesize, 4);
     for (std::size_t i = 0; i < edssize; ++i)
     {
         data >> EnableDoodadSets[i];
@@ -3111,21 +3318,27 @@ void GameObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fiel
     {
         data >> WorldEffects[i];
     }
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void GameObjectData::ReadUpdate(ByteBuffer& data)
 {
-    UpdateMask<20> changesMask(data.ReadBits(20));
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::GameObject);
+    uint32 mask = data.ReadBits(20);
+    UpdateMask<20> changesMask(mask);
 
     if (changesMask[0])
     {
         if (changesMask[1])
         {
             uint32 size = data.ReadBits(32);
+            mark.CheckSize(data, size, 4);
             for (std::size_t i = 0; i < size; ++i)
             {
                 data >> EnsureCapasity(StateWorldEffectIDs._value, i);
             }
+            StateWorldEffectIDs._value.resize(size);
         }
     }
     data.ResetBits();
@@ -3231,21 +3444,28 @@ void GameObjectData::ReadUpdate(ByteBuffer& data)
             data >> CustomParam._value;
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void DynamicObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::DynamicObject);
     data >> Caster._value;
     data >> Type._value;
     data >> SpellXSpellVisualID._value;
     data >> SpellID._value;
     data >> Radius._value;
     data >> CastTime._value;
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void DynamicObjectData::ReadUpdate(ByteBuffer& data)
 {
-    UpdateMask<7> changesMask(data.ReadBits(7));
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::DynamicObject);
+    uint32 mask = data.ReadBits(7);
+    UpdateMask<7> changesMask(mask);
 
     data.ResetBits();
     if (changesMask[0])
@@ -3275,10 +3495,13 @@ void DynamicObjectData::ReadUpdate(ByteBuffer& data)
             data >> CastTime._value;
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void CorpseData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::Corpse);
     data >> DynamicFlags._value;
     data >> Owner._value;
     data >> PartyGUID._value;
@@ -3298,13 +3521,22 @@ void CorpseData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVis
     {
         Customizations[i].ReadCreate(data, fieldVisibilityFlags);
     }
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void CorpseData::ReadUpdate(ByteBuffer& data)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::Corpse);
     if (!data.ReadBit())
+    {
+        // nothing changed, still an update of the corpse
+        uint32 none = 0;
+        NotifyDecoded(mark, data, this, &none, 1);
         return;
-    UpdateMask<32> changesMask(data.ReadBits(32));
+    }
+    uint32 mask = data.ReadBits(32);
+    UpdateMask<32> changesMask(mask);
     if (changesMask[0])
     {
         if (changesMask[1])
@@ -3376,6 +3608,7 @@ void CorpseData::ReadUpdate(ByteBuffer& data)
             }
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void ScaleCurve::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
@@ -3463,6 +3696,8 @@ void VisualAnim::ReadUpdate(ByteBuffer& data)
 
 void AreaTriggerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::AreaTrigger);
     OverrideScaleCurve._value.ReadCreate(data, fieldVisibilityFlags);
     data >> Caster._value;
     data >> Duration._value;
@@ -3478,11 +3713,15 @@ void AreaTriggerData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fie
     data >> Field_80._value;
     ExtraScaleCurve._value.ReadCreate(data, fieldVisibilityFlags);
     VisualAnim._value.ReadCreate(data, fieldVisibilityFlags);
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void AreaTriggerData::ReadUpdate(ByteBuffer& data)
 {
-    UpdateMask<16> changesMask(data.ReadBits(16));
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::AreaTrigger);
+    uint32 mask = data.ReadBits(16);
+    UpdateMask<16> changesMask(mask);
     data.ResetBits();
     if (changesMask[0])
     {
@@ -3547,19 +3786,26 @@ void AreaTriggerData::ReadUpdate(ByteBuffer& data)
             VisualAnim._value.ReadUpdate(data);
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void SceneObjectData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::SceneObject);
     data >> ScriptPackageID._value;
     data >> RndSeedVal._value;
     data >> CreatedBy._value;
     data >> SceneType._value;
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 void SceneObjectData::ReadUpdate(ByteBuffer& data)
 {
-    UpdateMask<5> changesMask(data.ReadBits(5));
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::SceneObject);
+    uint32 mask = data.ReadBits(5);
+    UpdateMask<5> changesMask(mask);
     data.ResetBits();
     if (changesMask[0])
     {
@@ -3580,6 +3826,7 @@ void SceneObjectData::ReadUpdate(ByteBuffer& data)
             data >> SceneType._value;
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 void ConversationLine::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
@@ -3622,24 +3869,31 @@ void ConversationActor::ReadUpdate(ByteBuffer& data)
 
 void ConversationData::ReadCreate(ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
 {
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadCreate(diffData, fieldVisibilityFlags));
+    StructDecodeMark mark(data, UpdateFieldStruct::Conversation);
     uint32 size = data.read<uint32>();
     data >> LastLineEndTime._value;
     for (std::size_t i = 0; i < size; ++i)
     {
         EnsureCapasity(Lines._value, i).ReadCreate(data, fieldVisibilityFlags);
     }
+    Lines._value.resize(size);
     data >> Progress._value;
     data >> size;
     for (std::size_t i = 0; i < size; ++i)
     {
         Actors[i].ReadCreate(data, fieldVisibilityFlags);
     }
+    NotifyDecoded(mark, data, this, nullptr, 0);
 }
 
 
 void ConversationData::ReadUpdate(ByteBuffer& data)
 {
-    UpdateMask<5> changesMask(data.ReadBits(5));
+    UF_DECODE_DIFFERENTIAL(NoStatUpdate(), ReadUpdate(diffData));
+    StructDecodeMark mark(data, UpdateFieldStruct::Conversation);
+    uint32 mask = data.ReadBits(5);
+    UpdateMask<5> changesMask(mask);
 
     if (changesMask[0])
     {
@@ -3650,6 +3904,7 @@ void ConversationData::ReadUpdate(ByteBuffer& data)
             {
                 EnsureCapasity(Lines._value, i).ReadUpdate(data);
             }
+            Lines._value.resize(size);
         }
     }
     data.ResetBits();
@@ -3682,6 +3937,7 @@ void ConversationData::ReadUpdate(ByteBuffer& data)
             data >> Progress._value;
         }
     }
+    NotifyDecoded(mark, data, this, &mask, 1);
 }
 
 }
@@ -0,0 +1,113 @@
+#ifndef _UPDATEFIELDSSTREAM_H
+#define _UPDATEFIELDSSTREAM_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "UpdateFields.h"
+
+namespace UF
+{
+
+enum ActivePlayerCreateStage : uint32
+{
+    ACTIVE_PLAYER_CREATE_INV_SLOTS = 0,
+    ACTIVE_PLAYER_CREATE_HEADER,
+    ACTIVE_PLAYER_CREATE_SKILL,
+    ACTIVE_PLAYER_CREATE_STATS,
+    ACTIVE_PLAYER_CREATE_EXPLORED_ZONES,
+    ACTIVE_PLAYER_CREATE_MISC,
+    ACTIVE_PLAYER_CREATE_QUEST_COMPLETED,
+    ACTIVE_PLAYER_CREATE_DYNAMIC_HEADER,
+    ACTIVE_PLAYER_CREATE_DYNAMIC_VALUES,
+    ACTIVE_PLAYER_CREATE_TRAILER,
+    ACTIVE_PLAYER_CREATE_DONE
+};
+
+enum ActivePlayerCreateSize : uint32
+{
+    ACTIVE_PLAYER_SIZE_KNOWN_TITLES = 0,
+    ACTIVE_PLAYER_SIZE_RESEARCH_SITES,
+    ACTIVE_PLAYER_SIZE_RESEARCH_SITE_PROGRESS,
+    ACTIVE_PLAYER_SIZE_DAILY_QUESTS_COMPLETED,
+    ACTIVE_PLAYER_SIZE_AVAILABLE_QUEST_LINE_X_QUEST_IDS,
+    ACTIVE_PLAYER_SIZE_UNK254,
+    ACTIVE_PLAYER_SIZE_HEIRLOOMS,
+    ACTIVE_PLAYER_SIZE_HEIRLOOM_FLAGS,
+    ACTIVE_PLAYER_SIZE_TOYS,
+    ACTIVE_PLAYER_SIZE_TRANSMOG,
+    ACTIVE_PLAYER_SIZE_CONDITIONAL_TRANSMOG,
+    ACTIVE_PLAYER_SIZE_SELF_RES_SPELLS,
+    ACTIVE_PLAYER_SIZE_SPELL_PCT_MOD_BY_LABEL,
+    ACTIVE_PLAYER_SIZE_SPELL_FLAT_MOD_BY_LABEL,
+    ACTIVE_PLAYER_SIZE_CHARACTER_RESTRICTIONS,
+    MAX_ACTIVE_PLAYER_CREATE_SIZES
+};
+
+/// Position of a partially decoded ActivePlayerData create block within its field schema.
+struct ActivePlayerCreateCursor
+{
+    ActivePlayerCreateCursor() { Reset(); }
+
+    void Reset()
+    {
+        Stage = ACTIVE_PLAYER_CREATE_INV_SLOTS;
+        Array = 0;
+        Index = 0;
+        for (uint32& size : Sizes)
+            size = 0;
+    }
+
+    bool IsComplete() const { return Stage == ACTIVE_PLAYER_CREATE_DONE; }
+
+    uint32 Stage;
+    uint32 Array;       // dynamic array being read in ACTIVE_PLAYER_CREATE_DYNAMIC_VALUES
+    uint32 Index;       // next element of the current stage
+    uint32 Sizes[MAX_ACTIVE_PLAYER_CREATE_SIZES];
+};
+
+/// Decodes as much of an ActivePlayerData create block as 'data' holds, starting at 'cursor'.
+/// A field that is not fully received is rolled back and rpos is left at its start, so the call can be
+/// repeated once more bytes were appended. Returns true when the block is complete.
+/// Each call is traced and profiled as a decode of the bytes it consumed; sinks are notified once, on completion.
+bool ReadActivePlayerCreatePartial(ActivePlayerData& fields, ByteBuffer& data, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags,
+    IStatUpdate& update, ActivePlayerCreateCursor& cursor);
+
+/// Feeds network segments of an active player create block into the decoder as they arrive,
+/// overlapping the decode of the large fixed arrays with the receive of the rest of the packet.
+class ActivePlayerCreateStream
+{
+public:
+    ActivePlayerCreateStream(ActivePlayerData& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
+        : _fields(fields), _flags(fieldVisibilityFlags), _update(update) { }
+
+    /// Appends received bytes and decodes what became available. Returns true once the block is complete.
+    bool Feed(uint8 const* bytes, std::size_t size)
+    {
+        _buffer.append(bytes, size);
+        return Continue();
+    }
+
+    bool Continue()
+    {
+        if (_cursor.IsComplete())
+            return true;
+        return ReadActivePlayerCreatePartial(_fields, _buffer, _flags, _update, _cursor);
+    }
+
+    bool IsComplete() const { return _cursor.IsComplete(); }
+    ActivePlayerCreateCursor const& GetCursor() const { return _cursor; }
+
+    /// Bytes received but not consumed yet; after completion this is the data following the block.
+    std::size_t GetPendingSize() const { return _buffer.size() - _buffer.rpos(); }
+
+private:
+    ActivePlayerData& _fields;
+    EnumFlag<UpdateFieldFlag> _flags;
+    IStatUpdate& _update;
+    ByteBuffer _buffer;
+    ActivePlayerCreateCursor _cursor;
+};
+
+}
+
+#endif
@@ -0,0 +1,2283 @@
+#include "UpdateFieldsWriter.h"
+
+namespace UF
+{
+
+static UpdateMaskGroup const ObjectDataGroups[] = { { 0, 1, 3 } };
+static UpdateMaskGroup const ItemDataGroups[] = { { 0, 1, 21 }, { 22, 23, 27 }, { 28, 29, 41 } };
+static UpdateMaskGroup const ContainerDataGroups[] = { { 0, 1, 1 }, { 2, 3, 38 } };
+static UpdateMaskGroup const UnitDataGroups[] =
+{
+    { 0, 1, 31 }, { 32, 33, 63 }, { 64, 65, 95 }, { 96, 97, 110 }, { 111, 112, 113 }, { 114, 115, 164 },
+    { 165, 166, 168 }, { 169, 170, 171 }, { 172, 173, 187 }, { 188, 189, 209 }, { 210, 211, 224 }
+};
+// bit 3 of PlayerData is rejected by the decoder
+static UpdateMaskGroup const PlayerDataGroups[] =
+{
+    { 0, 1, 2 }, { 0, 4, 29 }, { 30, 31, 55 }, { 56, 57, 75 }, { 76, 77, 82 }, { 83, 84, 102 }
+};
+static UpdateMaskGroup const ActivePlayerDataGroups[] =
+{
+    { 0, 1, 16 }, { 17, 18, 18 }, { 0, 19, 33 }, { 34, 35, 65 }, { 66, 67, 97 }, { 98, 99, 115 }, { 116, 117, 257 },
+    { 246, 247, 248 }, { 261, 262, 289 }, { 290, 291, 530 }, { 531, 532, 533 }, { 534, 535, 540 }, { 541, 542, 565 },
+    { 566, 567, 598 }, { 599, 600, 606 }, { 607, 608, 611 }, { 612, 613, 614 }, { 615, 616, 619 }, { 620, 621, 627 },
+    { 628, 629, 1503 }, { 1504, 1505, 1510 }
+};
+static UpdateMaskGroup const GameObjectDataGroups[] = { { 0, 1, 19 } };
+static UpdateMaskGroup const DynamicObjectDataGroups[] = { { 0, 1, 6 } };
+static UpdateMaskGroup const CorpseDataGroups[] = { { 0, 1, 11 }, { 12, 13, 31 } };
+static UpdateMaskGroup const AreaTriggerDataGroups[] = { { 0, 1, 15 } };
+static UpdateMaskGroup const SceneObjectDataGroups[] = { { 0, 1, 4 } };
+static UpdateMaskGroup const ConversationDataGroups[] = { { 0, 1, 4 } };
+
+#define UPDATE_MASK_LAYOUT(words, groups) { words, groups, uint32(sizeof(groups) / sizeof(groups[0])) }
+
+UpdateMaskLayout const& GetUpdateMaskLayout(UpdateFieldStruct type)
+{
+    static UpdateMaskLayout const Empty = { 0, nullptr, 0 };
+    static UpdateMaskLayout const Layouts[] =
+    {
+        UPDATE_MASK_LAYOUT(1, ObjectDataGroups),
+        UPDATE_MASK_LAYOUT(2, ItemDataGroups),
+        UPDATE_MASK_LAYOUT(2, ContainerDataGroups),
+        UPDATE_MASK_LAYOUT(8, UnitDataGroups),
+        UPDATE_MASK_LAYOUT(4, PlayerDataGroups),
+        UPDATE_MASK_LAYOUT(48, ActivePlayerDataGroups),
+        UPDATE_MASK_LAYOUT(1, GameObjectDataGroups),
+        UPDATE_MASK_LAYOUT(1, DynamicObjectDataGroups),
+        UPDATE_MASK_LAYOUT(1, CorpseDataGroups),
+        UPDATE_MASK_LAYOUT(1, AreaTriggerDataGroups),
+        UPDATE_MASK_LAYOUT(1, SceneObjectDataGroups),
+        UPDATE_MASK_LAYOUT(1, ConversationDataGroups)
+    };
+
+    if (uint32(type) < sizeof(Layouts) / sizeof(Layouts[0]))
+        return Layouts[uint32(type)];
+    return Empty;
+}
+
+#undef UPDATE_MASK_LAYOUT
+
+/// Copies the encodable bits of 'mask' and sets the parent bit of every group with a changed child.
+static void ClampMask(UpdateFieldStruct type, uint32 const* mask, uint32* clamped)
+{
+    UpdateMaskLayout const& layout = GetUpdateMaskLayout(type);
+    for (uint32 i = 0; i < layout.Words; ++i)
+        clamped[i] = 0;
+
+    for (uint32 g = 0; g < layout.GroupCount; ++g)
+    {
+        UpdateMaskGroup const& group = layout.Groups[g];
+        for (uint32 bit = group.First; bit <= group.Last; ++bit)
+        {
+            if (mask[bit / 32] & (1u << (bit % 32)))
+            {
+                clamped[bit / 32] |= 1u << (bit % 32);
+                clamped[group.Parent / 32] |= 1u << (group.Parent % 32);
+            }
+        }
+    }
+}
+
+/// Mirror of BitReader::ReadMaskBlocks: presence bit per block, then the non empty blocks.
+static void WriteMaskBlocks(ByteBuffer& data, uint32 count, uint32 const* blocks)
+{
+    uint32 presence = 0;
+    for (uint32 i = 0; i < count; ++i)
+        if (blocks[i])
+            presence |= 1u << i;
+
+    data.WriteBits(presence, count);
+    for (uint32 i = 0; i < count; ++i)
+        if (blocks[i])
+            data.WriteBits(blocks[i], 32);
+}
+
+/// Mirror of the mask headers of more than 32 blocks: the first 32 presence bits are a plain uint32,
+/// the others are bit packed in front of the non empty blocks.
+static void WriteWideMaskBlocks(ByteBuffer& data, uint32 count, uint32 const* blocks)
+{
+    uint32 presence[2] = { 0, 0 };
+    for (uint32 i = 0; i < count; ++i)
+        if (blocks[i])
+            presence[i / 32] |= 1u << (i % 32);
+
+    data << presence[0];
+    data.WriteBits(presence[1], count - 32);
+    for (uint32 i = 0; i < count; ++i)
+        if (blocks[i])
+            data.WriteBits(blocks[i], 32);
+}
+
+/// Mirror of DynamicUpdateField::ReadUpdateMask for 'size' elements, all of them changed.
+static void WriteUpdateMask(ByteBuffer& data, std::size_t size, int32 bitsForSize = 32)
+{
+    data.WriteBits(size, bitsForSize);
+    if (size > 32)
+    {
+        if (data.HasUnfinishedBitPack())
+            for (std::size_t block = 0; block < size / 32; ++block)
+                data.WriteBits(0xFFFFFFFF, 32);
+        else
+            for (std::size_t block = 0; block < size / 32; ++block)
+                data << uint32(0xFFFFFFFF);
+    }
+    else if (size == 32)
+    {
+        data.WriteBits(0xFFFFFFFF, 32);
+        return;
+    }
+
+    if (size % 32)
+        data.WriteBits((1u << (size % 32)) - 1, int32(size % 32));
+}
+
+static void WriteCreate(ByteBuffer& data, ItemEnchantment const& fields)
+{
+    data << fields.ID._value;
+    data << fields.Duration._value;
+    data << fields.Charges._value;
+    data << fields.Unk254._value;
+    data << fields.Unk254_2._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, ItemEnchantment const& fields)
+{
+    // ItemEnchantment::ReadUpdate reads a 5 bit mask, Unk254_2 (bit 5) can't be sent
+    data.WriteBits(0x1F, 5);
+    data.FlushBits();
+    data << fields.ID._value;
+    data << fields.Duration._value;
+    data << fields.Charges._value;
+    data << fields.Unk254._value;
+}
+
+static void WriteCreate(ByteBuffer& data, VisibleItem const& fields)
+{
+    data << fields.ItemID._value;
+    data << fields.ItemAppearanceModID._value;
+    data << fields.ItemVisual._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, VisibleItem const& fields)
+{
+    data.WriteBits(0xF, 4);
+    data.FlushBits();
+    WriteCreate(data, fields);
+}
+
+static void WriteCreate(ByteBuffer& data, QuestLog const& fields)
+{
+    data << fields.QuestID._value;
+    data << fields.StateFlags._value;
+    data << fields.EndTime._value;
+    data << fields.AcceptTime._value;
+    for (std::size_t i = 0; i < 24; ++i)
+        data << fields.ObjectiveProgress[i];
+}
+
+static void WriteUpdate(ByteBuffer& data, QuestLog const& fields)
+{
+    data.WriteBit(1);
+    data.WriteBits(0x3FFFFFFF, 32);
+    data.FlushBits();
+    data << fields.QuestID._value;
+    data << fields.StateFlags._value;
+    data << fields.EndTime._value;
+    data << fields.AcceptTime._value;
+    for (std::size_t i = 0; i < 24; ++i)
+        data << fields.ObjectiveProgress[i];
+}
+
+static void WriteUpdate(ByteBuffer& data, ItemModList const& fields)
+{
+    data.WriteBits(1, 1);
+    WriteUpdateMask(data, fields.Values.size(), 6);
+    data.FlushBits();
+    for (std::size_t i = 0; i < fields.Values.size(); ++i)
+    {
+        data << fields.Values[i].Value;
+        data << fields.Values[i].Type;
+    }
+}
+
+static void WriteCreate(ByteBuffer& data, SocketedGem const& fields)
+{
+    data << fields.ItemID._value;
+    for (std::size_t i = 0; i < 16; ++i)
+        data << fields.BonusListIDs[i];
+    data << fields.Context._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, SocketedGem const& fields)
+{
+    data.WriteBit(1);
+    data.WriteBits(0xFFFFF, 32);
+    data.FlushBits();
+    data << fields.ItemID._value;
+    data << fields.Context._value;
+    for (std::size_t i = 0; i < 16; ++i)
+        data << fields.BonusListIDs[i];
+}
+
+static void WriteCreate(ByteBuffer& data, ArenaCooldown const& fields)
+{
+    data << fields.SpellID._value;
+    data << fields.Charges._value;
+    data << fields.Unk254._value;
+    data << fields.Flags._value;
+    data << fields.StartTime._value;
+    data << fields.EndTime._value;
+    data << fields.NextChargeTime._value;
+    data << fields.MaxCharges._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, ArenaCooldown const& fields)
+{
+    data.WriteBits(0x1FF, 9);
+    data.FlushBits();
+    WriteCreate(data, fields);
+}
+
+static void WriteCreate(ByteBuffer& data, SkillInfo const& fields)
+{
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        data << fields.SkillLineID[i];
+        data << fields.SkillStep[i];
+        data << fields.SkillRank[i];
+        data << fields.SkillStartingRank[i];
+        data << fields.SkillMaxRank[i];
+        data << fields.SkillTempBonus[i];
+        data << fields.SkillPermBonus[i];
+    }
+}
+
+static void WriteUpdate(ByteBuffer& data, SkillInfo const& fields)
+{
+    // all 1793 bits set, the last block only holds bit 1792
+    uint32 blocks[57];
+    for (std::size_t i = 0; i < 56; ++i)
+        blocks[i] = 0xFFFFFFFF;
+    blocks[56] = 1;
+    WriteWideMaskBlocks(data, 57, blocks);
+    data.FlushBits();
+    WriteCreate(data, fields);
+}
+
+static void WriteCreate(ByteBuffer& data, RestInfo const& fields)
+{
+    data << fields.Threshold._value;
+    data << fields.StateID._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, RestInfo const& fields)
+{
+    data.WriteBits(0x7, 3);
+    data.FlushBits();
+    WriteCreate(data, fields);
+}
+
+static void WritePVPInfoValues(ByteBuffer& data, PVPInfo const& fields)
+{
+    data << fields.Bracket._value;
+    data << fields.PvpRatingID._value;
+    data << fields.WeeklyPlayed._value;
+    data << fields.WeeklyWon._value;
+    data << fields.SeasonPlayed._value;
+    data << fields.SeasonWon._value;
+    data << fields.Rating._value;
+    data << fields.WeeklyBestRating._value;
+    data << fields.SeasonBestRating._value;
+    data << fields.PvpTierID._value;
+    data << fields.WeeklyBestWinPvpTierID._value;
+    data << fields.Field_28._value;
+    data << fields.Field_2C._value;
+    data << fields.WeeklyRoundsPlayed._value;
+    data << fields.WeeklyRoundsWon._value;
+    data << fields.SeasonRoundsPlayed._value;
+    data << fields.SeasonRoundsWon._value;
+}
+
+static void WriteCreate(ByteBuffer& data, PVPInfo const& fields)
+{
+    WritePVPInfoValues(data, fields);
+    data.WriteBit(fields.Disqualified._value);
+    data.FlushBits();
+}
+
+static void WriteUpdate(ByteBuffer& data, PVPInfo const& fields)
+{
+    data.WriteBits(0x7FFFF, 19);
+    data.WriteBit(fields.Disqualified._value);
+    data.FlushBits();
+    WritePVPInfoValues(data, fields);
+}
+
+static void WriteCreate(ByteBuffer& data, CharacterRestriction const& fields)
+{
+    // ReadCreate and ReadUpdate share the layout
+    data << fields.Field_0;
+    data << fields.Field_4;
+    data << fields.Field_8;
+    data.WriteBits(fields.Type, 5);
+    data.FlushBits();
+}
+
+static void WriteCreate(ByteBuffer& data, SpellPctModByLabel const& fields)
+{
+    data << fields.ModIndex;
+    data << fields.ModifierValue;
+    data << fields.LabelID;
+}
+
+static void WriteCreate(ByteBuffer& data, SpellFlatModByLabel const& fields)
+{
+    data << fields.ModIndex;
+    data << fields.ModifierValue;
+    data << fields.LabelID;
+}
+
+static void WriteCreate(ByteBuffer& data, GlyphInfo const& fields)
+{
+    data << fields.GlyphSlot._value;
+    data << fields.Glyph._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, GlyphInfo const& fields)
+{
+    data.WriteBits(0x7, 3);
+    data.FlushBits();
+    WriteCreate(data, fields);
+}
+
+static void WriteCreate(ByteBuffer& data, ScaleCurve const& fields)
+{
+    data << fields.StartTimeOffset._value;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        data << fields.Points[i].Pos.m_positionX;
+        data << fields.Points[i].Pos.m_positionY;
+    }
+    data << fields.ParameterCurve._value;
+    data.WriteBit(fields.OverrideActive._value);
+    data.FlushBits();
+}
+
+static void WriteUpdate(ByteBuffer& data, ScaleCurve const& fields)
+{
+    data.WriteBits(0x7F, 7);
+    data.WriteBit(fields.OverrideActive._value);
+    data.FlushBits();
+    data << fields.StartTimeOffset._value;
+    data << fields.ParameterCurve._value;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        data << fields.Points[i].Pos.m_positionX;
+        data << fields.Points[i].Pos.m_positionY;
+    }
+}
+
+static void WriteCreate(ByteBuffer& data, VisualAnim const& fields)
+{
+    data << fields.AnimationDataID._value;
+    data << fields.AnimKitID._value;
+    data << fields.AnimProgress._value;
+    data << fields.Field_C._value;
+}
+
+static void WriteUpdate(ByteBuffer& data, VisualAnim const& fields)
+{
+    // Field_C is a plain byte read right after the mask, dropping the rest of the mask byte
+    data.WriteBits(0x1F, 5);
+    data << fields.Field_C._value;
+    data << fields.AnimationDataID._value;
+    data << fields.AnimKitID._value;
+    data << fields.AnimProgress._value;
+}
+
+static void WriteCreate(ByteBuffer& data, ConversationLine const& fields)
+{
+    data << fields.ConversationLineID;
+    data << fields.StartTime;
+    data << fields.UiCameraID;
+    data << fields.ActorIndex;
+    data << fields.Flags;
+}
+
+static void WriteCreate(ByteBuffer& data, ConversationActor const& fields)
+{
+    // ReadCreate and ReadUpdate share the layout
+    data.WriteBit(fields.Type != 0);
+    data.WriteBit(0);
+    data << fields.Id;
+    data << fields.ActorGUID;
+    data << fields.CreatureID;
+    data << fields.CreatureDisplayInfoID;
+}
+
+void WriteCreate(ByteBuffer& data, ObjectData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << fields.EntryID._value;
+    data << fields.DynamicFlags._value;
+    data << fields.Scale._value;
+}
+
+void WriteUpdate(ByteBuffer& data, ObjectData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::Object, mask, m);
+    UpdateMask<4> changesMask(m[0]);
+    data.WriteBits(m[0], 4);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            data << fields.EntryID._value;
+        if (changesMask[2])
+            data << fields.DynamicFlags._value;
+        if (changesMask[3])
+            data << fields.Scale._value;
+    }
+}
+
+void WriteCreate(ByteBuffer& data, ItemData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
+{
+    data << fields.Owner._value;
+    data << fields.ContainedIn._value;
+    data << fields.Creator._value;
+    data << fields.GiftCreator._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        data << fields.StackCount._value;
+        data << fields.Expiration._value;
+        for (std::size_t i = 0; i < 5; ++i)
+            data << fields.SpellCharges[i];
+    }
+    data << fields.DynamicFlags._value;
+    for (std::size_t i = 0; i < 13; ++i)
+        WriteCreate(data, fields.Enchantment[i]);
+    data << fields.PropertySeed._value;
+    data << fields.RandomPropertiesID._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        data << fields.Durability._value;
+        data << fields.MaxDurability._value;
+    }
+    data << fields.CreatePlayedTime._value;
+    data << fields.Context._value;
+    data << fields.CreateTime._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        data << fields.ArtifactXP._value;
+        data << fields.ItemAppearanceModID._value;
+    }
+    data << uint32(fields.ArtifactPowers.size());
+    data << uint32(fields.Gems.size());
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        data << fields.DynamicFlags2._value;
+        data << fields.DEBUGItemLevel._value;
+    }
+    for (std::size_t i = 0; i < fields.ArtifactPowers.size(); ++i)
+    {
+        data << fields.ArtifactPowers[i].ArtifactPowerID;
+        data << fields.ArtifactPowers[i].PurchasedRank;
+        data << fields.ArtifactPowers[i].CurrentRankWithBonus;
+    }
+    for (std::size_t i = 0; i < fields.Gems.size(); ++i)
+        WriteCreate(data, fields.Gems[i]);
+    data << uint32(0);                                          // ItemBonusKey::ItemID, not kept by the decoder
+    data << uint32(fields.BonusListIDs._value.size());
+    for (uint32 bonusListId : fields.BonusListIDs._value)
+        data << bonusListId;
+    data.WriteBits(fields.Modifiers._value.Values.size(), 6);
+    data.FlushBits();
+    for (std::size_t i = 0; i < fields.Modifiers._value.Values.size(); ++i)
+    {
+        data << fields.Modifiers._value.Values[i].Value;
+        data << fields.Modifiers._value.Values[i].Type;
+    }
+}
+
+void WriteUpdate(ByteBuffer& data, ItemData const& fields, uint32 const* mask)
+{
+    uint32 m[2];
+    ClampMask(UpdateFieldStruct::Item, mask, m);
+    UpdateMask<64> changesMask(m, 2);
+    WriteMaskBlocks(data, 2, m);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            WriteUpdateMask(data, fields.ArtifactPowers.size());
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.Gems.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            for (std::size_t i = 0; i < fields.ArtifactPowers.size(); ++i)
+            {
+                data << fields.ArtifactPowers[i].ArtifactPowerID;
+                data << fields.ArtifactPowers[i].PurchasedRank;
+                data << fields.ArtifactPowers[i].CurrentRankWithBonus;
+            }
+        }
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.Gems.size(); ++i)
+                WriteUpdate(data, fields.Gems[i]);
+        }
+        if (changesMask[3])
+            data << fields.Owner._value;
+        if (changesMask[4])
+            data << fields.ContainedIn._value;
+        if (changesMask[5])
+            data << fields.Creator._value;
+        if (changesMask[6])
+            data << fields.GiftCreator._value;
+        if (changesMask[7])
+            data << fields.StackCount._value;
+        if (changesMask[8])
+            data << fields.Expiration._value;
+        if (changesMask[9])
+            data << fields.DynamicFlags._value;
+        if (changesMask[10])
+            data << fields.PropertySeed._value;
+        if (changesMask[11])
+            data << fields.RandomPropertiesID._value;
+        if (changesMask[12])
+            data << fields.Durability._value;
+        if (changesMask[13])
+            data << fields.MaxDurability._value;
+        if (changesMask[14])
+            data << fields.CreatePlayedTime._value;
+        if (changesMask[15])
+            data << fields.Context._value;
+        if (changesMask[16])
+            data << fields.CreateTime._value;
+        if (changesMask[17])
+            data << fields.ArtifactXP._value;
+        if (changesMask[18])
+            data << fields.ItemAppearanceModID._value;
+        if (changesMask[19])
+            WriteUpdate(data, fields.Modifiers._value);
+        if (changesMask[20])
+            data << fields.DynamicFlags2._value;
+        if (changesMask[21])
+            data << fields.DEBUGItemLevel._value;
+    }
+    if (changesMask[22])
+    {
+        for (std::size_t i = 0; i < 5; ++i)
+            if (changesMask[23 + i])
+                data << fields.SpellCharges[i];
+    }
+    if (changesMask[28])
+    {
+        for (std::size_t i = 0; i < 13; ++i)
+            if (changesMask[29 + i])
+                WriteUpdate(data, fields.Enchantment[i]);
+    }
+}
+
+void WriteCreate(ByteBuffer& data, ContainerData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    for (std::size_t i = 0; i < 36; ++i)
+        data << fields.Slots[i];
+    data << fields.NumSlots._value;
+}
+
+void WriteUpdate(ByteBuffer& data, ContainerData const& fields, uint32 const* mask)
+{
+    uint32 m[2];
+    ClampMask(UpdateFieldStruct::Container, mask, m);
+    UpdateMask<64> changesMask(m, 2);
+    WriteMaskBlocks(data, 2, m);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            data << fields.NumSlots._value;
+    }
+    if (changesMask[2])
+    {
+        for (std::size_t i = 0; i < 36; ++i)
+            if (changesMask[3 + i])
+                data << fields.Slots[i];
+    }
+}
+
+void WriteCreate(ByteBuffer& data, UnitData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
+{
+    data << fields.Health._value;
+    data << fields.MaxHealth._value;
+    data << fields.DisplayID._value;
+    for (std::size_t i = 0; i < 2; ++i)
+        data << fields.NpcFlags[i];
+    data << fields.StateSpellVisualID._value;
+    data << fields.StateAnimID._value;
+    data << fields.StateAnimKitID._value;
+    data << uint32(fields.StateWorldEffectIDs._value.size());
+    for (uint32 stateWorldEffectId : fields.StateWorldEffectIDs._value)
+        data << stateWorldEffectId;
+    data << fields.Charm._value;
+    data << fields.Summon._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+        data << fields.Critter._value;
+    data << fields.CharmedBy._value;
+    data << fields.SummonedBy._value;
+    data << fields.CreatedBy._value;
+    data << fields.DemonCreator._value;
+    data << fields.LookAtControllerTarget._value;
+    data << fields.Target._value;
+    data << fields.BattlePetCompanionGUID._value;
+    data << fields.BattlePetDBID._value;
+    data << fields.ChannelData._value.SpellID;
+    data << fields.ChannelData._value.SpellXSpellVisualID;
+    data << fields.SummonedByHomeRealm._value;
+    data << fields.Race._value;
+    data << fields.ClassId._value;
+    data << fields.PlayerClassId._value;
+    data << fields.Sex._value;
+    data << fields.DisplayPower._value;
+    data << fields.OverrideDisplayPowerID._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner | UpdateFieldFlag::UnitAll))
+    {
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+            data << fields.Unk340[i];
+            data << fields.Unk340_2[i];
+        }
+    }
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        data << fields.Power[i];
+        data << fields.MaxPower[i];
+        data << fields.PowerRegenFlatModifier[i];
+    }
+    data << fields.Level._value;
+    data << fields.EffectiveLevel._value;
+    data << fields.ContentTuningID._value;
+    data << fields.ScalingLevelMin._value;
+    data << fields.ScalingLevelMax._value;
+    data << fields.ScalingLevelDelta._value;
+    data << fields.ScalingFactionGroup._value;
+    data << fields.ScalingHealthItemLevelCurveID._value;
+    data << fields.ScalingDamageItemLevelCurveID._value;
+    data << fields.FactionTemplate._value;
+    for (std::size_t i = 0; i < 3; ++i)
+        WriteCreate(data, fields.VirtualItems[i]);
+    data << fields.Flags._value;
+    data << fields.Flags2._value;
+    data << fields.Flags3._value;
+    data << fields.AuraState._value;
+    for (std::size_t i = 0; i < 2; ++i)
+        data << fields.AttackRoundBaseTime[i];
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+        data << fields.RangedAttackRoundBaseTime._value;
+    data << fields.BoundingRadius._value;
+    data << fields.CombatReach._value;
+    data << fields.DisplayScale._value;
+    data << fields.NativeDisplayID._value;
+    data << fields.NativeXDisplayScale._value;
+    data << fields.MountDisplayID._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner | UpdateFieldFlag::Empath))
+    {
+        data << fields.MinDamage._value;
+        data << fields.MaxDamage._value;
+        data << fields.MinOffHandDamage._value;
+        data << fields.MaxOffHandDamage._value;
+    }
+    data << fields.StandState._value;
+    data << fields.PetTalentPoints._value;
+    data << fields.VisFlags._value;
+    data << fields.AnimTier._value;
+    data << fields.PetNumber._value;
+    data << fields.PetNameTimestamp._value;
+    data << fields.PetExperience._value;
+    data << fields.PetNextLevelExperience._value;
+    data << fields.ModCastingSpeed._value;
+    data << fields.ModSpellHaste._value;
+    data << fields.ModHaste._value;
+    data << fields.ModRangedHaste._value;
+    data << fields.ModHasteRegen._value;
+    data << fields.ModTimeRate._value;
+    data << fields.CreatedBySpell._value;
+    data << fields.EmoteState._value;
+    data << fields.TrainingPointsUsed._value;
+    data << fields.TrainingPointsTotal._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            data << fields.Stats[i];
+            data << fields.StatPosBuff[i];
+            data << fields.StatNegBuff[i];
+        }
+    }
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner | UpdateFieldFlag::Empath))
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+            data << fields.Resistances[i];
+    }
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+        {
+            data << fields.PowerCostModifier[i];
+            data << fields.PowerCostMultiplier[i];
+        }
+    }
+    for (std::size_t i = 0; i < 7; ++i)
+    {
+        data << fields.ResistanceBuffModsPositive[i];
+        data << fields.ResistanceBuffModsNegative[i];
+    }
+    data << fields.BaseMana._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+        data << fields.BaseHealth._value;
+    data << fields.SheatheState._value;
+    data << fields.PvpFlags._value;
+    data << fields.PetFlags._value;
+    data << fields.ShapeshiftForm._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+    {
+        data << fields.AttackPower._value;
+        data << fields.AttackPowerModPos._value;
+        data << fields.AttackPowerModNeg._value;
+        data << fields.AttackPowerMultiplier._value;
+        data << fields.RangedAttackPower._value;
+        data << fields.RangedAttackPowerModPos._value;
+        data << fields.RangedAttackPowerModNeg._value;
+        data << fields.RangedAttackPowerMultiplier._value;
+        data << fields.SetAttackSpeedAura._value;
+        data << fields.Lifesteal._value;
+        data << fields.MinRangedDamage._value;
+        data << fields.MaxRangedDamage._value;
+        data << fields.MaxHealthModifier._value;
+    }
+    data << fields.HoverHeight._value;
+    data << fields.MinItemLevelCutoff._value;
+    data << fields.MinItemLevel._value;
+    data << fields.MaxItemLevel._value;
+    data << fields.WildBattlePetLevel._value;
+    data << fields.BattlePetCompanionNameTimestamp._value;
+    data << fields.InteractSpellID._value;
+    data << fields.ScaleDuration._value;
+    data << fields.LooksLikeMountID._value;
+    data << fields.LooksLikeCreatureID._value;
+    data << fields.LookAtControllerID._value;
+    data << uint32(0);
+    data << fields.GuildGUID._value;
+    data << uint32(fields.PassiveSpells.size());
+    data << uint32(fields.WorldEffects.size());
+    data << uint32(fields.ChannelObjects.size());
+    data << fields.SkinningOwnerGUID._value;
+    data << uint32(0);
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::Owner))
+        data << fields.Unk340_3._value;
+    for (std::size_t i = 0; i < fields.PassiveSpells.size(); ++i)
+    {
+        data << fields.PassiveSpells[i].SpellID;
+        data << fields.PassiveSpells[i].AuraSpellID;
+    }
+    for (std::size_t i = 0; i < fields.WorldEffects.size(); ++i)
+        data << fields.WorldEffects[i];
+    for (std::size_t i = 0; i < fields.ChannelObjects.size(); ++i)
+        data << fields.ChannelObjects[i];
+}
+
+void WriteUpdate(ByteBuffer& data, UnitData const& fields, uint32 const* mask)
+{
+    uint32 m[8];
+    ClampMask(UpdateFieldStruct::Unit, mask, m);
+    UpdateMask<32 * 8> changesMask(m, 8);
+    WriteMaskBlocks(data, 8, m);
+
+    // the decoder continues with the size right after the mask blocks
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            data.WriteBits(fields.StateWorldEffectIDs._value.size(), 32);
+            for (uint32 stateWorldEffectId : fields.StateWorldEffectIDs._value)
+                data << stateWorldEffectId;
+        }
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.PassiveSpells.size());
+        if (changesMask[3])
+            WriteUpdateMask(data, fields.WorldEffects.size());
+        if (changesMask[4])
+            WriteUpdateMask(data, fields.ChannelObjects.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.PassiveSpells.size(); ++i)
+            {
+                data << fields.PassiveSpells[i].SpellID;
+                data << fields.PassiveSpells[i].AuraSpellID;
+            }
+        }
+        if (changesMask[3])
+        {
+            for (std::size_t i = 0; i < fields.WorldEffects.size(); ++i)
+                data << fields.WorldEffects[i];
+        }
+        if (changesMask[4])
+        {
+            for (std::size_t i = 0; i < fields.ChannelObjects.size(); ++i)
+                data << fields.ChannelObjects[i];
+        }
+        if (changesMask[5])
+            data << fields.Health._value;
+        if (changesMask[6])
+            data << fields.MaxHealth._value;
+        if (changesMask[7])
+            data << fields.DisplayID._value;
+        if (changesMask[8])
+            data << fields.StateSpellVisualID._value;
+        if (changesMask[9])
+            data << fields.StateAnimID._value;
+        if (changesMask[10])
+            data << fields.StateAnimKitID._value;
+        if (changesMask[11])
+            data << fields.Charm._value;
+        if (changesMask[12])
+            data << fields.Summon._value;
+        if (changesMask[13])
+            data << fields.Critter._value;
+        if (changesMask[14])
+            data << fields.CharmedBy._value;
+        if (changesMask[15])
+            data << fields.SummonedBy._value;
+        if (changesMask[16])
+            data << fields.CreatedBy._value;
+        if (changesMask[17])
+            data << fields.DemonCreator._value;
+        if (changesMask[18])
+            data << fields.LookAtControllerTarget._value;
+        if (changesMask[19])
+            data << fields.Target._value;
+        if (changesMask[20])
+            data << fields.BattlePetCompanionGUID._value;
+        if (changesMask[21])
+            data << fields.BattlePetDBID._value;
+        if (changesMask[22])
+        {
+            data << fields.ChannelData._value.SpellID;
+            data << fields.ChannelData._value.SpellXSpellVisualID;
+        }
+        if (changesMask[23])
+            data << fields.SummonedByHomeRealm._value;
+        if (changesMask[24])
+            data << fields.Race._value;
+        if (changesMask[25])
+            data << fields.ClassId._value;
+        if (changesMask[26])
+            data << fields.PlayerClassId._value;
+        if (changesMask[27])
+            data << fields.Sex._value;
+        if (changesMask[28])
+            data << fields.DisplayPower._value;
+        if (changesMask[29])
+            data << fields.OverrideDisplayPowerID._value;
+        if (changesMask[30])
+            data << fields.Level._value;
+        if (changesMask[31])
+            data << fields.EffectiveLevel._value;
+    }
+    if (changesMask[32])
+    {
+        if (changesMask[33])
+            data << fields.ContentTuningID._value;
+        if (changesMask[34])
+            data << fields.ScalingLevelMin._value;
+        if (changesMask[35])
+            data << fields.ScalingLevelMax._value;
+        if (changesMask[36])
+            data << fields.ScalingLevelDelta._value;
+        if (changesMask[37])
+            data << fields.ScalingFactionGroup._value;
+        if (changesMask[38])
+            data << fields.ScalingHealthItemLevelCurveID._value;
+        if (changesMask[39])
+            data << fields.ScalingDamageItemLevelCurveID._value;
+        if (changesMask[40])
+            data << fields.FactionTemplate._value;
+        if (changesMask[41])
+            data << fields.Flags._value;
+        if (changesMask[42])
+            data << fields.Flags2._value;
+        if (changesMask[43])
+            data << fields.Flags3._value;
+        if (changesMask[44])
+            data << fields.AuraState._value;
+        if (changesMask[45])
+            data << fields.RangedAttackRoundBaseTime._value;
+        if (changesMask[46])
+            data << fields.BoundingRadius._value;
+        if (changesMask[47])
+            data << fields.CombatReach._value;
+        if (changesMask[48])
+            data << fields.DisplayScale._value;
+        if (changesMask[49])
+            data << fields.NativeDisplayID._value;
+        if (changesMask[50])
+            data << fields.NativeXDisplayScale._value;
+        if (changesMask[51])
+            data << fields.MountDisplayID._value;
+        if (changesMask[52])
+            data << fields.MinDamage._value;
+        if (changesMask[53])
+            data << fields.MaxDamage._value;
+        if (changesMask[54])
+            data << fields.MinOffHandDamage._value;
+        if (changesMask[55])
+            data << fields.MaxOffHandDamage._value;
+        if (changesMask[56])
+            data << fields.StandState._value;
+        if (changesMask[57])
+            data << fields.PetTalentPoints._value;
+        if (changesMask[58])
+            data << fields.VisFlags._value;
+        if (changesMask[59])
+            data << fields.AnimTier._value;
+        if (changesMask[60])
+            data << fields.PetNumber._value;
+        if (changesMask[61])
+            data << fields.PetNameTimestamp._value;
+        if (changesMask[62])
+            data << fields.PetExperience._value;
+        if (changesMask[63])
+            data << fields.PetNextLevelExperience._value;
+    }
+    if (changesMask[64])
+    {
+        if (changesMask[65])
+            data << fields.ModCastingSpeed._value;
+        if (changesMask[66])
+            data << fields.ModSpellHaste._value;
+        if (changesMask[67])
+            data << fields.ModHaste._value;
+        if (changesMask[68])
+            data << fields.ModRangedHaste._value;
+        if (changesMask[69])
+            data << fields.ModHasteRegen._value;
+        if (changesMask[70])
+            data << fields.ModTimeRate._value;
+        if (changesMask[71])
+            data << fields.CreatedBySpell._value;
+        if (changesMask[72])
+            data << fields.EmoteState._value;
+        if (changesMask[73])
+            data << fields.TrainingPointsUsed._value;
+        if (changesMask[74])
+            data << fields.TrainingPointsTotal._value;
+        if (changesMask[75])
+            data << fields.BaseMana._value;
+        if (changesMask[76])
+            data << fields.BaseHealth._value;
+        if (changesMask[77])
+            data << fields.SheatheState._value;
+        if (changesMask[78])
+            data << fields.PvpFlags._value;
+        if (changesMask[79])
+            data << fields.PetFlags._value;
+        if (changesMask[80])
+            data << fields.ShapeshiftForm._value;
+        if (changesMask[81])
+            data << fields.AttackPower._value;
+        if (changesMask[82])
+            data << fields.AttackPowerModPos._value;
+        if (changesMask[83])
+            data << fields.AttackPowerModNeg._value;
+        if (changesMask[84])
+            data << fields.AttackPowerMultiplier._value;
+        if (changesMask[85])
+            data << fields.RangedAttackPower._value;
+        if (changesMask[86])
+            data << fields.RangedAttackPowerModPos._value;
+        if (changesMask[87])
+            data << fields.RangedAttackPowerModNeg._value;
+        if (changesMask[88])
+            data << fields.RangedAttackPowerMultiplier._value;
+        if (changesMask[89])
+            data << fields.SetAttackSpeedAura._value;
+        if (changesMask[90])
+            data << fields.Lifesteal._value;
+        if (changesMask[91])
+            data << fields.MinRangedDamage._value;
+        if (changesMask[92])
+            data << fields.MaxRangedDamage._value;
+        if (changesMask[93])
+            data << fields.MaxHealthModifier._value;
+        if (changesMask[94])
+            data << fields.HoverHeight._value;
+        if (changesMask[95])
+            data << fields.MinItemLevelCutoff._value;
+    }
+    if (changesMask[96])
+    {
+        if (changesMask[97])
+            data << fields.MinItemLevel._value;
+        if (changesMask[98])
+            data << fields.MaxItemLevel._value;
+        if (changesMask[99])
+            data << fields.WildBattlePetLevel._value;
+        if (changesMask[100])
+            data << fields.BattlePetCompanionNameTimestamp._value;
+        if (changesMask[101])
+            data << fields.InteractSpellID._value;
+        if (changesMask[102])
+            data << fields.ScaleDuration._value;
+        if (changesMask[103])
+            data << fields.LooksLikeMountID._value;
+        if (changesMask[104])
+            data << fields.LooksLikeCreatureID._value;
+        if (changesMask[105])
+            data << fields.LookAtControllerID._value;
+        if (changesMask[106])
+            data << uint32(0);
+        if (changesMask[107])
+            data << fields.GuildGUID._value;
+        if (changesMask[108])
+            data << fields.SkinningOwnerGUID._value;
+        if (changesMask[109])
+            data << uint32(0);
+        if (changesMask[110])
+            data << fields.Unk340_3._value;
+    }
+    if (changesMask[111])
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+            if (changesMask[112 + i])
+                data << fields.NpcFlags[i];
+    }
+    if (changesMask[114])
+    {
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+            if (changesMask[115 + i])
+                data << fields.Unk340[i];
+            if (changesMask[125 + i])
+                data << fields.Unk340_2[i];
+            if (changesMask[135 + i])
+                data << fields.Power[i];
+            if (changesMask[145 + i])
+                data << fields.MaxPower[i];
+            if (changesMask[155 + i])
+                data << fields.PowerRegenFlatModifier[i];
+        }
+    }
+    if (changesMask[165])
+    {
+        for (std::size_t i = 0; i < 3; ++i)
+            if (changesMask[166 + i])
+                WriteUpdate(data, fields.VirtualItems[i]);
+    }
+    if (changesMask[169])
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+            if (changesMask[170 + i])
+                data << fields.AttackRoundBaseTime[i];
+    }
+    if (changesMask[172])
+    {
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            if (changesMask[173 + i])
+                data << fields.Stats[i];
+            if (changesMask[178 + i])
+                data << fields.StatPosBuff[i];
+            if (changesMask[183 + i])
+                data << fields.StatNegBuff[i];
+        }
+    }
+    if (changesMask[188])
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+        {
+            if (changesMask[189 + i])
+                data << fields.Resistances[i];
+            if (changesMask[196 + i])
+                data << fields.PowerCostModifier[i];
+            if (changesMask[203 + i])
+                data << fields.PowerCostMultiplier[i];
+        }
+    }
+    if (changesMask[210])
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+        {
+            if (changesMask[211 + i])
+                data << fields.ResistanceBuffModsPositive[i];
+            if (changesMask[218 + i])
+                data << fields.ResistanceBuffModsNegative[i];
+        }
+    }
+}
+
+void WriteCreate(ByteBuffer& data, PlayerData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
+{
+    data << fields.DuelArbiter._value;
+    data << fields.WowAccount._value;
+    data << fields.LootTargetGUID._value;
+    data << fields.PlayerFlags._value;
+    data << fields.PlayerFlagsEx._value;
+    data << fields.GuildRankID._value;
+    data << fields.GuildDeleteDate._value;
+    data << fields.GuildLevel._value;
+    data << uint32(fields.Customizations.size());
+    data << fields.PartyType._value;
+    data << fields.NativeSex._value;
+    data << fields.Inebriation._value;
+    data << fields.PvpTitle._value;
+    data << fields.ArenaFaction._value;
+    data << fields.PvpRank._value;
+    data << fields.Unk254._value;
+    data << fields.DuelTeam._value;
+    data << fields.GuildTimeStamp._value;
+    if (fieldVisibilityFlags.HasFlag(UpdateFieldFlag::PartyMember))
+    {
+        for (std::size_t i = 0; i < 25; ++i)
+            WriteCreate(data, fields.QuestLog[i]);
+    }
+    for (std::size_t i = 0; i < 19; ++i)
+        WriteCreate(data, fields.VisibleItems[i]);
+    data << fields.PlayerTitle._value;
+    data << fields.FakeInebriation._value;
+    data << fields.VirtualPlayerRealm._value;
+    data << fields.CurrentSpecID._value;
+    data << fields.TaxiMountAnimKitID._value;
+    for (std::size_t i = 0; i < 6; ++i)
+        data << fields.AvgItemLevel[i];
+    data << fields.CurrentBattlePetBreedQuality._value;
+    data << fields.HonorLevel._value;
+    data << uint64(0);                                          // LogoutTime
+    data << uint32(fields.ArenaCooldowns.size());
+    data << uint32(0);
+    data << uint32(0);
+    for (std::size_t i = 0; i < 19; ++i)
+        data << uint32(0);
+    for (std::size_t i = 0; i < fields.Customizations.size(); ++i)
+    {
+        data << fields.Customizations[i].ChrCustomizationOptionID;
+        data << fields.Customizations[i].ChrCustomizationChoiceID;
+    }
+    for (std::size_t i = 0; i < fields.ArenaCooldowns.size(); ++i)
+        WriteCreate(data, fields.ArenaCooldowns[i]);
+}
+
+void WriteUpdate(ByteBuffer& data, PlayerData const& fields, uint32 const* mask)
+{
+    uint32 m[4];
+    ClampMask(UpdateFieldStruct::Player, mask, m);
+    UpdateMask<32 * 4> changesMask(m, 4);
+    WriteMaskBlocks(data, 4, m);
+    data.WriteBit(0);                                           // quest logs are sent with their own changes mask
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            WriteUpdateMask(data, fields.Customizations.size());
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.ArenaCooldowns.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            for (std::size_t i = 0; i < fields.Customizations.size(); ++i)
+            {
+                data << fields.Customizations[i].ChrCustomizationOptionID;
+                data << fields.Customizations[i].ChrCustomizationChoiceID;
+            }
+        }
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.ArenaCooldowns.size(); ++i)
+                WriteUpdate(data, fields.ArenaCooldowns[i]);
+        }
+        if (changesMask[4])
+            data << fields.DuelArbiter._value;
+        if (changesMask[5])
+            data << fields.WowAccount._value;
+        if (changesMask[6])
+            data << fields.LootTargetGUID._value;
+        if (changesMask[7])
+            data << fields.PlayerFlags._value;
+        if (changesMask[8])
+            data << fields.PlayerFlagsEx._value;
+        if (changesMask[9])
+            data << fields.GuildRankID._value;
+        if (changesMask[10])
+            data << fields.GuildDeleteDate._value;
+        if (changesMask[11])
+            data << fields.GuildLevel._value;
+        if (changesMask[12])
+            data << fields.PartyType._value;
+        if (changesMask[13])
+            data << fields.NativeSex._value;
+        if (changesMask[14])
+            data << fields.Inebriation._value;
+        if (changesMask[15])
+            data << fields.PvpTitle._value;
+        if (changesMask[16])
+            data << fields.ArenaFaction._value;
+        if (changesMask[17])
+            data << fields.PvpRank._value;
+        if (changesMask[18])
+            data << fields.Unk254._value;
+        if (changesMask[19])
+            data << fields.DuelTeam._value;
+        if (changesMask[20])
+            data << fields.GuildTimeStamp._value;
+        if (changesMask[21])
+            data << fields.PlayerTitle._value;
+        if (changesMask[22])
+            data << fields.FakeInebriation._value;
+        if (changesMask[23])
+            data << fields.VirtualPlayerRealm._value;
+        if (changesMask[24])
+            data << fields.CurrentSpecID._value;
+        if (changesMask[25])
+            data << fields.TaxiMountAnimKitID._value;
+        if (changesMask[26])
+            data << fields.CurrentBattlePetBreedQuality._value;
+        if (changesMask[27])
+            data << fields.HonorLevel._value;
+        if (changesMask[28])
+            data << uint64(0);
+        if (changesMask[29])
+            data << uint32(0);
+    }
+    if (changesMask[30])
+    {
+        for (std::size_t i = 0; i < 25; ++i)
+            if (changesMask[31 + i])
+                WriteUpdate(data, fields.QuestLog[i]);
+    }
+    if (changesMask[56])
+    {
+        for (std::size_t i = 0; i < 19; ++i)
+            if (changesMask[57 + i])
+                WriteUpdate(data, fields.VisibleItems[i]);
+    }
+    if (changesMask[76])
+    {
+        for (std::size_t i = 0; i < 6; ++i)
+            if (changesMask[77 + i])
+                data << fields.AvgItemLevel[i];
+    }
+    if (changesMask[83])
+    {
+        for (std::size_t i = 0; i < 19; ++i)
+            if (changesMask[84 + i])
+                data << uint32(0);
+    }
+}
+
+void WriteCreate(ByteBuffer& data, ActivePlayerData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    for (std::size_t i = 0; i < 129 + 12; ++i)
+        data << fields.InvSlots[i];
+    data << fields.FarsightObject._value;
+    data << fields.ComboTarget._value;
+    data << uint32(fields.KnownTitles.size());
+    data << fields.Coinage._value;
+    data << fields.XP._value;
+    data << fields.NextLevelXP._value;
+    data << fields.TrialXP._value;
+    WriteCreate(data, fields.Skill._value);
+    data << fields.CharacterPoints._value;
+    data << fields.MaxTalentTiers._value;
+    data << fields.TrackCreatureMask._value;
+    for (std::size_t i = 0; i < 2; ++i)
+        data << fields.TrackResourceMask[i];
+    data << fields.MainhandExpertise._value;
+    data << fields.OffhandExpertise._value;
+    data << fields.RangedExpertise._value;
+    data << fields.CombatRatingExpertise._value;
+    data << fields.BlockPercentage._value;
+    data << fields.DodgePercentage._value;
+    data << fields.DodgePercentageFromAttribute._value;
+    data << fields.ParryPercentage._value;
+    data << fields.ParryPercentageFromAttribute._value;
+    data << fields.CritPercentage._value;
+    data << fields.RangedCritPercentage._value;
+    data << fields.OffhandCritPercentage._value;
+    for (std::size_t i = 0; i < 7; ++i)
+    {
+        data << fields.SpellCritPercentage[i];
+        data << fields.ModDamageDonePos[i];
+        data << fields.ModDamageDoneNeg[i];
+        data << fields.ModDamageDonePercent[i];
+    }
+    data << fields.ShieldBlock._value;
+    data << fields.Mastery._value;
+    data << fields.Speed._value;
+    data << fields.Avoidance._value;
+    data << fields.Sturdiness._value;
+    data << fields.Unk340_3._value;
+    data << fields.Versatility._value;
+    data << fields.VersatilityBonus._value;
+    data << fields.PvpPowerDamage._value;
+    data << fields.PvpPowerHealing._value;
+    for (std::size_t i = 0; i < 240; ++i)
+        data << fields.ExploredZones[i];
+    for (std::size_t i = 0; i < 2; ++i)
+        WriteCreate(data, fields.RestInfo[i]);
+    data << fields.ModHealingDonePos._value;
+    data << fields.ModHealingPercent._value;
+    data << fields.ModHealingDonePercent._value;
+    data << fields.ModPeriodicHealingDonePercent._value;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        data << fields.WeaponDmgMultipliers[i];
+        data << fields.WeaponAtkSpeedMultipliers[i];
+    }
+    data << fields.ModSpellPowerPercent._value;
+    data << fields.ModResiliencePercent._value;
+    data << fields.OverrideSpellPowerByAPPercent._value;
+    data << fields.OverrideAPBySpellPowerPercent._value;
+    data << fields.ModTargetResistance._value;
+    data << fields.ModTargetPhysicalResistance._value;
+    data << fields.LocalFlags._value;
+    data << fields.GrantableLevels._value;
+    data << fields.MultiActionBars._value;
+    data << fields.LifetimeMaxRank._value;
+    data << fields.NumRespecs._value;
+    data << fields.AmmoID._value;
+    data << fields.PvpMedals._value;
+    for (std::size_t i = 0; i < 12; ++i)
+    {
+        data << fields.BuybackPrice[i];
+        data << fields.BuybackTimestamp[i];
+    }
+    data << fields.TodayHonorableKills._value;
+    data << fields.TodayDishonorableKills._value;
+    data << fields.YesterdayHonorableKills._value;
+    data << fields.YesterdayDishonorableKills._value;
+    data << fields.LastWeekHonorableKills._value;
+    data << fields.LastWeekDishonorableKills._value;
+    data << fields.ThisWeekHonorableKills._value;
+    data << fields.ThisWeekDishonorableKills._value;
+    data << fields.ThisWeekContribution._value;
+    data << fields.LifetimeHonorableKills._value;
+    data << fields.LifetimeDishonorableKills._value;
+    data << fields.YesterdayContribution._value;
+    data << fields.LastWeekContribution._value;
+    data << fields.LastWeekRank._value;
+    data << fields.WatchedFactionIndex._value;
+    for (std::size_t i = 0; i < 32; ++i)
+        data << fields.CombatRatings[i];
+    data << fields.MaxLevel._value;
+    data << fields.ScalingPlayerLevelDelta._value;
+    data << fields.MaxCreatureScalingLevel._value;
+    for (std::size_t i = 0; i < 4; ++i)
+        data << fields.NoReagentCostMask[i];
+    data << fields.PetSpellPower._value;
+    for (std::size_t i = 0; i < 2; ++i)
+        data << fields.ProfessionSkillLine[i];
+    data << fields.UiHitModifier._value;
+    data << fields.UiSpellHitModifier._value;
+    data << fields.HomeRealmTimeOffset._value;
+    data << fields.ModPetHaste._value;
+    data << fields.LocalRegenFlags._value;
+    data << fields.AuraVision._value;
+    data << fields.NumBackpackSlots._value;
+    data << fields.OverrideSpellsID._value;
+    data << fields.LfgBonusFactionID._value;
+    data << fields.LootSpecID._value;
+    data << fields.OverrideZonePVPType._value;
+    for (std::size_t i = 0; i < 4; ++i)
+        data << fields.BagSlotFlags[i];
+    for (std::size_t i = 0; i < 7; ++i)
+        data << fields.BankBagSlotFlags[i];
+    for (std::size_t i = 0; i < 875; ++i)
+        data << fields.QuestCompleted[i];
+    data << fields.Honor._value;
+    data << fields.HonorNextLevel._value;
+    data << fields.PvpTierMaxFromWins._value;
+    data << fields.PvpLastWeeksTierMaxFromWins._value;
+    data << fields.NumBankSlots._value;
+    data << uint32(fields.ResearchSites.size());
+    data << uint32(fields.ResearchSiteProgress.size());
+    data << uint32(fields.DailyQuestsCompleted.size());
+    data << uint32(fields.AvailableQuestLineXQuestIDs.size());
+    data << uint32(fields.Unk254.size());
+    data << uint32(fields.Heirlooms.size());
+    data << uint32(fields.HeirloomFlags.size());
+    data << uint32(fields.Toys.size());
+    data << uint32(fields.Transmog.size());
+    data << uint32(fields.ConditionalTransmog.size());
+    data << uint32(fields.SelfResSpells.size());
+    data << uint32(fields.CharacterRestrictions.size());
+    data << uint32(fields.SpellPctModByLabel.size());
+    data << uint32(fields.SpellFlatModByLabel.size());
+    for (std::size_t i = 0; i < 1; ++i)
+    {
+        data << uint32(fields.Research[i].size());
+        for (std::size_t j = 0; j < fields.Research[i].size(); ++j)
+            data << fields.Research[i][j].ResearchProjectID;
+    }
+    data << uint32(0);                                          // UiChromieTimeExpansionID
+    data << fields.TransportServerTime._value;
+    data << uint32(0);
+    data << uint32(0);
+    for (std::size_t i = 0; i < 6; ++i)
+        WriteCreate(data, fields.GlyphInfos[i]);
+    data << fields.GlyphsEnabled._value;
+    data << fields.Unk340._value;
+    for (std::size_t i = 0; i < fields.KnownTitles.size(); ++i)
+        data << fields.KnownTitles[i];
+    for (std::size_t i = 0; i < fields.ResearchSites.size(); ++i)
+        data << fields.ResearchSites[i];
+    for (std::size_t i = 0; i < fields.ResearchSiteProgress.size(); ++i)
+        data << fields.ResearchSiteProgress[i];
+    for (std::size_t i = 0; i < fields.DailyQuestsCompleted.size(); ++i)
+        data << fields.DailyQuestsCompleted[i];
+    for (std::size_t i = 0; i < fields.AvailableQuestLineXQuestIDs.size(); ++i)
+        data << fields.AvailableQuestLineXQuestIDs[i];
+    for (std::size_t i = 0; i < fields.Unk254.size(); ++i)
+        data << fields.Unk254[i];
+    for (std::size_t i = 0; i < fields.Heirlooms.size(); ++i)
+        data << fields.Heirlooms[i];
+    for (std::size_t i = 0; i < fields.HeirloomFlags.size(); ++i)
+        data << fields.HeirloomFlags[i];
+    for (std::size_t i = 0; i < fields.Toys.size(); ++i)
+        data << fields.Toys[i];
+    for (std::size_t i = 0; i < fields.Transmog.size(); ++i)
+        data << fields.Transmog[i];
+    for (std::size_t i = 0; i < fields.ConditionalTransmog.size(); ++i)
+        data << fields.ConditionalTransmog[i];
+    for (std::size_t i = 0; i < fields.SelfResSpells.size(); ++i)
+        data << fields.SelfResSpells[i];
+    for (std::size_t i = 0; i < fields.SpellPctModByLabel.size(); ++i)
+        WriteCreate(data, fields.SpellPctModByLabel[i]);
+    for (std::size_t i = 0; i < fields.SpellFlatModByLabel.size(); ++i)
+        WriteCreate(data, fields.SpellFlatModByLabel[i]);
+    for (std::size_t i = 0; i < 7; ++i)
+        WriteCreate(data, fields.PvpInfo[i]);
+    data.WriteBit(fields.InsertItemsLeftToRight._value);
+    data.FlushBits();
+    for (std::size_t i = 0; i < fields.CharacterRestrictions.size(); ++i)
+        WriteCreate(data, fields.CharacterRestrictions[i]);
+    for (std::size_t i = 0; i < 49; ++i)                        // skipped by the decoder
+        data << uint8(0);
+}
+
+void WriteUpdate(ByteBuffer& data, ActivePlayerData const& fields, uint32 const* mask)
+{
+    uint32 m[48];
+    ClampMask(UpdateFieldStruct::ActivePlayer, mask, m);
+    UpdateMask<32 * 48> changesMask(m, 48);
+    WriteWideMaskBlocks(data, 48, m);
+
+    // the decoder continues with these bits right after the mask blocks
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            data.WriteBit(fields.InsertItemsLeftToRight._value);
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.KnownTitles.size());
+        if (changesMask[3])
+            WriteUpdateMask(data, fields.ResearchSites.size());
+        if (changesMask[4])
+            WriteUpdateMask(data, fields.ResearchSiteProgress.size());
+        if (changesMask[5])
+            WriteUpdateMask(data, fields.DailyQuestsCompleted.size());
+        if (changesMask[6])
+            WriteUpdateMask(data, fields.AvailableQuestLineXQuestIDs.size());
+        if (changesMask[7])
+            WriteUpdateMask(data, fields.Unk254.size());
+        if (changesMask[8])
+            WriteUpdateMask(data, fields.Heirlooms.size());
+        if (changesMask[9])
+            WriteUpdateMask(data, fields.HeirloomFlags.size());
+        if (changesMask[10])
+            WriteUpdateMask(data, fields.Toys.size());
+        if (changesMask[11])
+            WriteUpdateMask(data, fields.Transmog.size());
+        if (changesMask[12])
+            WriteUpdateMask(data, fields.ConditionalTransmog.size());
+        if (changesMask[13])
+            WriteUpdateMask(data, fields.SelfResSpells.size());
+        if (changesMask[14])
+            WriteUpdateMask(data, fields.CharacterRestrictions.size());
+        if (changesMask[15])
+            WriteUpdateMask(data, fields.SpellPctModByLabel.size());
+        if (changesMask[16])
+            WriteUpdateMask(data, fields.SpellFlatModByLabel.size());
+    }
+    if (changesMask[17])
+    {
+        for (std::size_t i = 0; i < 1; ++i)
+        {
+            if (changesMask[18 + i])
+            {
+                WriteUpdateMask(data, fields.Research[i].size());
+                for (std::size_t j = 0; j < fields.Research[i].size(); ++j)
+                    data << fields.Research[i][j].ResearchProjectID;
+            }
+        }
+    }
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.KnownTitles.size(); ++i)
+                data << fields.KnownTitles[i];
+        }
+        if (changesMask[3])
+        {
+            for (std::size_t i = 0; i < fields.ResearchSites.size(); ++i)
+                data << fields.ResearchSites[i];
+        }
+        if (changesMask[4])
+        {
+            for (std::size_t i = 0; i < fields.ResearchSiteProgress.size(); ++i)
+                data << fields.ResearchSiteProgress[i];
+        }
+        if (changesMask[5])
+        {
+            for (std::size_t i = 0; i < fields.DailyQuestsCompleted.size(); ++i)
+                data << fields.DailyQuestsCompleted[i];
+        }
+        if (changesMask[6])
+        {
+            for (std::size_t i = 0; i < fields.AvailableQuestLineXQuestIDs.size(); ++i)
+                data << fields.AvailableQuestLineXQuestIDs[i];
+        }
+        if (changesMask[7])
+        {
+            for (std::size_t i = 0; i < fields.Unk254.size(); ++i)
+                data << fields.Unk254[i];
+        }
+        if (changesMask[8])
+        {
+            for (std::size_t i = 0; i < fields.Heirlooms.size(); ++i)
+                data << fields.Heirlooms[i];
+        }
+        if (changesMask[9])
+        {
+            for (std::size_t i = 0; i < fields.HeirloomFlags.size(); ++i)
+                data << fields.HeirloomFlags[i];
+        }
+        if (changesMask[10])
+        {
+            for (std::size_t i = 0; i < fields.Toys.size(); ++i)
+                data << fields.Toys[i];
+        }
+        if (changesMask[11])
+        {
+            for (std::size_t i = 0; i < fields.Transmog.size(); ++i)
+                data << fields.Transmog[i];
+        }
+        if (changesMask[12])
+        {
+            for (std::size_t i = 0; i < fields.ConditionalTransmog.size(); ++i)
+                data << fields.ConditionalTransmog[i];
+        }
+        if (changesMask[13])
+        {
+            for (std::size_t i = 0; i < fields.SelfResSpells.size(); ++i)
+                data << fields.SelfResSpells[i];
+        }
+        if (changesMask[15])
+        {
+            for (std::size_t i = 0; i < fields.SpellPctModByLabel.size(); ++i)
+                WriteCreate(data, fields.SpellPctModByLabel[i]);
+        }
+        if (changesMask[16])
+        {
+            for (std::size_t i = 0; i < fields.SpellFlatModByLabel.size(); ++i)
+                WriteCreate(data, fields.SpellFlatModByLabel[i]);
+        }
+        if (changesMask[14])
+        {
+            for (std::size_t i = 0; i < fields.CharacterRestrictions.size(); ++i)
+                WriteCreate(data, fields.CharacterRestrictions[i]);
+        }
+        for (uint32 bit = 19; bit <= 22; ++bit)
+            if (changesMask[bit])
+                data << uint32(0);
+        if (changesMask[23])
+            data << fields.FarsightObject._value;
+        if (changesMask[24])
+            data << fields.ComboTarget._value;
+        if (changesMask[25])
+            data << fields.Coinage._value;
+        if (changesMask[26])
+            data << fields.XP._value;
+        if (changesMask[27])
+            data << fields.NextLevelXP._value;
+        if (changesMask[28])
+            data << fields.TrialXP._value;
+        if (changesMask[29])
+            WriteUpdate(data, fields.Skill._value);
+        if (changesMask[30])
+            data << fields.CharacterPoints._value;
+        if (changesMask[31])
+            data << fields.MaxTalentTiers._value;
+        if (changesMask[32])
+            data << fields.TrackCreatureMask._value;
+        if (changesMask[33])
+            data << fields.MainhandExpertise._value;
+    }
+    if (changesMask[34])
+    {
+        if (changesMask[35])
+            data << fields.OffhandExpertise._value;
+        if (changesMask[36])
+            data << fields.RangedExpertise._value;
+        if (changesMask[37])
+            data << fields.CombatRatingExpertise._value;
+        if (changesMask[38])
+            data << fields.BlockPercentage._value;
+        if (changesMask[39])
+            data << fields.DodgePercentage._value;
+        if (changesMask[40])
+            data << fields.DodgePercentageFromAttribute._value;
+        if (changesMask[41])
+            data << fields.ParryPercentage._value;
+        if (changesMask[42])
+            data << fields.ParryPercentageFromAttribute._value;
+        if (changesMask[43])
+            data << fields.CritPercentage._value;
+        if (changesMask[44])
+            data << fields.RangedCritPercentage._value;
+        if (changesMask[45])
+            data << fields.OffhandCritPercentage._value;
+        if (changesMask[46])
+            data << fields.ShieldBlock._value;
+        if (changesMask[47])
+            data << fields.Mastery._value;
+        if (changesMask[48])
+            data << fields.Speed._value;
+        if (changesMask[49])
+            data << fields.Avoidance._value;
+        if (changesMask[50])
+            data << fields.Sturdiness._value;
+        if (changesMask[51])
+            data << fields.Unk340_3._value;
+        if (changesMask[52])
+            data << fields.Versatility._value;
+        if (changesMask[53])
+            data << fields.VersatilityBonus._value;
+        if (changesMask[54])
+            data << fields.PvpPowerDamage._value;
+        if (changesMask[55])
+            data << fields.PvpPowerHealing._value;
+        if (changesMask[56])
+            data << fields.ModHealingDonePos._value;
+        if (changesMask[57])
+            data << fields.ModHealingPercent._value;
+        if (changesMask[58])
+            data << fields.ModHealingDonePercent._value;
+        if (changesMask[59])
+            data << fields.ModPeriodicHealingDonePercent._value;
+        if (changesMask[60])
+            data << fields.ModSpellPowerPercent._value;
+        if (changesMask[61])
+            data << fields.ModResiliencePercent._value;
+        if (changesMask[62])
+            data << fields.OverrideSpellPowerByAPPercent._value;
+        if (changesMask[63])
+            data << fields.OverrideAPBySpellPowerPercent._value;
+        if (changesMask[64])
+            data << fields.ModTargetResistance._value;
+        if (changesMask[65])
+            data << fields.ModTargetPhysicalResistance._value;
+    }
+    if (changesMask[66])
+    {
+        if (changesMask[67])
+            data << fields.LocalFlags._value;
+        if (changesMask[68])
+            data << fields.GrantableLevels._value;
+        if (changesMask[69])
+            data << fields.MultiActionBars._value;
+        if (changesMask[70])
+            data << fields.LifetimeMaxRank._value;
+        if (changesMask[71])
+            data << fields.NumRespecs._value;
+        if (changesMask[72])
+            data << fields.AmmoID._value;
+        if (changesMask[73])
+            data << fields.PvpMedals._value;
+        if (changesMask[74])
+            data << fields.TodayHonorableKills._value;
+        if (changesMask[75])
+            data << fields.TodayDishonorableKills._value;
+        if (changesMask[76])
+            data << fields.YesterdayHonorableKills._value;
+        if (changesMask[77])
+            data << fields.YesterdayDishonorableKills._value;
+        if (changesMask[78])
+            data << fields.LastWeekHonorableKills._value;
+        if (changesMask[79])
+            data << fields.LastWeekDishonorableKills._value;
+        if (changesMask[80])
+            data << fields.ThisWeekHonorableKills._value;
+        if (changesMask[81])
+            data << fields.ThisWeekDishonorableKills._value;
+        if (changesMask[82])
+            data << fields.ThisWeekContribution._value;
+        if (changesMask[83])
+            data << fields.LifetimeHonorableKills._value;
+        if (changesMask[84])
+            data << fields.LifetimeDishonorableKills._value;
+        if (changesMask[85])
+            data << fields.YesterdayContribution._value;
+        if (changesMask[86])
+            data << fields.LastWeekContribution._value;
+        if (changesMask[87])
+            data << fields.LastWeekRank._value;
+        if (changesMask[88])
+            data << fields.WatchedFactionIndex._value;
+        if (changesMask[89])
+            data << fields.MaxLevel._value;
+        if (changesMask[90])
+            data << fields.ScalingPlayerLevelDelta._value;
+        if (changesMask[91])
+            data << fields.MaxCreatureScalingLevel._value;
+        if (changesMask[92])
+            data << fields.PetSpellPower._value;
+        if (changesMask[93])
+            data << fields.UiHitModifier._value;
+        if (changesMask[94])
+            data << fields.UiSpellHitModifier._value;
+        if (changesMask[95])
+            data << fields.HomeRealmTimeOffset._value;
+        if (changesMask[96])
+            data << fields.ModPetHaste._value;
+        if (changesMask[97])
+            data << fields.LocalRegenFlags._value;
+    }
+    if (changesMask[98])
+    {
+        if (changesMask[99])
+            data << fields.AuraVision._value;
+        if (changesMask[100])
+            data << fields.NumBackpackSlots._value;
+        if (changesMask[101])
+            data << fields.OverrideSpellsID._value;
+        if (changesMask[102])
+            data << fields.LfgBonusFactionID._value;
+        if (changesMask[103])
+            data << fields.LootSpecID._value;
+        if (changesMask[104])
+            data << fields.OverrideZonePVPType._value;
+        if (changesMask[105])
+            data << fields.Honor._value;
+        if (changesMask[106])
+            data << fields.HonorNextLevel._value;
+        if (changesMask[107])
+            data << fields.PvpTierMaxFromWins._value;
+        if (changesMask[108])
+            data << fields.PvpLastWeeksTierMaxFromWins._value;
+        if (changesMask[109])
+            data << fields.NumBankSlots._value;
+        if (changesMask[110])
+            data << uint32(0);
+        if (changesMask[111])
+            data << uint32(0);
+        if (changesMask[112])
+            data << fields.TransportServerTime._value;
+        if (changesMask[113])
+            data << fields.GlyphsEnabled._value;
+        if (changesMask[114])
+            data << fields.Unk340._value;
+        if (changesMask[115])
+            data << uint32(0);
+    }
+    if (changesMask[116])
+    {
+        for (std::size_t i = 0; i < 129 + 12; ++i)
+            if (changesMask[117 + i])
+                data << fields.InvSlots[i];
+    }
+    // bits 246-248 are both InvSlots[129-131] and the TrackResourceMask group, as in the decoder
+    if (changesMask[246])
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+            if (changesMask[247 + i])
+                data << fields.TrackResourceMask[i];
+    }
+    if (changesMask[261])
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+        {
+            if (changesMask[262 + i])
+                data << fields.SpellCritPercentage[i];
+            if (changesMask[269 + i])
+                data << fields.ModDamageDonePos[i];
+            if (changesMask[276 + i])
+                data << fields.ModDamageDoneNeg[i];
+            if (changesMask[283 + i])
+                data << fields.ModDamageDonePercent[i];
+        }
+    }
+    if (changesMask[290])
+    {
+        for (std::size_t i = 0; i < 240; ++i)
+            if (changesMask[291 + i])
+                data << fields.ExploredZones[i];
+    }
+    if (changesMask[531])
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+            if (changesMask[532 + i])
+                WriteUpdate(data, fields.RestInfo[i]);
+    }
+    if (changesMask[534])
+    {
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (changesMask[535 + i])
+                data << fields.WeaponDmgMultipliers[i];
+            if (changesMask[538 + i])
+                data << fields.WeaponAtkSpeedMultipliers[i];
+        }
+    }
+    if (changesMask[541])
+    {
+        for (std::size_t i = 0; i < 12; ++i)
+        {
+            if (changesMask[542 + i])
+                data << fields.BuybackPrice[i];
+            if (changesMask[554 + i])
+                data << fields.BuybackTimestamp[i];
+        }
+    }
+    if (changesMask[566])
+    {
+        for (std::size_t i = 0; i < 32; ++i)
+            if (changesMask[567 + i])
+                data << fields.CombatRatings[i];
+    }
+    if (changesMask[599])
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+            if (changesMask[600 + i])
+                WriteUpdate(data, fields.PvpInfo[i]);
+    }
+    if (changesMask[607])
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+            if (changesMask[608 + i])
+                data << fields.NoReagentCostMask[i];
+    }
+    if (changesMask[612])
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+            if (changesMask[613 + i])
+                data << fields.ProfessionSkillLine[i];
+    }
+    if (changesMask[615])
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+            if (changesMask[616 + i])
+                data << fields.BagSlotFlags[i];
+    }
+    if (changesMask[620])
+    {
+        for (std::size_t i = 0; i < 7; ++i)
+            if (changesMask[621 + i])
+                data << fields.BankBagSlotFlags[i];
+    }
+    if (changesMask[628])
+    {
+        for (std::size_t i = 0; i < 875; ++i)
+            if (changesMask[629 + i])
+                data << fields.QuestCompleted[i];
+    }
+    if (changesMask[1504])
+    {
+        for (std::size_t i = 0; i < 6; ++i)
+            if (changesMask[1505 + i])
+                WriteUpdate(data, fields.GlyphInfos[i]);
+    }
+    data.FlushBits();
+}
+
+void WriteCreate(ByteBuffer& data, GameObjectData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << fields.DisplayID._value;
+    data << fields.SpellVisualID._value;
+    data << fields.StateSpellVisualID._value;
+    data << fields.SpawnTrackingStateAnimID._value;
+    data << fields.SpawnTrackingStateAnimKitID._value;
+    data << uint32(fields.StateWorldEffectIDs._value.size());
+    for (uint32 stateWorldEffectId : fields.StateWorldEffectIDs._value)
+        data << stateWorldEffectId;
+    data << fields.CreatedBy._value;
+    data << fields.GuildGUID._value;
+    data << fields.Flags._value;
+    data << fields.ParentRotation._value.x;
+    data << fields.ParentRotation._value.y;
+    data << fields.ParentRotation._value.z;
+    data << fields.ParentRotation._value.w;
+    data << fields.FactionTemplate._value;
+    data << fields.Level._value;
+    data << uint8(fields.State._value);
+    data << uint8(fields.TypeID._value);
+    data << fields.PercentHealth._value;
+    data << fields.ArtKit._value;
+    data << uint32(fields.EnableDoodadSets.size());
+    data << fields.CustomParam._value;
+    data << uint32(fields.WorldEffects.size());
+    for (std::size_t i = 0; i < fields.EnableDoodadSets.size(); ++i)
+        data << fields.EnableDoodadSets[i];
+    for (std::size_t i = 0; i < fields.WorldEffects.size(); ++i)
+        data << fields.WorldEffects[i];
+}
+
+void WriteUpdate(ByteBuffer& data, GameObjectData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::GameObject, mask, m);
+    UpdateMask<20> changesMask(m[0]);
+    data.WriteBits(m[0], 20);
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            data.WriteBits(fields.StateWorldEffectIDs._value.size(), 32);
+            for (uint32 stateWorldEffectId : fields.StateWorldEffectIDs._value)
+                data << stateWorldEffectId;
+        }
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.EnableDoodadSets.size());
+        if (changesMask[3])
+            WriteUpdateMask(data, fields.WorldEffects.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.EnableDoodadSets.size(); ++i)
+                data << fields.EnableDoodadSets[i];
+        }
+        if (changesMask[3])
+        {
+            for (std::size_t i = 0; i < fields.WorldEffects.size(); ++i)
+                data << fields.WorldEffects[i];
+        }
+        if (changesMask[4])
+            data << fields.DisplayID._value;
+        if (changesMask[5])
+            data << fields.SpellVisualID._value;
+        if (changesMask[6])
+            data << fields.StateSpellVisualID._value;
+        if (changesMask[7])
+            data << fields.SpawnTrackingStateAnimID._value;
+        if (changesMask[8])
+            data << fields.SpawnTrackingStateAnimKitID._value;
+        if (changesMask[9])
+            data << fields.CreatedBy._value;
+        if (changesMask[10])
+            data << fields.GuildGUID._value;
+        if (changesMask[11])
+            data << fields.Flags._value;
+        if (changesMask[12])
+        {
+            data << fields.ParentRotation._value.x;
+            data << fields.ParentRotation._value.y;
+            data << fields.ParentRotation._value.z;
+            data << fields.ParentRotation._value.w;
+        }
+        if (changesMask[13])
+            data << fields.FactionTemplate._value;
+        if (changesMask[14])
+            data << fields.Level._value;
+        if (changesMask[15])
+            data << uint8(fields.State._value);
+        if (changesMask[16])
+            data << uint8(fields.TypeID._value);
+        if (changesMask[17])
+            data << fields.PercentHealth._value;
+        if (changesMask[18])
+            data << fields.ArtKit._value;
+        if (changesMask[19])
+            data << fields.CustomParam._value;
+    }
+}
+
+
+void WriteCreate(ByteBuffer& data, DynamicObjectData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << fields.Caster._value;
+    data << fields.Type._value;
+    data << fields.SpellXSpellVisualID._value;
+    data << fields.SpellID._value;
+    data << fields.Radius._value;
+    data << fields.CastTime._value;
+}
+
+void WriteUpdate(ByteBuffer& data, DynamicObjectData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::DynamicObject, mask, m);
+    UpdateMask<7> changesMask(m[0]);
+    data.WriteBits(m[0], 7);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            data << fields.Caster._value;
+        if (changesMask[2])
+            data << fields.Type._value;
+        if (changesMask[3])
+            data << fields.SpellXSpellVisualID._value;
+        if (changesMask[4])
+            data << fields.SpellID._value;
+        if (changesMask[5])
+            data << fields.Radius._value;
+        if (changesMask[6])
+            data << fields.CastTime._value;
+    }
+}
+
+void WriteCreate(ByteBuffer& data, CorpseData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << fields.DynamicFlags._value;
+    data << fields.Owner._value;
+    data << fields.PartyGUID._value;
+    data << fields.GuildGUID._value;
+    data << fields.DisplayID._value;
+    for (std::size_t i = 0; i < 19; ++i)
+        data << fields.Items[i];
+    data << fields.RaceID._value;
+    data << fields.Sex._value;
+    data << fields.Class._value;
+    data << uint32(fields.Customizations.size());
+    data << fields.Flags._value;
+    data << fields.FactionTemplate._value;
+    for (std::size_t i = 0; i < fields.Customizations.size(); ++i)
+    {
+        data << fields.Customizations[i].ChrCustomizationOptionID;
+        data << fields.Customizations[i].ChrCustomizationChoiceID;
+    }
+}
+
+void WriteUpdate(ByteBuffer& data, CorpseData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::Corpse, mask, m);
+    UpdateMask<32> changesMask(m[0]);
+    data.WriteBit(m[0] != 0);
+    if (m[0])
+        data.WriteBits(m[0], 32);
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            WriteUpdateMask(data, fields.Customizations.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            for (std::size_t i = 0; i < fields.Customizations.size(); ++i)
+            {
+                data << fields.Customizations[i].ChrCustomizationOptionID;
+                data << fields.Customizations[i].ChrCustomizationChoiceID;
+            }
+        }
+        if (changesMask[2])
+            data << fields.DynamicFlags._value;
+        if (changesMask[3])
+            data << fields.Owner._value;
+        if (changesMask[4])
+            data << fields.PartyGUID._value;
+        if (changesMask[5])
+            data << fields.GuildGUID._value;
+        if (changesMask[6])
+            data << fields.DisplayID._value;
+        if (changesMask[7])
+            data << fields.RaceID._value;
+        if (changesMask[8])
+            data << fields.Sex._value;
+        if (changesMask[9])
+            data << fields.Class._value;
+        if (changesMask[10])
+            data << fields.Flags._value;
+        if (changesMask[11])
+            data << fields.FactionTemplate._value;
+    }
+    if (changesMask[12])
+    {
+        for (std::size_t i = 0; i < 19; ++i)
+            if (changesMask[13 + i])
+                data << fields.Items[i];
+    }
+}
+
+void WriteCreate(ByteBuffer& data, AreaTriggerData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    WriteCreate(data, fields.OverrideScaleCurve._value);
+    data << fields.Caster._value;
+    data << fields.Duration._value;
+    data << fields.TimeToTarget._value;
+    data << fields.TimeToTargetScale._value;
+    data << fields.TimeToTargetExtraScale._value;
+    data << fields.SpellID._value;
+    data << fields.SpellForVisuals._value;
+    data << fields.SpellXSpellVisualID._value;
+    data << fields.BoundsRadius2D._value;
+    data << fields.DecalPropertiesID._value;
+    data << fields.CreatingEffectGUID._value;
+    data << fields.Field_80._value;
+    WriteCreate(data, fields.ExtraScaleCurve._value);
+    WriteCreate(data, fields.VisualAnim._value);
+}
+
+void WriteUpdate(ByteBuffer& data, AreaTriggerData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::AreaTrigger, mask, m);
+    UpdateMask<16> changesMask(m[0]);
+    data.WriteBits(m[0], 16);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            WriteUpdate(data, fields.OverrideScaleCurve._value);
+        if (changesMask[3])
+            data << fields.Caster._value;
+        if (changesMask[4])
+            data << fields.Duration._value;
+        if (changesMask[5])
+            data << fields.TimeToTarget._value;
+        if (changesMask[6])
+            data << fields.TimeToTargetScale._value;
+        if (changesMask[7])
+            data << fields.TimeToTargetExtraScale._value;
+        if (changesMask[8])
+            data << fields.SpellID._value;
+        if (changesMask[9])
+            data << fields.SpellForVisuals._value;
+        if (changesMask[10])
+            data << fields.SpellXSpellVisualID._value;
+        if (changesMask[11])
+            data << fields.BoundsRadius2D._value;
+        if (changesMask[12])
+            data << fields.DecalPropertiesID._value;
+        if (changesMask[13])
+            data << fields.CreatingEffectGUID._value;
+        if (changesMask[14])
+            data << fields.Field_80._value;
+        if (changesMask[2])
+            WriteUpdate(data, fields.ExtraScaleCurve._value);
+        if (changesMask[15])
+            WriteUpdate(data, fields.VisualAnim._value);
+    }
+}
+
+void WriteCreate(ByteBuffer& data, SceneObjectData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << fields.ScriptPackageID._value;
+    data << fields.RndSeedVal._value;
+    data << fields.CreatedBy._value;
+    data << fields.SceneType._value;
+}
+
+void WriteUpdate(ByteBuffer& data, SceneObjectData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::SceneObject, mask, m);
+    UpdateMask<5> changesMask(m[0]);
+    data.WriteBits(m[0], 5);
+    data.FlushBits();
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+            data << fields.ScriptPackageID._value;
+        if (changesMask[2])
+            data << fields.RndSeedVal._value;
+        if (changesMask[3])
+            data << fields.CreatedBy._value;
+        if (changesMask[4])
+            data << fields.SceneType._value;
+    }
+}
+
+void WriteCreate(ByteBuffer& data, ConversationData const& fields, EnumFlag<UpdateFieldFlag> /*fieldVisibilityFlags*/)
+{
+    data << uint32(fields.Lines._value.size());
+    data << fields.LastLineEndTime._value;
+    for (ConversationLine const& line : fields.Lines._value)
+        WriteCreate(data, line);
+    data << fields.Progress._value;
+    data << uint32(fields.Actors.size());
+    for (std::size_t i = 0; i < fields.Actors.size(); ++i)
+        WriteCreate(data, fields.Actors[i]);
+}
+
+void WriteUpdate(ByteBuffer& data, ConversationData const& fields, uint32 const* mask)
+{
+    uint32 m[1];
+    ClampMask(UpdateFieldStruct::Conversation, mask, m);
+    UpdateMask<5> changesMask(m[0]);
+    data.WriteBits(m[0], 5);
+
+    if (changesMask[0])
+    {
+        if (changesMask[1])
+        {
+            data.WriteBits(fields.Lines._value.size(), 32);
+            for (ConversationLine const& line : fields.Lines._value)
+                WriteCreate(data, line);
+        }
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+            WriteUpdateMask(data, fields.Actors.size());
+    }
+    data.FlushBits();
+    if (changesMask[0])
+    {
+        if (changesMask[2])
+        {
+            for (std::size_t i = 0; i < fields.Actors.size(); ++i)
+                WriteCreate(data, fields.Actors[i]);
+        }
+        if (changesMask[3])
+            data << fields.LastLineEndTime._value;
+        if (changesMask[4])
+            data << fields.Progress._value;
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef _UPDATEFIELDSWRITER_H
+#define _UPDATEFIELDSWRITER_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "UpdateFields.h"
+#include "UpdateFieldSink.h"
+
+namespace UF
+{
+
+/// Parent bit of a changes mask block and the contiguous child bits it guards.
+struct UpdateMaskGroup
+{
+    uint16 Parent;
+    uint16 First;
+    uint16 Last;
+};
+
+/// Changes mask bits the encoders below can write for a struct. Bits the decoders skip or reject
+/// (PlayerData bit 3, the unused ActivePlayerData bits) are dropped from update masks.
+struct UpdateMaskLayout
+{
+    uint32 Words;
+    UpdateMaskGroup const* Groups;
+    uint32 GroupCount;
+};
+
+UpdateMaskLayout const& GetUpdateMaskLayout(UpdateFieldStruct type);
+
+/// Encoders mirroring the ReadCreate/ReadUpdate decoders of UpdateFields.cpp, field for field.
+/// 'mask' holds Words changes mask words as laid out by GetUpdateMaskLayout; nested structs and dynamic
+/// fields are always written with all their fields and elements changed. Values the decoders don't keep
+/// (unknown fields, LogoutTime, ...) are written as 0.
+void WriteCreate(ByteBuffer& data, ObjectData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, ObjectData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, ItemData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, ItemData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, ContainerData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, ContainerData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, UnitData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, UnitData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, PlayerData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, PlayerData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, ActivePlayerData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, ActivePlayerData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, GameObjectData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, GameObjectData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, DynamicObjectData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, DynamicObjectData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, CorpseData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, CorpseData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, AreaTriggerData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, AreaTriggerData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, SceneObjectData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, SceneObjectData const& fields, uint32 const* mask);
+void WriteCreate(ByteBuffer& data, ConversationData const& fields, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+void WriteUpdate(ByteBuffer& data, ConversationData const& fields, uint32 const* mask);
+
+}
+
+#endif
@@ -0,0 +1,248 @@
+#include "UpdateObjectBatch.h"
+#include "AllocationAccounting.h"
+#include "DecodeTrace.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+
+namespace UF
+{
+
+namespace
+{
+    /// Copy of a block for its decoder. Every thread reuses one buffer, so once it grew to the largest block
+    /// decoding doesn't allocate; a batch executed from inside a decoder gets a buffer of its own.
+    class BlockBuffer
+    {
+    public:
+        BlockBuffer(uint8 const* block, uint32 size) : _ownsScratch(!ScratchInUse())
+        {
+            if (_ownsScratch)
+            {
+                ScratchInUse() = true;
+                _data = &Scratch();
+                _data->clear();
+            }
+            else
+            {
+                _nested.reset(new ByteBuffer(size));
+                _data = _nested.get();
+            }
+            _data->append(block, size);
+        }
+
+        ~BlockBuffer()
+        {
+            if (_ownsScratch)
+                ScratchInUse() = false;
+        }
+
+        BlockBuffer(BlockBuffer const&) = delete;
+        BlockBuffer& operator=(BlockBuffer const&) = delete;
+
+        ByteBuffer& Get() { return *_data; }
+
+    private:
+        static ByteBuffer& Scratch()
+        {
+            static thread_local ByteBuffer scratch;
+            return scratch;
+        }
+
+        static bool& ScratchInUse()
+        {
+            static thread_local bool inUse = false;
+            return inUse;
+        }
+
+        bool _ownsScratch;
+        ByteBuffer* _data;
+        std::unique_ptr<ByteBuffer> _nested;
+    };
+}
+
+UpdateDecodePool::UpdateDecodePool(uint32 threads) : _tasks(nullptr), _next(0), _finished(0), _generation(0), _stop(false)
+{
+    // the caller participates in Run, so one thread less is enough
+    for (uint32 i = 1; i < threads; ++i)
+        _workers.emplace_back(&UpdateDecodePool::WorkerLoop, this);
+}
+
+UpdateDecodePool::~UpdateDecodePool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::thread& worker : _workers)
+        worker.join();
+}
+
+void UpdateDecodePool::Run(std::vector<std::function<void()>>& tasks)
+{
+    if (tasks.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _tasks = &tasks;
+        _next = 0;
+        _finished = 0;
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    Drain();
+
+    std::unique_lock<std::mutex> guard(_lock);
+    _done.wait(guard, [&] { return _finished == tasks.size(); });
+    _tasks = nullptr;
+}
+
+void UpdateDecodePool::Drain()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    while (_tasks && _next < _tasks->size())
+    {
+        std::function<void()>& task = (*_tasks)[_next++];
+        guard.unlock();
+        task();
+        guard.lock();
+        if (++_finished == _tasks->size())
+            _done.notify_all();
+    }
+}
+
+void UpdateDecodePool::WorkerLoop()
+{
+    uint32 seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _wake.wait(guard, [&] { return _stop || (_generation != seen && _tasks); });
+            if (_stop)
+                return;
+            seen = _generation;
+        }
+        Drain();
+    }
+}
+
+void UpdateObjectBatch::AddValuesBlock(ByteBuffer& packet, void const* owner, DecodeFn decode, IStatUpdate& update)
+{
+    uint32 size = packet.read<uint32>();
+    std::size_t offset = packet.rpos();
+    packet.rpos(offset + size);
+    AddBlock(packet, offset, size, owner, std::move(decode), update);
+}
+
+void UpdateObjectBatch::AddBlock(ByteBuffer const& packet, std::size_t offset, uint32 size, void const* owner, DecodeFn decode, IStatUpdate& update)
+{
+    if (offset + size > packet.size())
+        throw ByteBufferPositionException(offset, size, packet.size());
+
+    Block block;
+    block.Packet = &packet;
+    block.Offset = offset;
+    block.Size = size;
+    block.Owner = owner;
+    block.Decode = std::move(decode);
+    block.Update = &update;
+    block.Decoded = false;
+    _blocks.push_back(std::move(block));
+}
+
+void UpdateObjectBatch::DecodeBlock(Block& block, IStatUpdate& update, DecodeTrace* trace, uint32 allocationOpcode)
+{
+    AllocationOpcodeScope allocationScope(allocationOpcode);
+    BlockBuffer buffer(block.Packet->contents() + block.Offset, block.Size);
+    ByteBuffer& data = buffer.Get();
+    DecodeTraceScope traceScope(trace, block.Offset);
+    block.Decode(data, update);
+    DecodeTrace::CheckBlockEnd(data, block.Size);
+    block.Decoded = true;
+}
+
+void UpdateObjectBatch::Execute(UpdateDecodePool* pool)
+{
+    DecodeTrace* trace = DecodeTrace::Current();
+    uint32 allocationOpcode = AllocationAccounting::Current().Opcode;
+    if (!pool || pool->GetThreadCount() < 2 || _blocks.size() < MinParallelBlocks)
+    {
+        try
+        {
+            for (Block& block : _blocks)
+                DecodeBlock(block, *block.Update, trace, allocationOpcode);
+        }
+        catch (...)
+        {
+            _blocks.clear();
+            throw;
+        }
+        _blocks.clear();
+        return;
+    }
+
+    // one lane per object keeps same-object blocks ordered
+    std::unordered_map<void const*, std::size_t> laneByOwner;
+    std::vector<std::vector<std::size_t>> lanes;
+    for (std::size_t i = 0; i < _blocks.size(); ++i)
+    {
+        auto itr = laneByOwner.emplace(_blocks[i].Owner, lanes.size());
+        if (itr.second)
+            lanes.emplace_back();
+        lanes[itr.first->second].push_back(i);
+    }
+
+    // lanes stop once they pass the first failing block, other lanes may have decoded later blocks already
+    std::atomic<std::size_t> firstFailed(std::numeric_limits<std::size_t>::max());
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(lanes.size());
+    for (std::vector<std::size_t> const& lane : lanes)
+    {
+        tasks.push_back([this, &lane, &firstFailed, trace, allocationOpcode]
+        {
+            for (std::size_t index : lane)
+            {
+                if (index > firstFailed.load(std::memory_order_relaxed))
+                    return;
+
+                Block& block = _blocks[index];
+                try
+                {
+                    DecodeBlock(block, block.Recorded, trace, allocationOpcode);
+                }
+                catch (...)
+                {
+                    block.Error = std::current_exception();
+                    std::size_t failed = firstFailed.load(std::memory_order_relaxed);
+                    while (index < failed && !firstFailed.compare_exchange_weak(failed, index, std::memory_order_relaxed))
+                        ;
+                    // later blocks of this object depend on the failed one
+                    return;
+                }
+            }
+        });
+    }
+
+    pool->Run(tasks);
+
+    // every decoded block changed its object, its callbacks are emitted even past a failure so that
+    // listeners always agree with the object state
+    std::exception_ptr error;
+    for (Block& block : _blocks)
+    {
+        if (block.Decoded)
+            block.Recorded.Replay(*block.Update);
+        else if (block.Error && !error)
+            error = block.Error;
+    }
+    _blocks.clear();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}
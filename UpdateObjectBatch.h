@@ -0,0 +1,104 @@
+#ifndef _UPDATEOBJECTBATCH_H
+#define _UPDATEOBJECTBATCH_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "StatUpdateRecorder.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UF
+{
+
+class DecodeTrace;
+
+/// Small fixed-size worker pool used to decode update blocks in parallel.
+class UpdateDecodePool
+{
+public:
+    explicit UpdateDecodePool(uint32 threads = std::thread::hardware_concurrency());
+    ~UpdateDecodePool();
+
+    UpdateDecodePool(UpdateDecodePool const&) = delete;
+    UpdateDecodePool& operator=(UpdateDecodePool const&) = delete;
+
+    /// Threads working on a Run, the calling thread included.
+    uint32 GetThreadCount() const { return uint32(_workers.size()) + 1; }
+
+    /// Runs every task and returns once all of them finished. The calling thread takes part in the work.
+    void Run(std::vector<std::function<void()>>& tasks);
+
+private:
+    void WorkerLoop();
+    void Drain();
+
+    std::vector<std::thread> _workers;
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::vector<std::function<void()>>* _tasks;
+    std::size_t _next;
+    std::size_t _finished;
+    uint32 _generation;
+    bool _stop;
+};
+
+/// Decodes the values blocks of one SMSG_UPDATE_OBJECT in two phases.
+/// Phase one walks the packet serially and only records block boundaries (values blocks are size prefixed,
+/// so skipping them is a single read). Phase two decodes the recorded blocks on a pool; blocks of the same
+/// object stay on one worker in packet order. IStatUpdate callbacks are captured while decoding and emitted
+/// afterwards in the original block order, so listeners see exactly what a serial decode would produce.
+/// Each block is copied into a buffer its decoding thread reuses, decoding doesn't allocate per block.
+class UpdateObjectBatch
+{
+public:
+    typedef std::function<void(ByteBuffer&, IStatUpdate&)> DecodeFn;
+
+    static uint32 const MinParallelBlocks = 16;
+
+    /// Phase one helper: reads the size prefix of a values block at rpos, records it and skips its payload.
+    /// 'owner' identifies the decoded object; blocks sharing an owner are decoded sequentially.
+    void AddValuesBlock(ByteBuffer& packet, void const* owner, DecodeFn decode, IStatUpdate& update);
+
+    /// Records a block whose boundaries are already known.
+    void AddBlock(ByteBuffer const& packet, std::size_t offset, uint32 size, void const* owner, DecodeFn decode, IStatUpdate& update);
+
+    std::size_t GetBlockCount() const { return _blocks.size(); }
+
+    /// Phase two. Without a pool, or for small batches, blocks are decoded serially in place.
+    /// Rethrows the exception of the first failing block after emitting callbacks of all blocks before it.
+    /// A serial decode stops there. On the pool, blocks of other objects after the failing one may already
+    /// be decoded; their callbacks are emitted as well, in block order, so listeners match the object state.
+    /// A DecodeTrace installed on the calling thread also records the blocks decoded by the pool, and makes
+    /// blocks not consumed exactly fail with UpdateFieldDesyncException. Allocations of pool workers are
+    /// accounted to the opcode the calling thread was handling.
+    void Execute(UpdateDecodePool* pool);
+
+    void Clear() { _blocks.clear(); }
+
+private:
+    struct Block
+    {
+        ByteBuffer const* Packet;
+        std::size_t Offset;
+        uint32 Size;
+        void const* Owner;
+        DecodeFn Decode;
+        IStatUpdate* Update;
+        StatUpdateRecorder Recorded;
+        std::exception_ptr Error;
+        bool Decoded;
+    };
+
+    static void DecodeBlock(Block& block, IStatUpdate& update, DecodeTrace* trace, uint32 allocationOpcode);
+
+    std::vector<Block> _blocks;
+};
+
+}
+
+#endif
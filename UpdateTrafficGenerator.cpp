@@ -0,0 +1,217 @@
+#include "UpdateTrafficGenerator.h"
+
+namespace UF
+{
+
+namespace
+{
+    // HighGuid values of the server side guid layout
+    uint32 const HIGHGUID_PLAYER        = 2;
+    uint32 const HIGHGUID_ITEM          = 3;
+    uint32 const HIGHGUID_CREATURE      = 8;
+    uint32 const HIGHGUID_GAMEOBJECT    = 11;
+
+    uint32 const GENERATED_MAP_ID       = 0;
+}
+
+TrafficScenario TrafficScenario::Raid()
+{
+    TrafficScenario scenario;
+    scenario.Players = 40;
+    scenario.Units = 200;
+    scenario.GameObjects = 20;
+    scenario.UpdateRatio = 0.5f;
+    scenario.MaskDensity = 0.03f;
+    return scenario;
+}
+
+TrafficScenario TrafficScenario::City()
+{
+    TrafficScenario scenario;
+    scenario.Players = 500;
+    scenario.Units = 60;
+    scenario.GameObjects = 40;
+    scenario.UpdateRatio = 0.1f;
+    scenario.MaskDensity = 0.02f;
+    return scenario;
+}
+
+UpdateTrafficGenerator::UpdateTrafficGenerator(TrafficScenario const& scenario) : _scenario(scenario), _random(scenario.Seed)
+{
+    for (uint32 i = 0; i < scenario.Players; ++i)
+        AddObject(TYPEID_PLAYER, HIGHGUID_PLAYER, 0);
+    for (uint32 i = 0; i < scenario.Units; ++i)
+        AddObject(TYPEID_UNIT, HIGHGUID_CREATURE, 1000 + _random() % 30000);
+    for (uint32 i = 0; i < scenario.GameObjects; ++i)
+        AddObject(TYPEID_GAMEOBJECT, HIGHGUID_GAMEOBJECT, 100000 + _random() % 100000);
+    for (uint32 i = 0; i < scenario.Items; ++i)
+        AddObject(scenario.BagEvery && i % scenario.BagEvery == 0 ? TYPEID_CONTAINER : TYPEID_ITEM, HIGHGUID_ITEM, 0);
+}
+
+UpdateTrafficGenerator::UpdateTrafficGenerator(TrafficScenario const& scenario, std::vector<std::unique_ptr<ObjectValues>> objects)
+    : _scenario(scenario), _random(scenario.Seed), _objects(std::move(objects))
+{
+}
+
+UpdateTrafficGenerator::~UpdateTrafficGenerator()
+{
+}
+
+void UpdateTrafficGenerator::AddObject(uint8 typeId, uint32 highGuid, uint32 entry)
+{
+    std::unique_ptr<ObjectValues> object(new ObjectValues());
+    object->TypeId = typeId;
+    object->Guid._high = (uint64(highGuid) << 58) | (uint64(GENERATED_MAP_ID) << 29) | (uint64(entry) << 6);
+    object->Guid._low = _objects.size() + 1;
+    object->ObjectFields.EntryID._value = entry;
+    object->ObjectFields.Scale._value = 1.0f;
+
+    switch (typeId)
+    {
+        case TYPEID_CONTAINER:
+            object->Container.reset(new ContainerData());
+            object->Container->NumSlots._value = 16;
+            // fall through - containers are items too
+        case TYPEID_ITEM:
+            object->Item.reset(new ItemData());
+            object->Item->StackCount._value = 1 + _random() % 20;
+            object->Item->MaxDurability._value = 100;
+            object->Item->Durability._value = _random() % 101;
+            break;
+        case TYPEID_PLAYER:
+            object->Player.reset(new PlayerData());
+            object->Player->NativeSex._value = _random() % 2;
+            // fall through - players are units too
+        case TYPEID_UNIT:
+        {
+            object->Unit.reset(new UnitData());
+            UnitData& unit = *object->Unit;
+            unit.MaxHealth._value = 1000 + _random() % 50000;
+            unit.Health._value = unit.MaxHealth._value;
+            unit.Level._value = 1 + _random() % 80;
+            unit.DisplayID._value = 1000 + _random() % 30000;
+            unit.NativeDisplayID._value = unit.DisplayID._value;
+            unit.FactionTemplate._value = 1 + _random() % 2000;
+            unit.MaxPower[0] = 100 + _random() % 20000;
+            unit.Power[0] = unit.MaxPower[0];
+            unit.BoundingRadius._value = 0.5f;
+            unit.CombatReach._value = 1.5f;
+            break;
+        }
+        case TYPEID_GAMEOBJECT:
+            object->GameObject.reset(new GameObjectData());
+            object->GameObject->DisplayID._value = 1 + _random() % 10000;
+            object->GameObject->FactionTemplate._value = _random() % 2000;
+            object->GameObject->State._value = 1;
+            object->GameObject->ParentRotation._value.w = 1.0f;
+            break;
+        default:
+            break;
+    }
+
+    _objects.push_back(std::move(object));
+}
+
+void UpdateTrafficGenerator::WriteCreates(ByteBuffer& packet, std::vector<GeneratedBlock>& blocks)
+{
+    for (std::unique_ptr<ObjectValues> const& object : _objects)
+        WriteCreate(packet, *object, blocks);
+}
+
+void UpdateTrafficGenerator::WriteTick(ByteBuffer& packet, std::vector<GeneratedBlock>& blocks)
+{
+    std::bernoulli_distribution updated(_scenario.UpdateRatio);
+    for (std::unique_ptr<ObjectValues> const& object : _objects)
+        if (updated(_random))
+            WriteUpdate(packet, *object, blocks);
+}
+
+void UpdateTrafficGenerator::WriteCreate(ByteBuffer& packet, ObjectValues const& object, std::vector<GeneratedBlock>& blocks)
+{
+    EnumFlag<UpdateFieldFlag> flags(static_cast<UpdateFieldFlag>(_scenario.VisibilityFlags));
+    std::size_t offset = packet.wpos();
+    packet << uint32(0);
+    packet << uint8(_scenario.VisibilityFlags);
+
+    WriteObjectCreate(packet, object, flags);
+
+    uint32 size = uint32(packet.wpos() - offset - sizeof(uint32));
+    packet.put<uint32>(offset, size);
+    blocks.push_back({ object.Guid, object.TypeId, true, offset, size });
+}
+
+void UpdateTrafficGenerator::WriteUpdate(ByteBuffer& packet, ObjectValues& object, std::vector<GeneratedBlock>& blocks)
+{
+    uint32 objectMask[1], itemMask[2], containerMask[2], unitMask[8], playerMask[4], gameObjectMask[1];
+    uint32 changedTypes = 0;
+    if (PickMask(UpdateFieldStruct::Object, objectMask))
+        changedTypes |= 1 << TYPEID_OBJECT;
+    if (object.Item && PickMask(UpdateFieldStruct::Item, itemMask))
+        changedTypes |= 1 << TYPEID_ITEM;
+    if (object.Container && PickMask(UpdateFieldStruct::Container, containerMask))
+        changedTypes |= 1 << TYPEID_CONTAINER;
+    if (object.Unit && PickMask(UpdateFieldStruct::Unit, unitMask))
+        changedTypes |= 1 << TYPEID_UNIT;
+    if (object.Player && PickMask(UpdateFieldStruct::Player, playerMask))
+        changedTypes |= 1 << TYPEID_PLAYER;
+    if (object.GameObject && PickMask(UpdateFieldStruct::GameObject, gameObjectMask))
+        changedTypes |= 1 << TYPEID_GAMEOBJECT;
+    if (!changedTypes)
+        return;
+
+    if (changedTypes & (1 << TYPEID_UNIT))
+    {
+        // the fields the stat listeners watch get new values, everything else is resent unchanged
+        UnitData& unit = *object.Unit;
+        if (IsFieldDecoded(unitMask, 8, 5))
+            unit.Health._value = _random() % (unit.MaxHealth._value + 1);
+        if (IsFieldDecoded(unitMask, 8, 135))
+            unit.Power[0] = _random() % (uint32(unit.MaxPower[0]) + 1);
+    }
+
+    std::size_t offset = packet.wpos();
+    packet << uint32(0);
+    packet << uint32(changedTypes);
+
+    if (changedTypes & (1 << TYPEID_OBJECT))
+        UF::WriteUpdate(packet, object.ObjectFields, objectMask);
+    if (changedTypes & (1 << TYPEID_ITEM))
+        UF::WriteUpdate(packet, *object.Item, itemMask);
+    if (changedTypes & (1 << TYPEID_CONTAINER))
+        UF::WriteUpdate(packet, *object.Container, containerMask);
+    if (changedTypes & (1 << TYPEID_UNIT))
+        UF::WriteUpdate(packet, *object.Unit, unitMask);
+    if (changedTypes & (1 << TYPEID_PLAYER))
+        UF::WriteUpdate(packet, *object.Player, playerMask);
+    if (changedTypes & (1 << TYPEID_GAMEOBJECT))
+        UF::WriteUpdate(packet, *object.GameObject, gameObjectMask);
+
+    uint32 size = uint32(packet.wpos() - offset - sizeof(uint32));
+    packet.put<uint32>(offset, size);
+    blocks.push_back({ object.Guid, object.TypeId, false, offset, size });
+}
+
+bool UpdateTrafficGenerator::PickMask(UpdateFieldStruct type, uint32* mask)
+{
+    UpdateMaskLayout const& layout = GetUpdateMaskLayout(type);
+    for (uint32 i = 0; i < layout.Words; ++i)
+        mask[i] = 0;
+
+    // parent bits are filled in by the encoders
+    std::bernoulli_distribution picked(_scenario.MaskDensity);
+    bool any = false;
+    for (uint32 g = 0; g < layout.GroupCount; ++g)
+    {
+        for (uint32 bit = layout.Groups[g].First; bit <= layout.Groups[g].Last; ++bit)
+        {
+            if (picked(_random))
+            {
+                mask[bit / 32] |= 1u << (bit % 32);
+                any = true;
+            }
+        }
+    }
+    return any;
+}
+
+}
@@ -0,0 +1,86 @@
+#ifndef _UPDATETRAFFICGENERATOR_H
+#define _UPDATETRAFFICGENERATOR_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "ObjectGuid.h"
+#include "UpdateFieldsWriter.h"
+#include "WorldSnapshot.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace UF
+{
+
+/// Object counts and update behaviour of a generated world.
+struct TrafficScenario
+{
+    uint32 Players = 0;
+    uint32 Units = 0;
+    uint32 GameObjects = 0;
+    uint32 Items = 0;                   // every BagEvery-th item is a container
+    uint32 BagEvery = 8;
+    float UpdateRatio = 0.25f;          // share of the objects updated per tick
+    float MaskDensity = 0.05f;          // share of the encodable changes mask bits set in an update
+    uint32 VisibilityFlags = 0;         // UpdateFieldFlag of the viewer
+    uint32 Seed = 1;
+
+    /// 40 players fighting 200 NPC units.
+    static TrafficScenario Raid();
+    /// 500 players around a few dozen NPCs and objects.
+    static TrafficScenario City();
+};
+
+/// Position of one values block in the generated packet.
+struct GeneratedBlock
+{
+    ObjectGuid Guid;
+    uint8 TypeId;
+    bool Create;
+    std::size_t Offset;                 // of the uint32 size prefix
+    uint32 Size;                        // without the size prefix
+};
+
+/// Produces values blocks for load tests of the decoders and object stores.
+/// Blocks use the server values block framing read by UpdateObjectBatch::AddValuesBlock:
+/// create blocks are uint32 size, uint8 visibility flags and the ReadCreate of every struct of the object,
+/// update blocks are uint32 size, uint32 changed type mask (1 << TYPEID_*) and the ReadUpdate of the changed structs.
+/// Output only depends on the scenario, the same seed always produces the same bytes.
+class UpdateTrafficGenerator
+{
+public:
+    explicit UpdateTrafficGenerator(TrafficScenario const& scenario);
+
+    /// Continues from existing objects, e.g. restored from a WorldSnapshot, instead of generating the scenario's.
+    UpdateTrafficGenerator(TrafficScenario const& scenario, std::vector<std::unique_ptr<ObjectValues>> objects);
+    ~UpdateTrafficGenerator();
+
+    UpdateTrafficGenerator(UpdateTrafficGenerator const&) = delete;
+    UpdateTrafficGenerator& operator=(UpdateTrafficGenerator const&) = delete;
+
+    uint32 GetObjectCount() const { return uint32(_objects.size()); }
+    std::vector<std::unique_ptr<ObjectValues>> const& GetObjects() const { return _objects; }
+
+    /// Appends a create block of every object.
+    void WriteCreates(ByteBuffer& packet, std::vector<GeneratedBlock>& blocks);
+
+    /// Appends update blocks of UpdateRatio of the objects, with new Health and Power values where their bits are set.
+    void WriteTick(ByteBuffer& packet, std::vector<GeneratedBlock>& blocks);
+
+private:
+    void AddObject(uint8 typeId, uint32 highGuid, uint32 entry);
+    void WriteCreate(ByteBuffer& packet, ObjectValues const& object, std::vector<GeneratedBlock>& blocks);
+    void WriteUpdate(ByteBuffer& packet, ObjectValues& object, std::vector<GeneratedBlock>& blocks);
+
+    /// Sets MaskDensity of the encodable bits of 'type' in mask, returns false when none was picked.
+    bool PickMask(UpdateFieldStruct type, uint32* mask);
+
+    TrafficScenario _scenario;
+    std::mt19937 _random;
+    std::vector<std::unique_ptr<ObjectValues>> _objects;
+};
+
+}
+
+#endif
@@ -0,0 +1,366 @@
+#include "WorldSnapshot.h"
+#include "DecodeDiff.h"
+#include "StatUpdateRecorder.h"
+#include "UpdateFieldsWriter.h"
+#include "UpdateObjectBatch.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <functional>
+
+namespace UF
+{
+
+namespace
+{
+    uint64 const RestoreTaskSize = 256;     // objects per pool task
+
+    inline uint16 StructBit(UpdateFieldStruct type)
+    {
+        return uint16(1 << uint32(type));
+    }
+
+    /// EncodeForDiff of every struct of 'object', in values block order.
+    void EncodeObjectForDiff(ByteBuffer& data, ObjectValues const& object)
+    {
+        EncodeForDiff(data, object.ObjectFields);
+        if (object.Item)
+            EncodeForDiff(data, *object.Item);
+        if (object.Container)
+            EncodeForDiff(data, *object.Container);
+        if (object.Unit)
+            EncodeForDiff(data, *object.Unit);
+        if (object.Player)
+            EncodeForDiff(data, *object.Player);
+        if (object.ActivePlayer)
+            EncodeForDiff(data, *object.ActivePlayer);
+        if (object.GameObject)
+            EncodeForDiff(data, *object.GameObject);
+        if (object.DynamicObject)
+            EncodeForDiff(data, *object.DynamicObject);
+        if (object.Corpse)
+            EncodeForDiff(data, *object.Corpse);
+        if (object.AreaTrigger)
+            EncodeForDiff(data, *object.AreaTrigger);
+        if (object.SceneObject)
+            EncodeForDiff(data, *object.SceneObject);
+        if (object.Conversation)
+            EncodeForDiff(data, *object.Conversation);
+    }
+}
+
+uint16 ObjectValues::GetStructMask() const
+{
+    uint16 mask = StructBit(UpdateFieldStruct::Object);
+    if (Item)
+        mask |= StructBit(UpdateFieldStruct::Item);
+    if (Container)
+        mask |= StructBit(UpdateFieldStruct::Container);
+    if (Unit)
+        mask |= StructBit(UpdateFieldStruct::Unit);
+    if (Player)
+        mask |= StructBit(UpdateFieldStruct::Player);
+    if (ActivePlayer)
+        mask |= StructBit(UpdateFieldStruct::ActivePlayer);
+    if (GameObject)
+        mask |= StructBit(UpdateFieldStruct::GameObject);
+    if (DynamicObject)
+        mask |= StructBit(UpdateFieldStruct::DynamicObject);
+    if (Corpse)
+        mask |= StructBit(UpdateFieldStruct::Corpse);
+    if (AreaTrigger)
+        mask |= StructBit(UpdateFieldStruct::AreaTrigger);
+    if (SceneObject)
+        mask |= StructBit(UpdateFieldStruct::SceneObject);
+    if (Conversation)
+        mask |= StructBit(UpdateFieldStruct::Conversation);
+    return mask;
+}
+
+void WriteObjectCreate(ByteBuffer& data, ObjectValues const& object, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags)
+{
+    WriteCreate(data, object.ObjectFields, fieldVisibilityFlags);
+    if (object.Item)
+        WriteCreate(data, *object.Item, fieldVisibilityFlags);
+    if (object.Container)
+        WriteCreate(data, *object.Container, fieldVisibilityFlags);
+    if (object.Unit)
+        WriteCreate(data, *object.Unit, fieldVisibilityFlags);
+    if (object.Player)
+        WriteCreate(data, *object.Player, fieldVisibilityFlags);
+    if (object.ActivePlayer)
+        WriteCreate(data, *object.ActivePlayer, fieldVisibilityFlags);
+    if (object.GameObject)
+        WriteCreate(data, *object.GameObject, fieldVisibilityFlags);
+    if (object.DynamicObject)
+        WriteCreate(data, *object.DynamicObject, fieldVisibilityFlags);
+    if (object.Corpse)
+        WriteCreate(data, *object.Corpse, fieldVisibilityFlags);
+    if (object.AreaTrigger)
+        WriteCreate(data, *object.AreaTrigger, fieldVisibilityFlags);
+    if (object.SceneObject)
+        WriteCreate(data, *object.SceneObject, fieldVisibilityFlags);
+    if (object.Conversation)
+        WriteCreate(data, *object.Conversation, fieldVisibilityFlags);
+}
+
+void ReadObjectCreate(ByteBuffer& data, ObjectValues& object, uint16 structMask, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update)
+{
+    object.ObjectFields.ReadCreate(data, fieldVisibilityFlags, update);
+    if (structMask & StructBit(UpdateFieldStruct::Item))
+    {
+        if (!object.Item)
+            object.Item.reset(new ItemData());
+        object.Item->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::Container))
+    {
+        if (!object.Container)
+            object.Container.reset(new ContainerData());
+        object.Container->ReadCreate(data, fieldVisibilityFlags, update);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::Unit))
+    {
+        if (!object.Unit)
+            object.Unit.reset(new UnitData());
+        object.Unit->ReadCreate(data, fieldVisibilityFlags, update);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::Player))
+    {
+        if (!object.Player)
+            object.Player.reset(new PlayerData());
+        object.Player->ReadCreate(data, fieldVisibilityFlags, update);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::ActivePlayer))
+    {
+        if (!object.ActivePlayer)
+            object.ActivePlayer.reset(new ActivePlayerData());
+        object.ActivePlayer->ReadCreate(data, fieldVisibilityFlags, update);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::GameObject))
+    {
+        if (!object.GameObject)
+            object.GameObject.reset(new GameObjectData());
+        object.GameObject->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::DynamicObject))
+    {
+        if (!object.DynamicObject)
+            object.DynamicObject.reset(new DynamicObjectData());
+        object.DynamicObject->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::Corpse))
+    {
+        if (!object.Corpse)
+            object.Corpse.reset(new CorpseData());
+        object.Corpse->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::AreaTrigger))
+    {
+        if (!object.AreaTrigger)
+            object.AreaTrigger.reset(new AreaTriggerData());
+        object.AreaTrigger->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::SceneObject))
+    {
+        if (!object.SceneObject)
+            object.SceneObject.reset(new SceneObjectData());
+        object.SceneObject->ReadCreate(data, fieldVisibilityFlags);
+    }
+    if (structMask & StructBit(UpdateFieldStruct::Conversation))
+    {
+        if (!object.Conversation)
+            object.Conversation.reset(new ConversationData());
+        object.Conversation->ReadCreate(data, fieldVisibilityFlags);
+    }
+}
+
+bool WorldSnapshotWriter::Open(std::string const& path, uint32 build, uint32 visibilityFlags, uint64 time)
+{
+    Close();
+    _file = fopen(path.c_str(), "wb");
+    if (!_file)
+        return false;
+
+    memset(&_header, 0, sizeof(_header));
+    memcpy(_header.Magic, "UFWS", 4);
+    _header.Version = SNAPSHOT_VERSION;
+    _header.Build = build;
+    _header.VisibilityFlags = visibilityFlags;
+    _header.Time = time;
+    _index.clear();
+    _offset = sizeof(_header);
+
+    // placeholder, rewritten by Close
+    return fwrite(&_header, sizeof(_header), 1, _file) == 1;
+}
+
+bool WorldSnapshotWriter::Write(ObjectValues const& object)
+{
+    if (!_file)
+        return false;
+
+    EnumFlag<UpdateFieldFlag> flags(static_cast<UpdateFieldFlag>(_header.VisibilityFlags));
+    _buffer.clear();
+    WriteObjectCreate(_buffer, object, flags);
+    if (fwrite(_buffer.contents(), _buffer.size(), 1, _file) != 1)
+        return false;
+
+    SnapshotIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.GuidLow = object.Guid._low;
+    entry.GuidHigh = object.Guid._high;
+    entry.Offset = _offset;
+    entry.Size = uint32(_buffer.size());
+    entry.Structs = object.GetStructMask();
+    entry.TypeId = object.TypeId;
+    _index.push_back(entry);
+    _offset += _buffer.size();
+    return true;
+}
+
+bool WorldSnapshotWriter::Close()
+{
+    if (!_file)
+        return false;
+
+    // the index is used in place by readers, keep it aligned
+    static uint8 const padding[alignof(SnapshotIndexEntry)] = { };
+    uint32 padSize = uint32((alignof(SnapshotIndexEntry) - _offset % alignof(SnapshotIndexEntry)) % alignof(SnapshotIndexEntry));
+    bool ok = !padSize || fwrite(padding, padSize, 1, _file) == 1;
+    _offset += padSize;
+
+    std::sort(_index.begin(), _index.end(), [](SnapshotIndexEntry const& left, SnapshotIndexEntry const& right)
+    {
+        return left.GuidHigh != right.GuidHigh ? left.GuidHigh < right.GuidHigh : left.GuidLow < right.GuidLow;
+    });
+
+    _header.ObjectCount = _index.size();
+    _header.IndexOffset = _offset;
+    ok = ok && (_index.empty() || fwrite(_index.data(), sizeof(SnapshotIndexEntry), _index.size(), _file) == _index.size())
+        && fseek(_file, 0, SEEK_SET) == 0
+        && fwrite(&_header, sizeof(_header), 1, _file) == 1;
+    ok = fclose(_file) == 0 && ok;
+    _file = nullptr;
+    _index.clear();
+    return ok;
+}
+
+bool WorldSnapshot::Open(std::string const& path)
+{
+    Close();
+    if (!_file.Open(path, MappedFile::ACCESS_RANDOM))
+        return false;
+
+    uint64 size = _file.GetSize();
+    if (size < sizeof(SnapshotHeader))
+    {
+        Close();
+        return false;
+    }
+
+    SnapshotHeader const& header = GetHeader();
+    if (memcmp(header.Magic, "UFWS", 4) != 0 || header.Version != SNAPSHOT_VERSION
+        || header.IndexOffset < sizeof(SnapshotHeader) || header.IndexOffset > size || header.ObjectCount > (size - header.IndexOffset) / sizeof(SnapshotIndexEntry)
+        || header.IndexOffset % alignof(SnapshotIndexEntry))
+    {
+        Close();
+        return false;
+    }
+
+    _index = reinterpret_cast<SnapshotIndexEntry const*>(_file.GetData() + header.IndexOffset);
+    _count = header.ObjectCount;
+    return true;
+}
+
+void WorldSnapshot::Close()
+{
+    _file.Close();
+    _index = nullptr;
+    _count = 0;
+}
+
+SnapshotIndexEntry const* WorldSnapshot::Find(ObjectGuid const& guid) const
+{
+    SnapshotIndexEntry const* end = _index + _count;
+    SnapshotIndexEntry const* itr = std::lower_bound(_index, end, guid, [](SnapshotIndexEntry const& entry, ObjectGuid const& key)
+    {
+        return entry.GuidHigh != key._high ? entry.GuidHigh < key._high : entry.GuidLow < key._low;
+    });
+    if (itr == end || itr->GuidHigh != guid._high || itr->GuidLow != guid._low)
+        return nullptr;
+    return itr;
+}
+
+bool WorldSnapshot::Restore(SnapshotIndexEntry const& entry, ObjectValues& object, IStatUpdate& update) const
+{
+    if (!IsValid(entry) || !entry.Size)
+        return false;
+
+    object.Guid._low = entry.GuidLow;
+    object.Guid._high = entry.GuidHigh;
+    object.TypeId = entry.TypeId;
+
+    EnumFlag<UpdateFieldFlag> flags(static_cast<UpdateFieldFlag>(GetHeader().VisibilityFlags));
+    ByteBuffer data;
+    data.append(GetPayload(entry), entry.Size);
+    try
+    {
+        ReadObjectCreate(data, object, entry.Structs, flags, update);
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+    return data.rpos() == data.size();
+}
+
+bool WorldSnapshot::Verify(ObjectValues const& object) const
+{
+    SnapshotIndexEntry const* entry = Find(object.Guid);
+    if (!entry || entry->TypeId != object.TypeId || entry->Structs != object.GetStructMask())
+        return false;
+
+    ObjectValues restored;
+    StatUpdateForwarder update;
+    if (!Restore(*entry, restored, update))
+        return false;
+
+    ByteBuffer expected;
+    ByteBuffer actual;
+    EncodeObjectForDiff(expected, object);
+    EncodeObjectForDiff(actual, restored);
+    expected.FlushBits();
+    actual.FlushBits();
+    return expected.size() == actual.size() && (!expected.size() || memcmp(expected.contents(), actual.contents(), expected.size()) == 0);
+}
+
+std::vector<std::unique_ptr<ObjectValues>> WorldSnapshot::RestoreAll(UpdateDecodePool* pool) const
+{
+    std::vector<std::unique_ptr<ObjectValues>> objects(_count);
+    auto restore = [this, &objects](uint64 first, uint64 last)
+    {
+        StatUpdateForwarder update;
+        for (uint64 i = first; i < last; ++i)
+        {
+            std::unique_ptr<ObjectValues> object(new ObjectValues());
+            if (Restore(_index[i], *object, update))
+                objects[i] = std::move(object);
+        }
+    };
+
+    if (pool && _count > RestoreTaskSize)
+    {
+        std::vector<std::function<void()>> tasks;
+        for (uint64 first = 0; first < _count; first += RestoreTaskSize)
+            tasks.push_back(std::bind(restore, first, std::min(first + RestoreTaskSize, _count)));
+        pool->Run(tasks);
+    }
+    else
+        restore(0, _count);
+
+    objects.erase(std::remove(objects.begin(), objects.end(), nullptr), objects.end());
+    return objects;
+}
+
+}
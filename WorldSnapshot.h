@@ -0,0 +1,152 @@
+#ifndef _WORLDSNAPSHOT_H
+#define _WORLDSNAPSHOT_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "MappedFile.h"
+#include "ObjectGuid.h"
+#include "UpdateFields.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace UF
+{
+
+class UpdateDecodePool;
+
+/// Decoded fields of one object, one struct per TypeID level of the object.
+struct ObjectValues
+{
+    ObjectGuid Guid;
+    uint8 TypeId = 0;
+    ObjectData ObjectFields;
+    std::unique_ptr<ItemData> Item;
+    std::unique_ptr<ContainerData> Container;
+    std::unique_ptr<UnitData> Unit;
+    std::unique_ptr<PlayerData> Player;
+    std::unique_ptr<ActivePlayerData> ActivePlayer;
+    std::unique_ptr<GameObjectData> GameObject;
+    std::unique_ptr<DynamicObjectData> DynamicObject;
+    std::unique_ptr<CorpseData> Corpse;
+    std::unique_ptr<AreaTriggerData> AreaTrigger;
+    std::unique_ptr<SceneObjectData> SceneObject;
+    std::unique_ptr<ConversationData> Conversation;
+
+    /// Bit (1 << UpdateFieldStruct) of every struct present.
+    uint16 GetStructMask() const;
+};
+
+/// Appends the ReadCreate of every struct of 'object' in values block order, without the block size and flags.
+void WriteObjectCreate(ByteBuffer& data, ObjectValues const& object, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags);
+
+/// Counterpart of WriteObjectCreate. Allocates the structs of 'structMask' that 'object' lacks.
+void ReadObjectCreate(ByteBuffer& data, ObjectValues& object, uint16 structMask, EnumFlag<UpdateFieldFlag> fieldVisibilityFlags, IStatUpdate& update);
+
+/// On disk snapshot of decoded objects, little endian:
+///   SnapshotHeader | object payloads, back to back | SnapshotIndexEntry[ObjectCount], sorted by guid
+/// Payloads are the create encoding of the objects' structs (see WriteObjectCreate), so the format only depends
+/// on the client build's field schema and not on the in memory layout of the UF structs.
+/// Every struct is stored. A restored object has the values the original was decoded to as long as the snapshot
+/// is written with the visibility flags the objects were decoded with; fields the decoders don't keep
+/// (unknowns, LogoutTime, ...) restore as 0. WorldSnapshot::Verify checks an object against its restored copy.
+struct SnapshotHeader
+{
+    char Magic[4];                  // "UFWS"
+    uint32 Version;
+    uint32 Build;                   // client build whose field schema the payloads use
+    uint32 VisibilityFlags;         // UpdateFieldFlag the payloads were encoded with
+    uint64 ObjectCount;
+    uint64 IndexOffset;
+    uint64 Time;                    // unix time in ms the snapshot was taken at
+};
+
+struct SnapshotIndexEntry
+{
+    uint64 GuidLow;
+    uint64 GuidHigh;
+    uint64 Offset;                  // payload offset from the start of the file
+    uint32 Size;
+    uint16 Structs;                 // ObjectValues::GetStructMask
+    uint8 TypeId;
+    uint8 Reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 40, "snapshot header layout");
+static_assert(sizeof(SnapshotIndexEntry) == 32, "snapshot index layout");
+
+uint32 const SNAPSHOT_VERSION = 2;
+
+/// Streams objects into a snapshot file.
+class WorldSnapshotWriter
+{
+public:
+    WorldSnapshotWriter() : _file(nullptr), _offset(0) { }
+    ~WorldSnapshotWriter() { Close(); }
+
+    WorldSnapshotWriter(WorldSnapshotWriter const&) = delete;
+    WorldSnapshotWriter& operator=(WorldSnapshotWriter const&) = delete;
+
+    bool Open(std::string const& path, uint32 build, uint32 visibilityFlags, uint64 time);
+    bool Write(ObjectValues const& object);
+
+    /// Sorts and appends the index and completes the header. Until then the file is not a valid snapshot.
+    bool Close();
+
+private:
+    FILE* _file;
+    uint64 _offset;
+    SnapshotHeader _header;
+    std::vector<SnapshotIndexEntry> _index;
+    ByteBuffer _buffer;
+};
+
+/// Read only mapping of a snapshot file. Objects are decoded on demand, Find is a binary search of the index.
+class WorldSnapshot
+{
+public:
+    WorldSnapshot() : _index(nullptr), _count(0) { }
+    ~WorldSnapshot() { Close(); }
+
+    WorldSnapshot(WorldSnapshot const&) = delete;
+    WorldSnapshot& operator=(WorldSnapshot const&) = delete;
+
+    /// Fails for files of another snapshot version; a build mismatch is left to the caller (see GetHeader).
+    bool Open(std::string const& path);
+    void Close();
+
+    bool IsOpen() const { return _file.IsOpen(); }
+    SnapshotHeader const& GetHeader() const { return *reinterpret_cast<SnapshotHeader const*>(_file.GetData()); }
+    uint64 GetObjectCount() const { return _count; }
+    SnapshotIndexEntry const& GetEntry(uint64 index) const { return _index[index]; }
+    uint8 const* GetPayload(SnapshotIndexEntry const& entry) const { return _file.GetData() + entry.Offset; }
+
+    bool IsValid(SnapshotIndexEntry const& entry) const
+    {
+        uint64 end = GetHeader().IndexOffset;
+        return entry.Offset <= end && entry.Size <= end - entry.Offset;
+    }
+
+    SnapshotIndexEntry const* Find(ObjectGuid const& guid) const;
+
+    /// Decodes one object. Returns false for entries pointing outside the file or payloads that don't decode
+    /// to exactly their size.
+    bool Restore(SnapshotIndexEntry const& entry, ObjectValues& object, IStatUpdate& update) const;
+
+    /// Restores the entry of 'object' and compares it with 'object': same TypeID and structs, and the same
+    /// create encoding of every struct with all visibility flags. False when the object is missing or differs.
+    bool Verify(ObjectValues const& object) const;
+
+    /// Decodes every object, in index order, on 'pool' when given. Invalid entries are skipped.
+    std::vector<std::unique_ptr<ObjectValues>> RestoreAll(UpdateDecodePool* pool = nullptr) const;
+
+private:
+    MappedFile _file;
+    SnapshotIndexEntry const* _index;
+    uint64 _count;
+};
+
+}
+
+#endif